@@ -0,0 +1,312 @@
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include "protocol/lzss.hpp"
+#include "protocol/packet.hpp"
+#include "protocol/sender.hpp"
+#include "rpc/endian.hpp"
+#include "rpc/serializer.hpp"
+#include "rpc/timeseries.hpp"
+
+/**
+ * Бенчмарк кодирования целых чисел: Encoding::Fixed против Encoding::Compact
+ *
+ * Для типичных распределений значений (счетчики, показания датчиков,
+ *       отметки времени) измеряет средний размер значения в кадре и время
+ *       кодирования и декодирования одного значения
+ * Compact выгоден на малых по модулю значениях и проигрывает по размеру
+ *       на равномерно распределенных 32-битных
+ * Показания датчика в float сравниваются с плотными форматами Half и
+ *       Quantized (packing.hpp)
+ * Поток выборок датчика: кадр на каждую выборку против блоков
+ *       TimeSeriesEncoder - байт в канале на выборку и выборок в секунду
+ *       через UART 115200
+ * Сжатие кадров LZSS (lzss.hpp) на строках лога, блоке конфигурации и
+ *       случайных данных: байт в канале на кадр и время сжатия и распаковки
+ * Отдельно - массовое копирование массивов в кадр: memcpy (little-endian
+ *       узел) против перестановки байт, которую выполнял бы big-endian узел
+ *
+ * rpc_codec_bench [--values N]
+ */
+
+namespace {
+
+// Защита измеряемого цикла от удаления оптимизатором
+volatile std::uint64_t g_sink = 0;
+
+template<typename Codec, typename T>
+void measure(const char* label, const std::vector<T>& values) {
+    std::vector<std::uint8_t> buffer(values.size() * (sizeof(T) + 2));
+
+    auto start = std::chrono::steady_clock::now();
+    std::uint8_t* out = buffer.data();
+    for (const T& value : values) {
+        out = Codec::serialize(value, out);
+    }
+    double encode_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::size_t bytes = static_cast<std::size_t>(out - buffer.data());
+
+    start = std::chrono::steady_clock::now();
+    const std::uint8_t* in = buffer.data();
+    const std::uint8_t* end = buffer.data() + bytes;
+    std::uint64_t sum = 0;
+    std::size_t decoded = 0;
+    while (in < end) {
+        T value{};
+        std::size_t length = rpc::Codec<T>::MinSize;
+        if constexpr (Codec::encoding == rpc::Encoding::Compact) {
+            length = 1;
+            while (in[length - 1] & 0x80) {                     // Длина varint по флагам продолжения
+                ++length;
+            }
+        }
+        if (!Codec::deserialize(in, length, value)) {
+            break;
+        }
+        sum += static_cast<std::uint64_t>(static_cast<std::int64_t>(value));
+        in += length;
+        ++decoded;
+    }
+    double decode_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    g_sink = g_sink + sum;
+
+    double count = static_cast<double>(values.size());
+    std::printf("  %-8s %5.2f bytes/value  encode %6.2f ns  decode %6.2f ns%s\n", label,
+                static_cast<double>(bytes) / count, encode_s * 1e9 / count, decode_s * 1e9 / count,
+                decoded == values.size() ? "" : "  (decode mismatch)");
+}
+
+template<typename T>
+void compare(const char* name, const std::vector<T>& values) {
+    std::printf("%s\n", name);
+    measure<rpc::Serializer>("fixed", values);
+    measure<rpc::CompactSerializer>("compact", values);
+}
+
+// float против Half и Quantized: размер и время преобразования (encode - с квантованием)
+void dense(const char* name, const std::vector<float>& values) {
+    std::printf("%s\n", name);
+    measure<rpc::Serializer>("float", values);
+    measure<rpc::Serializer>("half", std::vector<rpc::Half>(values.begin(), values.end()));
+    measure<rpc::Serializer>("q16", std::vector<rpc::Quantized<-40, 125>>(values.begin(), values.end()));
+    measure<rpc::Serializer>("q8", std::vector<rpc::Quantized<-40, 125, std::uint8_t>>(values.begin(), values.end()));
+}
+
+// Выборки датчика температуры: отметки каждые 10 мс с редким дрожанием, 12-битный АЦП (-40..125) с шумом
+std::vector<rpc::Sample> sensor_samples(std::size_t count) {
+    std::mt19937 generator(42);
+    std::normal_distribution<double> noise(0.0, 1.0);
+    std::uniform_int_distribution<int> jitter(0, 99);
+    std::vector<rpc::Sample> samples(count);
+    std::uint32_t timestamp = 1000000;
+    for (std::size_t i = 0; i < count; ++i) {
+        timestamp += 10 + (jitter(generator) == 0 ? 1 : 0);
+        double celsius = 25.0 + 5.0 * std::sin(static_cast<double>(i) * 1e-3);
+        long adc = std::lround((celsius + 40.0) / 165.0 * 4095.0 + noise(generator));
+        samples[i] = {timestamp, static_cast<float>(adc) * (165.0f / 4095.0f) - 40.0f};
+    }
+    return samples;
+}
+
+// Кадр на выборку (Stream name(float)) против блоков TimeSeriesEncoder
+void series(std::size_t count) {
+    const std::string name = "temperature";
+    const std::size_t framing = protocol::Frame::HeaderSize + protocol::Frame::TrailerSize + name.size() + 3 + rpc::SignatureSize;
+    std::vector<rpc::Sample> samples = sensor_samples(count);
+
+    std::vector<std::vector<std::uint8_t>> blocks;
+    std::vector<std::size_t> block_counts;
+    std::size_t block_wire = 0;
+    rpc::TimeSeriesEncoder encoder(rpc::TimeSeriesEncoder::capacity_for(name.size()));
+    auto flush = [&] {
+        rpc::TimeSeriesBlock block = encoder.block();
+        block_wire += framing + rpc::Codec<rpc::TimeSeriesBlock>::size(block);
+        blocks.emplace_back(block.data(), block.data() + block.length());
+        block_counts.push_back(block.count());
+        encoder.reset();
+    };
+    auto start = std::chrono::steady_clock::now();
+    for (const rpc::Sample& sample : samples) {
+        if (!encoder.append(sample.timestamp, sample.value)) {
+            flush();
+            encoder.append(sample.timestamp, sample.value);
+        }
+    }
+    flush();
+    double encode_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    std::size_t decoded = 0;
+    bool lossless = true;
+    for (std::size_t i = 0; i < blocks.size(); ++i) {
+        rpc::TimeSeriesDecoder decoder(rpc::TimeSeriesBlock(blocks[i].data(), blocks[i].size(), block_counts[i]));
+        rpc::Sample sample{};
+        while (decoder.next(sample)) {
+            lossless = lossless && decoded < count && sample.timestamp == samples[decoded].timestamp
+                       && std::memcmp(&sample.value, &samples[decoded].value, sizeof(float)) == 0;
+            ++decoded;
+        }
+    }
+    double decode_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    constexpr double UartBytesPerSecond = 115200.0 / 10;                        // 8N1
+    double single = static_cast<double>(framing + sizeof(float));
+    double packed = static_cast<double>(block_wire) / static_cast<double>(count);
+    std::printf("sensor stream \"%s\", %zu samples\n", name.c_str(), count);
+    std::printf("  frame per sample  %6.2f bytes/sample  %7.0f samples/s at 115200\n", single, UartBytesPerSecond / single);
+    std::printf("  blocks            %6.2f bytes/sample  %7.0f samples/s at 115200  (%.1fx, %.1f samples/block)\n",
+                packed, UartBytesPerSecond / packed, single / packed,
+                static_cast<double>(count) / static_cast<double>(blocks.size()));
+    std::printf("  encode %.2f ns/sample  decode %.2f ns/sample%s\n", encode_s * 1e9 / static_cast<double>(count),
+                decode_s * 1e9 / static_cast<double>(count), lossless && decoded == count ? "" : "  (decode mismatch)");
+}
+
+// Сжатие полезных данных кадров размера Packet::MaxSize, нарезанных из text
+void frames(const char* name, const std::string& text, std::size_t count) {
+    constexpr std::size_t Size = protocol::Packet::MaxSize;
+    std::size_t chunks = text.size() / Size;
+    std::size_t rounds = count / Size + 1;
+    std::size_t wire = 0;
+    std::size_t raw = 0;
+    std::size_t mismatches = 0;
+    std::uint8_t packed[Size];
+    std::uint8_t unpacked[Size];
+    double compress_s = 0.0;
+    double decompress_s = 0.0;
+    for (std::size_t i = 0; i < rounds; ++i) {
+        const auto* chunk = reinterpret_cast<const std::uint8_t*>(text.data() + (i % chunks) * Size);
+        auto start = std::chrono::steady_clock::now();
+        std::size_t length = protocol::Lzss::compress(chunk, Size, packed, Size - 1);
+        compress_s += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        raw += Size;
+        if (length == 0) {
+            wire += Size;                                                       // Кадр уходит несжатым
+            continue;
+        }
+        wire += length;
+        start = std::chrono::steady_clock::now();
+        protocol::LzssDecoder decoder;
+        decoder.reset(unpacked, Size);
+        for (std::size_t j = 0; j < length; ++j) {
+            decoder.feed(packed[j]);
+        }
+        decompress_s += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (decoder.failed() || decoder.length() != Size || std::memcmp(unpacked, chunk, Size) != 0) {
+            ++mismatches;
+        }
+    }
+    double frames_count = static_cast<double>(rounds);
+    std::printf("%s, %zu-byte frames\n  %6.2f bytes/frame (%.2fx)  compress %7.0f ns  decompress %6.0f ns%s\n", name, Size,
+                static_cast<double>(wire) / frames_count, static_cast<double>(raw) / static_cast<double>(wire),
+                compress_s * 1e9 / frames_count, decompress_s * 1e9 / frames_count, mismatches == 0 ? "" : "  (decode mismatch)");
+}
+
+// Строки лога устройства: общий формат, меняются время и показания
+std::string log_text(std::size_t lines) {
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<int> level(0, 9);
+    std::uniform_int_distribution<int> reading(200, 300);
+    std::string text;
+    char line[96];
+    for (std::size_t i = 0; i < lines; ++i) {
+        const char* tag = level(generator) == 0 ? "W" : "I";
+        std::snprintf(line, sizeof(line), "[%08zu] %s sensor: temp=%d.%d C adc=%04d\n", 1000 + i * 10, tag,
+                      reading(generator) / 10, reading(generator) % 10, reading(generator) * 13);
+        text += line;
+    }
+    return text;
+}
+
+// Блок конфигурации: ключ=значение, выровненный пробелами
+std::string config_text() {
+    std::string text;
+    char line[96];
+    for (int i = 0; i < 64; ++i) {
+        std::snprintf(line, sizeof(line), "channel.%02d.gain      = %-6d\nchannel.%02d.enabled   = %s\n", i, 100 + i % 7,
+                      i, i % 3 == 0 ? "false" : "true ");
+        text += line;
+    }
+    return text;
+}
+
+std::string random_text(std::size_t length) {
+    std::mt19937 generator(42);
+    std::string text(length, '\0');
+    for (char& c : text) {
+        c = static_cast<char>(generator());
+    }
+    return text;
+}
+
+// Копирование массивов кадрового размера: memcpy против перестановки байт (rpc::swap_bytes)
+template<typename T>
+void bulk(const char* name, std::size_t count) {
+    constexpr std::size_t Elements = protocol::Packet::MaxSize / sizeof(T);
+    std::vector<std::uint8_t> source(Elements * sizeof(T), 0x5A);
+    std::vector<std::uint8_t> frame(source.size());
+    std::size_t rounds = count / Elements + 1;
+
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < rounds; ++i) {
+        source[0] = static_cast<std::uint8_t>(i);
+        std::memcpy(frame.data(), source.data(), source.size());
+        g_sink = g_sink + frame[i % frame.size()];
+    }
+    double copy_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < rounds; ++i) {
+        source[0] = static_cast<std::uint8_t>(i);
+        rpc::swap_bytes<T>(frame.data(), source.data(), Elements);
+        g_sink = g_sink + frame[i % frame.size()];
+    }
+    double swap_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    double elements = static_cast<double>(rounds * Elements);
+    std::printf("%s[%zu]\n  memcpy   %6.3f ns/element\n  swap     %6.3f ns/element\n",
+                name, Elements, copy_s * 1e9 / elements, swap_s * 1e9 / elements);
+}
+
+template<typename T, typename Distribution>
+std::vector<T> generate(std::size_t count, Distribution distribution) {
+    std::mt19937 generator(42);
+    std::vector<T> values(count);
+    for (T& value : values) {
+        value = static_cast<T>(distribution(generator));
+    }
+    return values;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::size_t count = 1 << 20;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--values") == 0 && i + 1 < argc) {
+            count = std::strtoul(argv[++i], nullptr, 10);
+        }
+    }
+    std::printf("%zu values per distribution\n", count);
+
+    compare("uint32_t counters 0..100", generate<std::uint32_t>(count, std::uniform_int_distribution<std::uint32_t>(0, 100)));
+    compare("int16_t sensor values +-2000", generate<std::int16_t>(count, std::normal_distribution<double>(0.0, 700.0)));
+    compare("int32_t small deltas -64..63", generate<std::int32_t>(count, std::uniform_int_distribution<std::int32_t>(-64, 63)));
+    compare("uint32_t timestamps (ms uptime)",
+            generate<std::uint32_t>(count, std::uniform_int_distribution<std::uint32_t>(1u << 24, 1u << 31)));
+    compare("int32_t uniform", generate<std::int32_t>(count, std::uniform_int_distribution<std::int32_t>(INT32_MIN, INT32_MAX)));
+    dense("float temperature readings -40..125", generate<float>(count, std::normal_distribution<double>(25.0, 15.0)));
+    series(count);
+    frames("log lines", log_text(1024), count);
+    frames("configuration blob", config_text(), count);
+    frames("random bytes", random_text(8192), count);
+    bulk<std::uint16_t>("uint16_t", count);
+    bulk<float>("float", count);
+    bulk<double>("double", count);
+    return 0;
+}
@@ -0,0 +1,286 @@
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "device_host.hpp"
+#include "host/client.hpp"
+#include "host/event_loop.hpp"
+#include "host/loopback.hpp"
+#include "host/serial_port.hpp"
+#include "host/task.hpp"
+#include "protocol/parser.hpp"
+#include "protocol/sender.hpp"
+#include "rpc/serializer.hpp"
+#include "rpc/signature.hpp"
+#include "rpc/timeseries.hpp"
+
+/**
+ * Бенчмарк хостового клиента: пропускная способность конвейера вызовов
+ *
+ * Сервер в памяти (тот же Parser/Sender/Serializer, что в прошивке) обслуживает
+ *       "add" и "get_temperature"; клиент запускает calls логических вызовов
+ *       корутинами и измеряет вызовов в секунду для разных размеров окна
+ * "get_temperature" отдается как CachedResponse до Invalidate - отдельный
+ *       замер показывает чтение из кэша клиента
+ * Последний замер - поток выборок "temperature" блоками Stream-сообщений
+ *       (как rpc::SampleStream), принятый через subscribe_series
+ *
+ * rpc_host_bench [--calls N] [--latency-us N] [--corrupt N] [--compact] [--compress] [--idl] [--pty]
+ *     --latency-us Задержка доставки кадра в loopback канале (имитация линии)
+ *     --corrupt    Порча каждого N-го запроса: сервер отвечает Nack, клиент
+ *                  повторяет запрос сразу, без ожидания таймаута
+ *     --compact    Аргументы и результаты в Encoding::Compact (varint)
+ *     --compress   Согласование сжатия кадров (Hello) перед замерами: кадры
+ *                  не короче порога сжимаются, если это их сокращает
+ *     --idl        Вызовы через прокси из idl/device.rpc (по идентификатору)
+ *     --pty        Канал через псевдотерминал вместо памяти
+ */
+
+namespace {
+
+// Минимальный сервер: отвечает на Request в формате Service (в кодировании запроса)
+class LoopbackServer {
+public:
+    explicit LoopbackServer(drivers::Serial& serial) : m_parser(serial, on_packet, this), m_sender(serial) {}
+
+    // Отправка выборок блоками: Stream | seq | name\0 | signature | block; возвращает число кадров
+    std::size_t stream(const std::string& name, const std::vector<rpc::Sample>& samples) {
+        rpc::TimeSeriesEncoder encoder(rpc::TimeSeriesEncoder::capacity_for(name.size()));
+        std::size_t frames = 0;
+        auto flush = [&] {
+            std::uint8_t payload[protocol::Packet::MaxSize];
+            payload[0] = static_cast<std::uint8_t>(rpc::MessageType::Stream);
+            payload[1] = m_stream_seq;
+            std::memcpy(payload + 2, name.c_str(), name.size() + 1);
+            std::uint8_t* end = rpc::write_signature(payload + name.size() + 3, rpc::signature_of<void, rpc::TimeSeriesBlock>());
+            end = rpc::Serializer::serialize(encoder.block(), end);
+            m_sender.send_transport(payload, static_cast<std::size_t>(end - payload), m_stream_seq++, rpc::MessageType::Stream);
+            encoder.reset();
+            ++frames;
+        };
+        for (const rpc::Sample& sample : samples) {
+            if (!encoder.append(sample.timestamp, sample.value)) {
+                flush();
+                encoder.append(sample.timestamp, sample.value);
+            }
+        }
+        if (!encoder.empty()) {
+            flush();
+        }
+        return frames;
+    }
+
+private:
+    static void on_packet(const protocol::Packet& packet, void* user_data) {
+        auto* server = static_cast<LoopbackServer*>(user_data);
+        if (packet.data_length < 3 || packet.type != rpc::MessageType::Request) {
+            return;
+        }
+        const char* name = reinterpret_cast<const char*>(packet.data + 2);
+        std::size_t name_length = strnlen(name, packet.data_length - 2);
+        std::size_t target_length = name_length + 1;            // name\0 или \0 | id
+        std::uint16_t id = 0;
+        if (name_length == 0 && packet.data_length >= 2 + rpc::Target::IdSize) {
+            rpc::load_le(packet.data + 3, id);
+            target_length = rpc::Target::IdSize;
+        }
+        std::size_t header_length = target_length + 2 + rpc::SignatureSize;
+        if (packet.data_length < header_length) {
+            return;
+        }
+        const std::uint8_t* args = packet.data + header_length;
+        const std::uint8_t* signature = packet.data + target_length + 2;
+        std::uint8_t response[protocol::Packet::MaxSize];
+        std::memcpy(response, packet.data, name_length + 3);  // Ответ: type | seq | name\0 | result (по идентификатору - без имени)
+        response[0] = static_cast<std::uint8_t>(rpc::MessageType::Response);
+        std::size_t length = name_length + 3;
+        rpc::ErrorCode reason = rpc::ErrorCode::UnknownFunction;
+        bool is_add = id == 0 ? std::strcmp(name, "add") == 0 : id == device::Add::id.id;
+        bool is_temperature = id == 0 ? std::strcmp(name, "get_temperature") == 0 : id == device::GetTemperature::id.id;
+        if ((is_add && !rpc::signature_matches(signature, device::Add::signature))
+            || (is_temperature && !rpc::signature_matches(signature, device::GetTemperature::signature))) {
+            is_add = is_temperature = false;
+            reason = rpc::ErrorCode::SignatureMismatch;
+        }
+        std::tuple<std::int32_t, std::int32_t> add_args;
+        bool add = is_add && rpc::visit_encoding(packet.encoding, [&](auto serializer) {
+            return decltype(serializer)::deserialize_tuple(args, packet.data_length - header_length, add_args);
+        });
+        if (add) {
+            length += rpc::visit_encoding(packet.encoding, [&](auto serializer) {
+                std::int32_t sum = std::get<0>(add_args) + std::get<1>(add_args);
+                decltype(serializer)::serialize(sum, response + length);
+                return decltype(serializer)::size_of(sum);
+            });
+        } else if (is_temperature) {
+            response[0] = static_cast<std::uint8_t>(rpc::MessageType::CachedResponse);
+            response[length++] = rpc::UntilInvalidated & 0xFF;
+            response[length++] = rpc::UntilInvalidated >> 8;
+            rpc::Serializer::serialize<float>(23.5f, response + length);
+            length += sizeof(float);
+        } else {
+            if (is_add) {
+                reason = rpc::ErrorCode::BadArguments;          // Длина аргументов не совпадает с (int32_t, int32_t)
+            }
+            response[0] = static_cast<std::uint8_t>(rpc::MessageType::Error);
+            response[2] = static_cast<std::uint8_t>(reason);    // Error | seq | reason
+            length = 3;
+        }
+        if (packet.encoding == rpc::Encoding::Compact && length > 3) {
+            response[0] |= rpc::CompactFlag;                    // Результат в том же кодировании, что аргументы
+        }
+        server->m_sender.send_transport(response, length, packet.seq, static_cast<rpc::MessageType>(response[0]));
+    }
+
+    protocol::Parser m_parser;
+    protocol::Sender m_sender;
+    std::uint8_t m_stream_seq{0};
+};
+
+struct Result {
+    std::size_t ok{0};
+    std::size_t failed{0};
+};
+
+host::Task<void> worker(host::Client& client, std::int32_t i, Result& result, std::size_t& remaining,
+                        host::EventLoop& loop, bool idl) {
+    auto reply = idl ? co_await device::HostProxy(client).add(i, 1) : co_await client.call<std::int32_t>("add", i, 1);
+    if (reply.ok() && reply.value == i + 1) {
+        ++result.ok;
+    } else {
+        ++result.failed;
+    }
+    if (--remaining == 0) {
+        loop.stop();
+    }
+}
+
+// Последовательные чтения кэшируемого значения: первое идет на сервер, остальные - из кэша
+host::Task<void> poll_temperature(host::Client& client, std::size_t calls, host::EventLoop& loop, bool idl) {
+    auto start = std::chrono::steady_clock::now();
+    std::size_t ok = 0;
+    for (std::size_t i = 0; i < calls; ++i) {
+        auto reply = idl ? co_await device::HostProxy(client).get_temperature() : co_await client.call<float>("get_temperature");
+        ok += reply.ok() ? 1 : 0;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("cached get_temperature: %.3f us/call  (%zu ok, %llu hits, %llu misses)\n",
+                seconds * 1e6 / static_cast<double>(calls), ok,
+                static_cast<unsigned long long>(client.cache_stats().hits),
+                static_cast<unsigned long long>(client.cache_stats().misses));
+    loop.stop();
+}
+
+// Поток выборок: сервер отправляет блоки, клиент разворачивает их в выборки
+void stream_samples(host::EventLoop& loop, host::Client& client, LoopbackServer& server, std::size_t count) {
+    std::vector<rpc::Sample> samples(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        samples[i] = {static_cast<std::uint32_t>(1000 + i * 10),
+                      std::round((25.0f + 5.0f * std::sin(static_cast<float>(i) * 1e-2f)) * 16.0f) / 16.0f};   // Шаг 1/16 °C
+    }
+    std::size_t received = 0;
+    bool lossless = true;
+    client.subscribe_series("temperature", [&](const rpc::Sample& sample) {
+        lossless = lossless && received < count && sample.timestamp == samples[received].timestamp
+                   && sample.value == samples[received].value;
+        if (++received == count) {
+            loop.stop();
+        }
+    });
+    auto timeout = loop.schedule(host::EventLoop::Clock::now() + std::chrono::seconds{5}, [&loop] { loop.stop(); });
+    auto start = std::chrono::steady_clock::now();
+    std::size_t frames = server.stream("temperature", samples);
+    loop.run();
+    loop.cancel(timeout);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("sample stream: %zu samples in %zu frames (%.1f per frame), %.0f samples/s%s\n", received, frames,
+                static_cast<double>(count) / static_cast<double>(frames), static_cast<double>(received) / seconds,
+                lossless && received == count ? "" : "  (decode mismatch)");
+}
+
+void run(host::EventLoop& loop, host::Client& client, std::size_t window, std::size_t calls, bool idl) {
+    client.set_window(window);
+    Result result;
+    std::size_t remaining = calls;
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < calls; ++i) {
+        host::spawn(worker(client, static_cast<std::int32_t>(i), result, remaining, loop, idl));
+    }
+    loop.run();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("window %3zu: %8.0f calls/s  (%zu ok, %zu failed, %.3f s)\n",
+                window, static_cast<double>(calls) / seconds, result.ok, result.failed, seconds);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::size_t calls = 4096;
+    long latency_us = 0;
+    std::size_t corrupt = 0;
+    bool use_pty = false;
+    bool compact = false;
+    bool compress = false;
+    bool idl = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--calls") == 0 && i + 1 < argc) {
+            calls = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--latency-us") == 0 && i + 1 < argc) {
+            latency_us = std::strtol(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--corrupt") == 0 && i + 1 < argc) {
+            corrupt = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--compact") == 0) {
+            compact = true;
+        } else if (std::strcmp(argv[i], "--compress") == 0) {
+            compress = true;
+        } else if (std::strcmp(argv[i], "--idl") == 0) {
+            idl = true;
+        } else if (std::strcmp(argv[i], "--pty") == 0) {
+            use_pty = true;
+        }
+    }
+
+    host::EventLoop loop;
+    const std::size_t windows[] = {1, 8, 64, 256};
+    if (use_pty) {
+        std::string slave_path;
+        int master = host::SerialPort::open_pty(slave_path);
+        host::SerialPort server_port(loop);
+        host::SerialPort client_port(loop);
+        if (master < 0 || !server_port.attach(master) || !client_port.open(slave_path)) {
+            std::fprintf(stderr, "pty unavailable\n");
+            return 1;
+        }
+        LoopbackServer server(server_port);
+        host::Client client(loop, client_port);
+        client.set_encoding(compact ? rpc::Encoding::Compact : rpc::Encoding::Fixed);
+        std::printf("pty %s, %zu calls\n", slave_path.c_str(), calls);
+        for (std::size_t window : windows) {
+            run(loop, client, window, calls, idl);
+        }
+        return 0;
+    }
+
+    host::LoopbackLink link(loop, std::chrono::microseconds{latency_us});
+    link.set_corruption(corrupt);
+    LoopbackServer server(link.b());
+    host::Client client(loop, link.a());
+    client.set_encoding(compact ? rpc::Encoding::Compact : rpc::Encoding::Fixed);
+    if (compress) {
+        client.negotiate();                                     // Ответ сервера принимается в первом замере
+    }
+    std::printf("loopback, latency %ld us, corrupt 1/%zu, %s%s%s, %zu calls\n", latency_us, corrupt,
+                compact ? "compact" : "fixed", compress ? ", compressed" : "", idl ? ", by id" : "", calls);
+    for (std::size_t window : windows) {
+        run(loop, client, window, calls, idl);
+    }
+    host::spawn(poll_temperature(client, calls, loop, idl));
+    loop.run();
+    stream_samples(loop, client, server, calls);
+    return 0;
+}
@@ -0,0 +1,313 @@
+#pragma once
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "drivers/serial.hpp"
+#include "protocol/packet.hpp"
+#include "protocol/parser.hpp"
+#include "protocol/sender.hpp"
+#include "rpc/method.hpp"
+#include "rpc/serializer.hpp"
+#include "rpc/signature.hpp"
+#include "rpc/timeseries.hpp"
+#include "rpc/types.hpp"
+#include "utils/noncopyable.hpp"
+#include "event_loop.hpp"
+#include "task.hpp"
+
+namespace host {
+
+// Результат вызова: статус и значение (значение по умолчанию при ошибке)
+// error - причина из ответа Error | seq | reason (Unknown при других исходах)
+template<typename Result>
+struct Reply {
+    rpc::CallStatus status{rpc::CallStatus::Pending};
+    rpc::ErrorCode error{rpc::ErrorCode::Unknown};
+    Result value{};
+    bool ok() const { return status == rpc::CallStatus::Ok; }
+};
+
+template<>
+struct Reply<void> {
+    rpc::CallStatus status{rpc::CallStatus::Pending};
+    rpc::ErrorCode error{rpc::ErrorCode::Unknown};
+    bool ok() const { return status == rpc::CallStatus::Ok; }
+};
+
+// Счетчики кэша результатов клиента
+struct CacheStats {
+    std::uint64_t hits{0};              // Ответ выдан из кэша без обращения к устройству
+    std::uint64_t misses{0};            // Вызов кэшируемой функции ушел на устройство
+    std::uint64_t invalidations{0};     // Принято сообщений Invalidate
+};
+
+/**
+ * Хостовый RPC клиент на корутинах C++20
+ *
+ * Использует те же Serializer, Sender и Parser, что и прошивка, поэтому
+ *       формат кадров гарантированно совпадает
+ * Запросы конвейеризуются: до window() вызовов одновременно ждут ответа,
+ *       ответы сопоставляются по seq в таблице на 256 записей; остальные
+ *       вызовы ждут свободного места без блокировки потока
+ *
+ * Результаты функций, которые сервер отдает как CachedResponse, кэшируются
+ *       по (имя, сериализованные аргументы) на объявленный сервером срок или
+ *       до сообщения Invalidate - повторное чтение не выходит в канал
+ *
+ * Кадр каждого ожидающего запроса хранится в таблице: на Nack устройства
+ *       (запрос принят поврежденным) он сразу отправляется повторно
+ *
+ * set_encoding включает Encoding::Compact (varint) для канала или функции;
+ *       результат декодируется по флагу CompactFlag ответа
+ *
+ * Stream-сообщения устройства доставляются подписчикам по имени; блоки
+ *       выборок rpc::SampleStream разворачивает subscribe_series
+ *
+ * Все методы вызываются из потока цикла событий
+ *
+ * Пример:
+ *     host::EventLoop loop;
+ *     host::SerialPort port(loop);
+ *     port.open("/dev/ttyACM0");
+ *     host::Client client(loop, port);
+ *     host::spawn([&]() -> host::Task<> {
+ *         auto sum = co_await client.call<int32_t>("add", 1, 2);
+ *         if (sum.ok()) { ... }
+ *         loop.stop();
+ *     }());
+ *     loop.run();
+ */
+
+class Client : private utils::NonCopyable {
+public:
+    // Размер таблицы ожидающих вызовов (все значения seq)
+    static constexpr std::size_t MaxPendingCalls = 256;
+
+    Client(EventLoop& loop, drivers::Serial& serial,
+           std::chrono::milliseconds timeout = std::chrono::milliseconds{1000});
+
+    // Максимальное число одновременно ожидающих ответа вызовов (1..MaxPendingCalls)
+    void set_window(std::size_t window);
+    std::size_t window() const { return m_window; }
+    // Число вызовов, ожидающих ответа
+    std::size_t in_flight() const { return m_in_flight; }
+    // Согласование возможностей канала с устройством (сжатие кадров); вызывается после открытия порта
+    bool negotiate() { return m_parser.negotiate(); }
+
+    // Статистика кэша результатов
+    const CacheStats& cache_stats() const { return m_cache_stats; }
+    // Очистка кэша результатов
+    void clear_cache() { m_cache.clear(); }
+
+    // Обработчик Stream-сообщения: аргументы сообщения (после имени и отпечатка сигнатуры)
+    using StreamHandler = std::function<void(const std::uint8_t* args, std::size_t length)>;
+    // Подписка на Stream-сообщения с именем name (повторная подписка заменяет обработчик)
+    void subscribe(const std::string& name, StreamHandler handler) { m_subscribers[name] = std::move(handler); }
+    // Подписка на блоки выборок (rpc::SampleStream): handler вызывается для каждой выборки по порядку
+    void subscribe_series(const std::string& name, std::function<void(const rpc::Sample&)> handler);
+
+    // Кодирование аргументов по умолчанию для всех функций
+    void set_encoding(rpc::Encoding encoding) { m_encoding = encoding; }
+    // Кодирование аргументов одной функции (перекрывает кодирование канала)
+    void set_encoding(const std::string& name, rpc::Encoding encoding) { m_method_encoding[name] = encoding; }
+
+    // Вызов удаленной функции; результат - после получения ответа или таймаута
+    template<typename Result, typename... Args>
+    Task<Reply<Result>> call(std::string name, Args... args) {
+        return call_target<Result>(std::move(name), std::nullopt, std::move(args)...);
+    }
+
+    // Вызов функции из IDL по идентификатору (ответ приходит с пустым именем)
+    template<typename Result, typename... Args>
+    Task<Reply<Result>> call(rpc::MethodId method, Args... args) {
+        return call_target<Result>(method.name, method.id, std::move(args)...);
+    }
+
+private:
+    // Вызов по имени или идентификатору: имя живет в кадре корутины, пока вызов не завершен
+    template<typename Result, typename... Args>
+    Task<Reply<Result>> call_target(std::string name, std::optional<std::uint16_t> id, Args... args) {
+        rpc::Target target = id ? rpc::Target(rpc::MethodId{*id, name.c_str()}) : rpc::Target(name);
+        Reply<Result> reply;
+        std::uint8_t request[protocol::Packet::MaxSize];
+        std::size_t length = rpc::visit_encoding(encoding_for(name), [&](auto serializer) {
+            using Codec = decltype(serializer);
+            std::size_t header_length = 2 + target.size() + rpc::SignatureSize;       // type | seq | name\0 | signature
+            std::size_t request_length = header_length + Codec::size_of_values(args...);
+            if (request_length <= protocol::Packet::MaxSize) {
+                request[0] = static_cast<std::uint8_t>(rpc::MessageType::Request);
+                if (Codec::encoding == rpc::Encoding::Compact) {
+                    request[0] |= rpc::CompactFlag;
+                }
+                rpc::write_signature(target.write(request + 2), rpc::signature_of<Result, Args...>());
+                Codec::serialize_values(request + header_length, args...);
+            }
+            return request_length;
+        });
+        if (length > protocol::Packet::MaxSize) {
+            reply.status = rpc::CallStatus::Error;              // Запрос не помещается в кадр
+            co_return reply;
+        }
+        std::string key;                                        // name\0 | signature | args... (и для вызова по идентификатору)
+        bool known_cacheable = false;                           // Сервер уже присылал CachedResponse этой функции
+        if constexpr (!std::is_void_v<Result>) {
+            static_assert(!rpc::Serializer::is_view<Result>(), "Result would point into a released slot: use std::string or a fixed-size type");
+            known_cacheable = m_cacheable.count(name) != 0;     // Остальные функции - без ключа и поиска в кэше
+            if (known_cacheable) {
+                key = cache_key(name, request + 2 + target.size(), length - 2 - target.size());
+                const CacheEntry* cached = lookup(key);
+                if (cached != nullptr && decode(cached->result.data(), cached->result.size(), cached->encoding, reply.value)) {
+                    reply.status = rpc::CallStatus::Ok;         // Ответ из кэша без обращения к каналу
+                    co_return reply;
+                }
+            }
+        }
+
+        co_await SlotAwaiter{*this};                            // Ожидание места в окне
+        std::uint8_t seq = acquire();
+        request[1] = seq;
+        std::uint64_t epoch = m_invalidation_epoch;
+        if (!send_request(seq, request, length)) {
+            release(seq);
+            reply.status = rpc::CallStatus::Error;
+            co_return reply;
+        }
+
+        co_await ResponseAwaiter{*this, seq};
+        const PendingCall& pending = m_pending[seq];
+        reply.status = pending.status;
+        if (reply.status == rpc::CallStatus::Error && pending.length >= 3) {
+            reply.error = static_cast<rpc::ErrorCode>(pending.data[2]);
+        }
+        if constexpr (!std::is_void_v<Result>) {
+            std::size_t offset = target.reply_name_length() + 3;    // type + seq + name + null terminator
+            bool cacheable = reply.ok() && pending.data[0] == static_cast<std::uint8_t>(rpc::MessageType::CachedResponse);
+            std::uint16_t max_age_ms = 0;
+            if (cacheable && pending.length >= offset + sizeof(max_age_ms)) {
+                max_age_ms = static_cast<std::uint16_t>(pending.data[offset] | pending.data[offset + 1] << 8);
+                offset += sizeof(max_age_ms);
+            }
+            if (reply.ok() && pending.length >= offset
+                && decode(pending.data + offset, pending.length - offset, pending.encoding, reply.value)) {
+                if (cacheable && !known_cacheable) {
+                    m_cacheable.insert(name);                   // Следующие вызовы ищутся в кэше
+                    ++m_cache_stats.misses;
+                }
+                if (max_age_ms != 0 && epoch == m_invalidation_epoch) {     // Значение не менялось, пока ждали ответ
+                    if (!known_cacheable) {
+                        key = cache_key(name, request + 2 + target.size(), length - 2 - target.size());
+                    }
+                    store(std::move(key), max_age_ms, pending.data + offset, pending.length - offset, pending.encoding);
+                }
+            } else if (reply.ok()) {
+                reply.status = rpc::CallStatus::Error;          // Ответ короче ожидаемого результата
+            }
+        }
+        release(seq);
+        co_return reply;
+    }
+
+    // Запись таблицы ожидающих вызовов
+    struct PendingCall {
+        bool active{false};                             // Запись занята вызовом
+        rpc::CallStatus status{rpc::CallStatus::Pending};
+        std::coroutine_handle<> waiter;                 // Корутина, ожидающая ответа
+        EventLoop::TimerId timer{0};                    // Таймер таймаута
+        rpc::Encoding encoding{rpc::Encoding::Fixed};   // Кодирование результата (флаг CompactFlag ответа)
+        std::size_t length{0};                          // Длина ответа
+        std::uint8_t data[protocol::Packet::MaxSize]{}; // Ответ (type | seq | name | result)
+        protocol::Frame request;                        // Отправленный кадр - история передачи для повтора по Nack
+    };
+
+    // Ожидание места в окне вызовов
+    struct SlotAwaiter {
+        Client& client;
+        bool await_ready() const noexcept;
+        void await_suspend(std::coroutine_handle<> handle) { client.m_slot_waiters.push_back(handle); }
+        void await_resume() const noexcept {}
+    };
+
+    // Ожидание ответа на запрос seq
+    struct ResponseAwaiter {
+        Client& client;
+        std::uint8_t seq;
+        bool await_ready() const noexcept { return client.m_pending[seq].status != rpc::CallStatus::Pending; }
+        void await_suspend(std::coroutine_handle<> handle) { client.m_pending[seq].waiter = handle; }
+        void await_resume() const noexcept {}
+    };
+
+    // Выбор свободного seq и занятие записи таблицы
+    std::uint8_t acquire();
+    // Освобождение записи и передача места в окне следующему вызову
+    void release(std::uint8_t seq);
+    // Отправка запроса и запуск таймера таймаута
+    bool send_request(std::uint8_t seq, const std::uint8_t* data, std::size_t length);
+    // Завершение вызова с заданным статусом
+    void complete(std::uint8_t seq, rpc::CallStatus status, const std::uint8_t* data, std::size_t length,
+                  rpc::Encoding encoding = rpc::Encoding::Fixed);
+    // Кодирование вызова функции: собственное, если задано, иначе кодирование канала
+    rpc::Encoding encoding_for(const std::string& name) const {
+        auto it = m_method_encoding.find(name);
+        return it != m_method_encoding.end() ? it->second : m_encoding;
+    }
+    // Десериализация результата в кодировании ответа
+    template<typename Result>
+    static bool decode(const std::uint8_t* data, std::size_t length, rpc::Encoding encoding, Result& value) {
+        return rpc::visit_encoding(encoding, [&](auto serializer) {
+            return decltype(serializer)::deserialize(data, length, value);
+        });
+    }
+    // Обработка пакета из парсера
+    static void on_packet(const protocol::Packet& packet, void* user_data);
+
+    // Результат в кэше
+    struct CacheEntry {
+        EventLoop::Clock::time_point expires;           // Срок действия (max - до Invalidate)
+        rpc::Encoding encoding{rpc::Encoding::Fixed};   // Кодирование результата
+        std::vector<std::uint8_t> result;               // Сериализованный результат
+    };
+
+    // Ключ кэша name\0 | signature | args... по имени и запросу без адресата (signature | args...)
+    static std::string cache_key(const std::string& name, const std::uint8_t* call, std::size_t length) {
+        std::string key(name.c_str(), name.size() + 1);
+        key.append(reinterpret_cast<const char*>(call), length);
+        return key;
+    }
+    // Действующий результат по ключу name\0 | signature | args или nullptr (промах считается)
+    const CacheEntry* lookup(const std::string& key);
+    // Сохранение результата на max_age_ms (UntilInvalidated - до Invalidate)
+    void store(std::string key, std::uint16_t max_age_ms, const std::uint8_t* result, std::size_t length,
+               rpc::Encoding encoding);
+    // Удаление всех результатов функции name
+    void invalidate(const char* name);
+    // Доставка Stream-сообщения type | seq | name\0 | signature | args... подписчику
+    void publish(const protocol::Packet& packet);
+
+    EventLoop& m_loop;                                  // Цикл событий
+    protocol::Parser m_parser;                          // Разбор входящих кадров
+    protocol::Sender m_sender;                          // Формирование исходящих кадров
+    std::chrono::milliseconds m_timeout;                // Таймаут ответа
+    std::size_t m_window{MaxPendingCalls};              // Размер окна вызовов
+    std::size_t m_in_flight{0};                         // Занято мест в окне
+    std::uint8_t m_next_seq{0};                         // Следующий кандидат seq
+    std::deque<std::coroutine_handle<>> m_slot_waiters; // Вызовы, ожидающие места в окне
+    PendingCall m_pending[MaxPendingCalls];             // Таблица ожидающих вызовов по seq
+    std::map<std::string, CacheEntry> m_cache;          // Кэш результатов, ключ name\0 | signature | args (упорядочен по имени)
+    std::set<std::string> m_cacheable;                  // Функции, результаты которых сервер разрешил кэшировать
+    std::uint64_t m_invalidation_epoch{0};              // Счетчик принятых Invalidate
+    rpc::Encoding m_encoding{rpc::Encoding::Fixed};     // Кодирование канала по умолчанию
+    std::map<std::string, rpc::Encoding> m_method_encoding; // Кодирование отдельных функций
+    CacheStats m_cache_stats;                           // Статистика кэша
+    std::map<std::string, StreamHandler> m_subscribers; // Подписчики на Stream-сообщения по имени
+};
+
+} // namespace host
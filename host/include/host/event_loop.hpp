@@ -0,0 +1,72 @@
+#pragma once
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <unordered_map>
+#include "utils/noncopyable.hpp"
+
+namespace host {
+
+/**
+ * Однопоточный цикл событий на epoll для хостового RPC клиента
+ *
+ * Объединяет три источника событий:
+ * 1. Готовность файловых дескрипторов (последовательный порт, pty)
+ * 2. Таймеры (таймауты вызовов, задержка loopback канала)
+ * 3. Очередь готовых к выполнению функций и корутин
+ *
+ * Все callback'и выполняются в потоке, вызвавшем run(); блокировок нет
+ */
+
+class EventLoop : private utils::NonCopyable {
+public:
+    using Clock = std::chrono::steady_clock;
+    using IoHandler = std::function<void(std::uint32_t events)>;
+    using TimerId = std::uint64_t;
+
+    EventLoop();
+    ~EventLoop();
+
+    // Подписка на события дескриптора (EPOLLIN/EPOLLOUT)
+    bool watch(int fd, std::uint32_t events, IoHandler handler);
+    // Изменение набора ожидаемых событий дескриптора
+    bool modify(int fd, std::uint32_t events);
+    // Отписка от событий дескриптора
+    void unwatch(int fd);
+
+    // Выполнение функции на следующей итерации цикла
+    void post(std::function<void()> fn);
+    // Возобновление корутины на следующей итерации цикла
+    void post(std::coroutine_handle<> handle);
+
+    // Вызов fn в момент when; возвращает идентификатор для отмены
+    TimerId schedule(Clock::time_point when, std::function<void()> fn);
+    // Отмена таймера (не ошибка, если он уже сработал)
+    void cancel(TimerId id);
+
+    // Обработка событий до вызова stop() или пока есть чем заниматься
+    void run();
+    // Одна итерация: ожидание событий не дольше timeout_ms (-1 - без ограничения)
+    void run_once(int timeout_ms);
+    // Остановка run() после текущей итерации
+    void stop() { m_stopped = true; }
+
+private:
+    // Выполнение сработавших таймеров
+    void fire_timers();
+    // Таймаут epoll_wait до ближайшего таймера
+    int next_timeout(int limit_ms) const;
+
+    int m_epoll{-1};                                                        // Дескриптор epoll
+    bool m_stopped{false};                                                  // Запрошена остановка run()
+    TimerId m_next_timer{1};                                                // Следующий идентификатор таймера
+    std::unordered_map<int, IoHandler> m_io;                                // Обработчики дескрипторов
+    std::deque<std::function<void()>> m_ready;                              // Готовые к выполнению функции
+    std::multimap<Clock::time_point, TimerId> m_deadlines;                  // Сроки таймеров по возрастанию
+    std::unordered_map<TimerId, std::function<void()>> m_timers;            // Активные таймеры
+};
+
+} // namespace host
@@ -0,0 +1,56 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include "drivers/serial.hpp"
+#include "utils/noncopyable.hpp"
+#include "event_loop.hpp"
+
+namespace host {
+
+/**
+ * Канал в памяти между двумя drivers::Serial для тестов и бенчмарков
+ *
+ * Байты, записанные в a(), принимаются b() и наоборот; доставка всегда
+ *       асинхронна (через цикл событий), как у настоящего порта
+ * latency - задержка доставки каждого кадра (0 - следующая итерация цикла)
+ * set_corruption имитирует помехи: у каждого N-го кадра от a() к b()
+ *       портится CRC данных (заголовок цел - парсер отвечает Nack)
+ */
+
+class LoopbackLink : private utils::NonCopyable {
+public:
+    explicit LoopbackLink(EventLoop& loop, std::chrono::microseconds latency = std::chrono::microseconds{0});
+
+    // Первая сторона канала (обычно клиент)
+    drivers::Serial& a() { return m_a; }
+    // Вторая сторона канала (обычно сервер)
+    drivers::Serial& b() { return m_b; }
+    // Порча каждого every-го кадра от a() к b() (0 - без помех)
+    void set_corruption(std::size_t every) { m_corrupt_every = every; }
+
+private:
+    // Одна сторона канала
+    class Endpoint : public drivers::Serial {
+    public:
+        explicit Endpoint(LoopbackLink& link) : m_link(link) {}
+        bool write(const std::uint8_t* data, std::size_t length) override;
+        void set_rx_callback(RxCallback callback, void* user_data) override;
+
+        Endpoint* peer{nullptr};            // Противоположная сторона
+
+    private:
+        friend class LoopbackLink;
+        LoopbackLink& m_link;               // Канал-владелец
+        RxCallback m_rx_callback{nullptr};  // Callback принятых байтов
+        void* m_rx_user_data{nullptr};      // Пользовательские данные callback'а
+    };
+
+    EventLoop& m_loop;                      // Цикл событий для доставки
+    std::chrono::microseconds m_latency;    // Задержка доставки кадра
+    std::size_t m_corrupt_every{0};         // Период порчи кадров от a() к b()
+    std::size_t m_frames{0};                // Число кадров от a() к b()
+    Endpoint m_a;                           // Сторона A
+    Endpoint m_b;                           // Сторона B
+};
+
+} // namespace host
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "drivers/serial.hpp"
+#include "utils/noncopyable.hpp"
+#include "event_loop.hpp"
+
+namespace host {
+
+/**
+ * Неблокирующий последовательный порт Linux (tty или pty) для цикла событий
+ *
+ * Прием: при готовности дескриптора все доступные байты читаются пачкой
+ *       и по одному передаются в callback (обычно protocol::Parser)
+ * Отправка: write() пишет сколько примет драйвер, остаток буферизуется
+ *       и дописывается по EPOLLOUT - вызывающая корутина никогда не блокируется
+ */
+
+class SerialPort : public drivers::Serial, private utils::NonCopyable {
+public:
+    explicit SerialPort(EventLoop& loop) : m_loop(loop) {}
+    ~SerialPort() { close(); }
+
+    // Открытие tty в raw-режиме 8N1 с заданной скоростью
+    bool open(const std::string& path, unsigned baud = 115200);
+    // Работа с уже открытым дескриптором (например, master стороной pty); порт становится владельцем
+    bool attach(int fd);
+    // Закрытие порта
+    void close();
+
+    // Создание пары pty: возвращает дескриптор master, путь slave - в slave_path
+    static int open_pty(std::string& slave_path);
+
+    bool write(const std::uint8_t* data, std::size_t length) override;
+    void set_rx_callback(RxCallback callback, void* user_data) override;
+
+private:
+    // Обработка событий дескриптора
+    void on_events(std::uint32_t events);
+    // Дописывание буфера отправки
+    void flush();
+
+    EventLoop& m_loop;                  // Цикл событий
+    int m_fd{-1};                       // Дескриптор порта
+    std::vector<std::uint8_t> m_tx;     // Неотправленный остаток
+    RxCallback m_rx_callback{nullptr};  // Callback принятых байтов
+    void* m_rx_user_data{nullptr};      // Пользовательские данные callback'а
+};
+
+} // namespace host
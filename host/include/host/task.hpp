@@ -0,0 +1,144 @@
+#pragma once
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+namespace host {
+
+/**
+ * Ленивая корутина с результатом T для хостового клиента
+ *
+ * Начинает выполнение только при co_await; по завершении передает управление
+ *       ожидающей корутине (symmetric transfer), поэтому длинные цепочки
+ *       вызовов не растят стек
+ * Только перемещаемая - кадр корутины принадлежит ровно одному Task
+ */
+
+template<typename T = void>
+class Task;
+
+namespace detail {
+
+// Общая часть promise_type: продолжение и исключение
+struct PromiseBase {
+    std::coroutine_handle<> continuation;   // Корутина, ожидающая результата
+    std::exception_ptr error;               // Исключение из тела корутины
+
+    // Возобновление ожидающей корутины по завершении
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+        template<typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) const noexcept {
+            std::coroutine_handle<> next = handle.promise().continuation;
+            return next ? next : std::noop_coroutine();
+        }
+        void await_resume() const noexcept {}
+    };
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+    void unhandled_exception() noexcept { error = std::current_exception(); }
+};
+
+template<typename T>
+struct Promise : PromiseBase {
+    std::optional<T> value;     // Результат корутины
+
+    Task<T> get_return_object() noexcept;
+    template<typename V>
+    void return_value(V&& result) { value.emplace(std::forward<V>(result)); }
+    T take() {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        return std::move(*value);
+    }
+};
+
+template<>
+struct Promise<void> : PromiseBase {
+    Task<void> get_return_object() noexcept;
+    void return_void() noexcept {}
+    void take() {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+};
+
+} // namespace detail
+
+template<typename T>
+class Task {
+public:
+    using promise_type = detail::Promise<T>;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    explicit Task(Handle handle) noexcept : m_handle(handle) {}
+    Task(Task&& other) noexcept : m_handle(std::exchange(other.m_handle, {})) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (m_handle) {
+                m_handle.destroy();
+            }
+            m_handle = std::exchange(other.m_handle, {});
+        }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task() {
+        if (m_handle) {
+            m_handle.destroy();
+        }
+    }
+
+    // Ожидание результата: запускает корутину и возобновляет вызывающую по завершении
+    auto operator co_await() && noexcept {
+        struct Awaiter {
+            Handle handle;
+            bool await_ready() const noexcept { return !handle || handle.done(); }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) noexcept {
+                handle.promise().continuation = caller;
+                return handle;
+            }
+            T await_resume() { return handle.promise().take(); }
+        };
+        return Awaiter{m_handle};
+    }
+
+private:
+    Handle m_handle;
+};
+
+namespace detail {
+
+template<typename T>
+Task<T> Promise<T>::get_return_object() noexcept {
+    return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+}
+
+inline Task<void> Promise<void>::get_return_object() noexcept {
+    return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+}
+
+// Корутина без владельца: запускается сразу и уничтожает себя по завершении
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() const noexcept { return {}; }
+        std::suspend_never initial_suspend() const noexcept { return {}; }
+        std::suspend_never final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept {}
+        void unhandled_exception() const noexcept { std::terminate(); }
+    };
+};
+
+} // namespace detail
+
+// Запуск задачи без ожидания результата (выполняется до первой точки ожидания)
+inline detail::Detached spawn(Task<void> task) {
+    co_await std::move(task);
+}
+
+} // namespace host
@@ -0,0 +1,209 @@
+#include "host/client.hpp"
+#include <algorithm>
+
+namespace host {
+
+/**
+ * Конструктор хостового клиента
+ * loop Цикл событий, в котором выполняются вызовы
+ * serial Канал к устройству (SerialPort или LoopbackLink)
+ * timeout Время ожидания ответа на каждый вызов
+ */
+
+Client::Client(EventLoop& loop, drivers::Serial& serial, std::chrono::milliseconds timeout)
+    : m_loop(loop), m_parser(serial, on_packet, this), m_sender(serial), m_timeout(timeout) {}
+
+void Client::set_window(std::size_t window) {
+    m_window = std::clamp<std::size_t>(window, 1, MaxPendingCalls);
+}
+
+// Место в окне занимается сразу; иначе корутина встает в очередь и получит место от release()
+bool Client::SlotAwaiter::await_ready() const noexcept {
+    if (client.m_in_flight < client.m_window && client.m_slot_waiters.empty()) {
+        ++client.m_in_flight;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Выбор seq для нового вызова
+ * Вызывается только после получения места в окне, поэтому свободная запись
+ *       гарантированно есть (окно не больше размера таблицы)
+ */
+
+std::uint8_t Client::acquire() {
+    while (m_pending[m_next_seq].active) {
+        ++m_next_seq;
+    }
+    std::uint8_t seq = m_next_seq++;
+    PendingCall& pending = m_pending[seq];
+    pending.active = true;
+    pending.status = rpc::CallStatus::Pending;
+    pending.waiter = nullptr;
+    pending.timer = 0;
+    pending.length = 0;
+    return seq;
+}
+
+void Client::release(std::uint8_t seq) {
+    PendingCall& pending = m_pending[seq];
+    if (pending.timer != 0) {
+        m_loop.cancel(pending.timer);
+    }
+    pending.active = false;
+    if (!m_slot_waiters.empty() && m_in_flight <= m_window) {
+        std::coroutine_handle<> next = m_slot_waiters.front();  // Место переходит к следующему вызову без освобождения
+        m_slot_waiters.pop_front();
+        m_loop.post(next);
+    } else {
+        --m_in_flight;
+    }
+}
+
+bool Client::send_request(std::uint8_t seq, const std::uint8_t* data, std::size_t length) {
+    protocol::Frame& request = m_pending[seq].request;
+    std::memcpy(request.payload(), data, length);
+    if (!protocol::Sender::seal(request, length) || !m_sender.send(request)) {
+        return false;
+    }
+    m_pending[seq].timer = m_loop.schedule(EventLoop::Clock::now() + m_timeout, [this, seq] {
+        m_pending[seq].timer = 0;
+        complete(seq, rpc::CallStatus::Timeout, nullptr, 0);
+    });
+    return true;
+}
+
+/**
+ * Завершение вызова
+ * Ожидающая корутина возобновляется на следующей итерации цикла, а не из
+ *       парсера - иначе новый запрос отправлялся бы изнутри разбора кадра
+ */
+
+void Client::complete(std::uint8_t seq, rpc::CallStatus status, const std::uint8_t* data, std::size_t length,
+                      rpc::Encoding encoding) {
+    PendingCall& pending = m_pending[seq];
+    if (!pending.active || pending.status != rpc::CallStatus::Pending) {
+        return;                                                 // Ответ на просроченный или чужой запрос
+    }
+    if (pending.timer != 0 && status != rpc::CallStatus::Timeout) {
+        m_loop.cancel(pending.timer);
+        pending.timer = 0;
+    }
+    std::memcpy(pending.data, data, length);
+    pending.length = length;
+    pending.encoding = encoding;
+    pending.status = status;
+    if (pending.waiter) {
+        m_loop.post(std::exchange(pending.waiter, nullptr));
+    }
+}
+
+void Client::on_packet(const protocol::Packet& packet, void* user_data) {
+    if (packet.data_length < 2) {
+        return;
+    }
+    auto* client = static_cast<Client*>(user_data);
+    switch (packet.type) {
+        case rpc::MessageType::Response:
+        case rpc::MessageType::CachedResponse:
+            client->complete(packet.seq, rpc::CallStatus::Ok, packet.data, packet.data_length, packet.encoding);
+            break;
+        case rpc::MessageType::Invalidate:
+            if (packet.data_length > 2 && std::memchr(packet.data + 2, '\0', packet.data_length - 2) != nullptr) {
+                client->invalidate(reinterpret_cast<const char*>(packet.data + 2));
+            }
+            break;
+        case rpc::MessageType::Error:
+            client->complete(packet.seq, rpc::CallStatus::Error, packet.data, packet.data_length);
+            break;
+        case rpc::MessageType::Nack:                            // Поврежден наш запрос - повтор из таблицы, таймер не сдвигается
+            if (packet.data_length >= 3 && packet.data[2] == static_cast<std::uint8_t>(rpc::MessageType::Request)) {
+                const PendingCall& pending = client->m_pending[packet.seq];
+                if (pending.active && pending.status == rpc::CallStatus::Pending) {
+                    client->m_sender.send(pending.request);
+                }
+            }
+            break;
+        case rpc::MessageType::Stream:
+            client->publish(packet);
+            break;
+        default:
+            break;                                              // Пакетные ответы этим клиентом не используются
+    }
+}
+
+const Client::CacheEntry* Client::lookup(const std::string& key) {
+    auto it = m_cache.find(key);
+    if (it != m_cache.end() && EventLoop::Clock::now() < it->second.expires) {
+        ++m_cache_stats.hits;
+        return &it->second;
+    }
+    if (it != m_cache.end()) {
+        m_cache.erase(it);                                      // Срок истек
+    }
+    ++m_cache_stats.misses;
+    return nullptr;
+}
+
+void Client::store(std::string key, std::uint16_t max_age_ms, const std::uint8_t* result, std::size_t length,
+                   rpc::Encoding encoding) {
+    CacheEntry& entry = m_cache[std::move(key)];
+    entry.expires = max_age_ms == rpc::UntilInvalidated
+        ? EventLoop::Clock::time_point::max()
+        : EventLoop::Clock::now() + std::chrono::milliseconds(max_age_ms);
+    entry.encoding = encoding;
+    entry.result.assign(result, result + length);
+}
+
+/**
+ * Удаление результатов функции
+ * Ключи упорядочены, поэтому все результаты функции (любые аргументы) -
+ *       непрерывный диапазон с префиксом name\0
+ */
+
+void Client::invalidate(const char* name) {
+    ++m_invalidation_epoch;
+    ++m_cache_stats.invalidations;
+    std::string prefix(name, std::strlen(name) + 1);
+    auto it = m_cache.lower_bound(prefix);
+    while (it != m_cache.end() && it->first.compare(0, prefix.size(), prefix) == 0) {
+        it = m_cache.erase(it);
+    }
+}
+
+void Client::publish(const protocol::Packet& packet) {
+    const char* name = reinterpret_cast<const char*>(packet.data + 2);
+    const void* terminator = std::memchr(name, '\0', packet.data_length - 2);
+    if (terminator == nullptr) {
+        return;
+    }
+    std::size_t header_length = static_cast<const std::uint8_t*>(terminator) - packet.data + 1 + rpc::SignatureSize;
+    auto it = m_subscribers.find(name);
+    if (it != m_subscribers.end() && header_length <= packet.data_length) {
+        it->second(packet.data + header_length, packet.data_length - header_length);
+    }
+}
+
+/**
+ * Подписка на блоки выборок
+ * Поврежденный блок доставляет выборки до места повреждения; блок с другим
+ *       форматом аргументов (не TimeSeriesBlock) пропускается
+ */
+
+void Client::subscribe_series(const std::string& name, std::function<void(const rpc::Sample&)> handler) {
+    subscribe(name, [handler = std::move(handler)](const std::uint8_t* args, std::size_t length) {
+        rpc::TimeSeriesBlock block;
+        rpc::Reader in(args, length);
+        if (!rpc::Codec<rpc::TimeSeriesBlock>::read(in, block) || in.remaining() != 0) {
+            return;
+        }
+        rpc::TimeSeriesDecoder decoder(block);
+        rpc::Sample sample{};
+        while (decoder.next(sample)) {
+            handler(sample);
+        }
+    });
+}
+
+} // namespace host
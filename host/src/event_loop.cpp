@@ -0,0 +1,119 @@
+#include "host/event_loop.hpp"
+#include <sys/epoll.h>
+#include <unistd.h>
+
+namespace host {
+
+// Создание дескриптора epoll
+EventLoop::EventLoop() : m_epoll(epoll_create1(EPOLL_CLOEXEC)) {}
+
+EventLoop::~EventLoop() {
+    if (m_epoll >= 0) {
+        ::close(m_epoll);
+    }
+}
+
+bool EventLoop::watch(int fd, std::uint32_t events, IoHandler handler) {
+    epoll_event event{};
+    event.events = events;
+    event.data.fd = fd;
+    if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &event) != 0) {
+        return false;
+    }
+    m_io[fd] = std::move(handler);
+    return true;
+}
+
+bool EventLoop::modify(int fd, std::uint32_t events) {
+    epoll_event event{};
+    event.events = events;
+    event.data.fd = fd;
+    return epoll_ctl(m_epoll, EPOLL_CTL_MOD, fd, &event) == 0;
+}
+
+void EventLoop::unwatch(int fd) {
+    epoll_ctl(m_epoll, EPOLL_CTL_DEL, fd, nullptr);
+    m_io.erase(fd);
+}
+
+void EventLoop::post(std::function<void()> fn) {
+    m_ready.push_back(std::move(fn));
+}
+
+void EventLoop::post(std::coroutine_handle<> handle) {
+    m_ready.push_back([handle] { handle.resume(); });
+}
+
+EventLoop::TimerId EventLoop::schedule(Clock::time_point when, std::function<void()> fn) {
+    TimerId id = m_next_timer++;
+    m_timers.emplace(id, std::move(fn));
+    m_deadlines.emplace(when, id);
+    return id;
+}
+
+// Отмена только удаляет функцию - запись срока отбрасывается при срабатывании
+void EventLoop::cancel(TimerId id) {
+    m_timers.erase(id);
+}
+
+/**
+ * Основной цикл
+ *
+ * Завершается по stop() или когда не осталось ни дескрипторов, ни таймеров,
+ *       ни готовых функций - то есть ждать больше нечего
+ */
+
+void EventLoop::run() {
+    m_stopped = false;
+    while (!m_stopped && (!m_io.empty() || !m_timers.empty() || !m_ready.empty())) {
+        run_once(-1);
+    }
+}
+
+void EventLoop::run_once(int timeout_ms) {
+    while (!m_ready.empty()) {                                  // Готовые функции выполняются до опроса дескрипторов
+        std::function<void()> fn = std::move(m_ready.front());
+        m_ready.pop_front();
+        fn();
+    }
+    fire_timers();
+    if (m_stopped || (m_io.empty() && m_timers.empty() && m_ready.empty())) {
+        return;
+    }
+
+    epoll_event events[32];
+    int count = epoll_wait(m_epoll, events, 32, m_ready.empty() ? next_timeout(timeout_ms) : 0);
+    for (int i = 0; i < count; ++i) {
+        auto it = m_io.find(events[i].data.fd);
+        if (it != m_io.end()) {
+            IoHandler handler = it->second;                     // Копия: обработчик может отписать дескриптор
+            handler(events[i].events);
+        }
+    }
+    fire_timers();
+}
+
+void EventLoop::fire_timers() {
+    Clock::time_point now = Clock::now();
+    while (!m_deadlines.empty() && m_deadlines.begin()->first <= now) {
+        TimerId id = m_deadlines.begin()->second;
+        m_deadlines.erase(m_deadlines.begin());
+        auto it = m_timers.find(id);
+        if (it != m_timers.end()) {
+            std::function<void()> fn = std::move(it->second);
+            m_timers.erase(it);
+            fn();
+        }
+    }
+}
+
+int EventLoop::next_timeout(int limit_ms) const {
+    if (m_deadlines.empty()) {
+        return limit_ms;
+    }
+    auto delay = std::chrono::duration_cast<std::chrono::milliseconds>(m_deadlines.begin()->first - Clock::now()).count();
+    int timeout = delay > 0 ? static_cast<int>(delay) + 1 : 0;  // +1: epoll округляет вниз, таймер не должен сработать раньше срока
+    return limit_ms >= 0 && limit_ms < timeout ? limit_ms : timeout;
+}
+
+} // namespace host
@@ -0,0 +1,46 @@
+#include "host/loopback.hpp"
+#include <memory>
+#include <vector>
+
+namespace host {
+
+LoopbackLink::LoopbackLink(EventLoop& loop, std::chrono::microseconds latency)
+    : m_loop(loop), m_latency(latency), m_a(*this), m_b(*this) {
+    m_a.peer = &m_b;
+    m_b.peer = &m_a;
+}
+
+/**
+ * Отправка кадра противоположной стороне
+ * Кадр копируется и доставляется побайтно на следующей итерации цикла
+ *       или по истечении задержки канала
+ */
+
+bool LoopbackLink::Endpoint::write(const std::uint8_t* data, std::size_t length) {
+    auto frame = std::make_shared<std::vector<std::uint8_t>>(data, data + length);
+    if (this == &m_link.m_a && m_link.m_corrupt_every != 0 && length >= 2
+        && ++m_link.m_frames % m_link.m_corrupt_every == 0) {
+        (*frame)[length - 2] ^= 0xFF;                               // CRC данных перед стоповым байтом
+    }
+    Endpoint* target = peer;
+    auto deliver = [target, frame] {
+        for (std::uint8_t byte : *frame) {
+            if (target->m_rx_callback) {
+                target->m_rx_callback(byte, target->m_rx_user_data);
+            }
+        }
+    };
+    if (m_link.m_latency.count() == 0) {
+        m_link.m_loop.post(std::move(deliver));
+    } else {
+        m_link.m_loop.schedule(EventLoop::Clock::now() + m_link.m_latency, std::move(deliver));
+    }
+    return true;
+}
+
+void LoopbackLink::Endpoint::set_rx_callback(RxCallback callback, void* user_data) {
+    m_rx_callback = callback;
+    m_rx_user_data = user_data;
+}
+
+} // namespace host
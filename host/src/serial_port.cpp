@@ -0,0 +1,160 @@
+#include "host/serial_port.hpp"
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace host {
+
+namespace {
+
+// Константа termios для скорости в бодах (B0 - не поддерживается)
+speed_t baud_constant(unsigned baud) {
+    switch (baud) {
+        case 9600: return B9600;
+        case 19200: return B19200;
+        case 38400: return B38400;
+        case 57600: return B57600;
+        case 115200: return B115200;
+        case 230400: return B230400;
+        case 460800: return B460800;
+        case 921600: return B921600;
+        default: return B0;
+    }
+}
+
+} // namespace
+
+/**
+ * Открытие последовательного порта
+ * path Путь к устройству (/dev/ttyACM0, /dev/pts/N)
+ * baud Скорость в бодах
+ * true если порт открыт и подписан на события
+ */
+
+bool SerialPort::open(const std::string& path, unsigned baud) {
+    int fd = ::open(path.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    termios tty{};
+    if (tcgetattr(fd, &tty) == 0) {                             // pty тоже поддерживает termios; ошибку не считаем фатальной
+        cfmakeraw(&tty);
+        tty.c_cflag |= CLOCAL | CREAD;
+        tty.c_cflag &= ~(CSTOPB | PARENB | CRTSCTS);
+        speed_t speed = baud_constant(baud);
+        if (speed != B0) {
+            cfsetispeed(&tty, speed);
+            cfsetospeed(&tty, speed);
+        }
+        tcsetattr(fd, TCSANOW, &tty);
+    }
+    return attach(fd);
+}
+
+bool SerialPort::attach(int fd) {
+    close();
+    int flags = fcntl(fd, F_GETFL);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    if (!m_loop.watch(fd, EPOLLIN, [this](std::uint32_t events) { on_events(events); })) {
+        ::close(fd);
+        return false;
+    }
+    m_fd = fd;
+    return true;
+}
+
+void SerialPort::close() {
+    if (m_fd >= 0) {
+        m_loop.unwatch(m_fd);
+        ::close(m_fd);
+        m_fd = -1;
+    }
+    m_tx.clear();
+}
+
+int SerialPort::open_pty(std::string& slave_path) {
+    int master = posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+        if (master >= 0) {
+            ::close(master);
+        }
+        return -1;
+    }
+    const char* name = ptsname(master);
+    slave_path = name != nullptr ? name : "";
+    termios tty{};                                              // Raw-режим на стороне master, иначе line discipline портит бинарные кадры
+    if (tcgetattr(master, &tty) == 0) {
+        cfmakeraw(&tty);
+        tcsetattr(master, TCSANOW, &tty);
+    }
+    return master;
+}
+
+/**
+ * Отправка кадра без блокировки
+ * true если кадр принят к отправке (записан или поставлен в буфер)
+ *
+ * Пока буфер не пуст, новые данные добавляются в его конец, чтобы кадры
+ *       не перемешивались
+ */
+
+bool SerialPort::write(const std::uint8_t* data, std::size_t length) {
+    if (m_fd < 0) {
+        return false;
+    }
+    std::size_t written = 0;
+    if (m_tx.empty()) {
+        ssize_t result = ::write(m_fd, data, length);
+        if (result < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            return false;
+        }
+        written = result > 0 ? static_cast<std::size_t>(result) : 0;
+    }
+    if (written < length) {
+        bool idle = m_tx.empty();
+        m_tx.insert(m_tx.end(), data + written, data + length);
+        if (idle) {
+            m_loop.modify(m_fd, EPOLLIN | EPOLLOUT);            // Дописывание остатка по готовности
+        }
+    }
+    return true;
+}
+
+void SerialPort::set_rx_callback(RxCallback callback, void* user_data) {
+    m_rx_callback = callback;
+    m_rx_user_data = user_data;
+}
+
+void SerialPort::on_events(std::uint32_t events) {
+    if (events & EPOLLOUT) {
+        flush();
+    }
+    if (events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+        std::uint8_t buffer[512];
+        while (m_fd >= 0) {
+            ssize_t count = ::read(m_fd, buffer, sizeof(buffer));
+            if (count <= 0) {
+                break;                                          // EAGAIN - данные кончились; 0/EIO - другая сторона закрыта
+            }
+            for (ssize_t i = 0; i < count && m_rx_callback; ++i) {
+                m_rx_callback(buffer[i], m_rx_user_data);
+            }
+        }
+    }
+}
+
+void SerialPort::flush() {
+    while (!m_tx.empty()) {
+        ssize_t result = ::write(m_fd, m_tx.data(), m_tx.size());
+        if (result <= 0) {
+            return;                                             // Драйвер занят - ждем следующего EPOLLOUT
+        }
+        m_tx.erase(m_tx.begin(), m_tx.begin() + result);
+    }
+    m_loop.modify(m_fd, EPOLLIN);
+}
+
+} // namespace host
@@ -0,0 +1,737 @@
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+#include "drivers/serial.hpp"
+#include "protocol/lzss.hpp"
+#include "protocol/parser.hpp"
+#include "protocol/sender.hpp"
+#include "rpc/endian.hpp"
+#include "rpc/serializer.hpp"
+#include "rpc/signature.hpp"
+#include "rpc/timeseries.hpp"
+
+/**
+ * Тесты кодеков кадра: запись и обратное чтение значений, формат в кадре,
+ *       отказ на поврежденных и усеченных данных
+ *
+ * Собирается дважды (host/CMakeLists.txt): rpc_codec_test - обычная сборка,
+ *       rpc_codec_test_swapped - с RPC_FORCE_BYTE_SWAP=1, где запись и чтение
+ *       идут путем big-endian узла (перестановка байт, без memcpy)
+ *
+ * rpc_codec_test - код возврата 0, если все проверки прошли
+ */
+
+namespace {
+
+// Кадр big-endian: перестановка включена на little-endian узле
+constexpr bool WireBigEndian = rpc::NativeLittleEndian && rpc::SwapBytes;
+
+int g_checks = 0;
+int g_failures = 0;
+
+void check(bool passed, const char* expression, const char* file, int line) {
+    ++g_checks;
+    if (!passed) {
+        ++g_failures;
+        std::printf("%s:%d: check failed: %s\n", file, line, expression);
+    }
+}
+
+#define CHECK(...) check((__VA_ARGS__), #__VA_ARGS__, __FILE__, __LINE__)
+
+// Запись value и чтение обратно из буфера ровно той длины, что записана
+template<typename Serializer, typename T>
+bool round_trip(const T& value, T& result) {
+    std::uint8_t buffer[protocol::Packet::MaxSize]{};
+    std::size_t length = static_cast<std::size_t>(Serializer::serialize(value, buffer) - buffer);
+    return length == Serializer::size_of(value) && Serializer::deserialize(buffer, length, result);
+}
+
+template<typename Serializer, typename T>
+bool round_trips(const T& value) {
+    T result{};
+    return round_trip<Serializer>(value, result) && result == value;
+}
+
+enum class Mode : std::uint16_t { Idle = 0x0102, Run = 0xA0B0 };
+
+// Агрегатные структуры (fields.hpp): сравниваются по полям
+struct Telemetry {
+    std::uint8_t id;
+    float value;
+    std::uint16_t flags;
+};
+struct Rgb {
+    std::uint8_t r, g, b;
+};
+struct Reading {
+    Rgb color;
+    Telemetry telemetry;
+    std::string label;
+    std::array<std::int16_t, 2> offsets;
+};
+
+template<typename Serializer, typename T>
+bool same_fields_after_round_trip(const T& value) {
+    T result{};
+    return round_trip<Serializer>(value, result) && rpc::fields_of(result) == rpc::fields_of(value);
+}
+
+enum class Led : std::uint8_t { Off, Blink, On };
+
+} // namespace
+
+template<>
+struct rpc::BitWidth<Led> : std::integral_constant<std::size_t, 2> {};
+
+namespace {
+
+// Плотные форматы (packing.hpp) в структуре: 1 + 2 + 2 байта
+struct Status {
+    rpc::Packed<bool, bool, Led> flags;
+    rpc::Quantized<-40, 125> temperature;
+    rpc::Half current;
+};
+
+// Порядок байт в кадре и запись-чтение чисел всех размеров
+void test_byte_order() {
+    std::uint8_t bytes[8]{};
+    rpc::store_le(bytes, std::uint32_t{0x11223344});
+    const std::uint8_t little[] = {0x44, 0x33, 0x22, 0x11};
+    const std::uint8_t big[] = {0x11, 0x22, 0x33, 0x44};
+    CHECK(std::memcmp(bytes, WireBigEndian ? big : little, 4) == 0);
+
+    rpc::store_le(bytes, 1.0f);                                 // 0x3F800000
+    CHECK(bytes[WireBigEndian ? 0 : 3] == 0x3F && bytes[WireBigEndian ? 1 : 2] == 0x80);
+
+    std::uint64_t wide = 0;
+    rpc::store_le(bytes, std::uint64_t{0x0102030405060708});
+    rpc::load_le(bytes, wide);
+    CHECK(wide == 0x0102030405060708);
+    CHECK(bytes[0] == (WireBigEndian ? 0x01 : 0x08));
+
+    CHECK(rpc::Codec<std::uint32_t>::Plain == !rpc::SwapBytes);
+    CHECK(rpc::Codec<std::uint8_t>::Plain);
+}
+
+template<typename Serializer>
+void test_scalars() {
+    CHECK(round_trips<Serializer>(std::uint8_t{0xA5}));
+    CHECK(round_trips<Serializer>(true));
+    CHECK(round_trips<Serializer>(std::int16_t{-12345}));
+    CHECK(round_trips<Serializer>(std::uint16_t{0xBEEF}));
+    CHECK(round_trips<Serializer>(std::int32_t{-2000000000}));
+    CHECK(round_trips<Serializer>(std::uint32_t{0xDEADBEEF}));
+    CHECK(round_trips<Serializer>(std::int64_t{-0x123456789ABCDEF}));
+    CHECK(round_trips<Serializer>(std::uint64_t{0xFEDCBA9876543210}));
+    CHECK(round_trips<Serializer>(-273.15f));
+    CHECK(round_trips<Serializer>(6.02214076e23));
+    CHECK(round_trips<Serializer>(Mode::Run));
+}
+
+// Массивы: поэлементная перестановка одним циклом и Span из принятого кадра
+void test_arrays() {
+    CHECK(round_trips<rpc::Serializer>(std::array<float, 3>{1.5f, -2.25f, 1e-3f}));
+    CHECK(round_trips<rpc::Serializer>(std::array<std::uint16_t, 4>{1, 0x0203, 0xFFFE, 0x8000}));
+
+    const float gains[] = {0.5f, -1.0f, 3.25f, 100.0f};
+    std::uint8_t buffer[protocol::Packet::MaxSize]{};
+    std::uint8_t* end = rpc::Serializer::serialize(rpc::Span<float>(gains), buffer);
+    CHECK(end - buffer == 1 + 4 * 4);
+    CHECK(buffer[0] == 4);
+
+    rpc::Span<float> received;
+    CHECK(rpc::Serializer::deserialize(buffer, static_cast<std::size_t>(end - buffer), received));
+    CHECK(received.size() == 4 && received.wire_order());
+    bool same = received.size() == 4;
+    for (std::size_t i = 0; same && i < received.size(); ++i) {
+        same = received[i] == gains[i];
+    }
+    CHECK(same);
+
+    // Повторная отправка принятого Span копирует байты кадра без перестановки
+    std::uint8_t forwarded[protocol::Packet::MaxSize]{};
+    std::uint8_t* forwarded_end = rpc::Serializer::serialize(received, forwarded);
+    CHECK(forwarded_end - forwarded == end - buffer);
+    CHECK(std::memcmp(forwarded, buffer, static_cast<std::size_t>(end - buffer)) == 0);
+}
+
+// Кортеж аргументов: чтение по смещениям (побайтные типы) и через Codec
+void test_tuples() {
+    std::uint8_t buffer[protocol::Packet::MaxSize]{};
+    std::uint8_t* end = rpc::Serializer::serialize_values(buffer, std::uint8_t{7}, std::uint32_t{0x01020304}, 2.5f);
+    CHECK(end - buffer == 9);
+    CHECK(rpc::Serializer::tuple_size<std::uint8_t, std::uint32_t, float>() == 9);
+
+    auto values = rpc::Serializer::deserialize_tuple<std::uint8_t, std::uint32_t, float>(buffer);
+    CHECK(std::get<0>(values) == 7 && std::get<1>(values) == 0x01020304 && std::get<2>(values) == 2.5f);
+
+    std::tuple<std::uint8_t, std::uint32_t, float> checked;
+    CHECK(rpc::Serializer::deserialize_tuple(buffer, 9, checked) && checked == values);
+}
+
+// Значения переменной длины: строки, необязательные значения, вложенные кортежи
+void test_variable_length() {
+    CHECK(round_trips<rpc::Serializer>(std::string("temperature")));
+    CHECK(round_trips<rpc::Serializer>(std::string()));
+    CHECK(round_trips<rpc::Serializer>(std::optional<std::int32_t>(-5)));
+    CHECK(round_trips<rpc::Serializer>(std::optional<std::int32_t>()));
+    CHECK(round_trips<rpc::CompactSerializer>(std::tuple<std::string, std::optional<std::uint16_t>, float>("gain", 300, 0.5f)));
+
+    // string_view при чтении указывает в буфер, а не копирует символы
+    std::uint8_t buffer[protocol::Packet::MaxSize]{};
+    std::uint8_t* end = rpc::Serializer::serialize(std::string_view("led"), buffer);
+    CHECK(end - buffer == 4 && buffer[0] == 3);
+    std::string_view name;
+    CHECK(rpc::Serializer::deserialize(buffer, 4, name));
+    CHECK(name == "led" && reinterpret_cast<const std::uint8_t*>(name.data()) == buffer + 1);
+    CHECK(rpc::Serializer::is_view<std::string_view>() && !rpc::Serializer::is_view<std::string>());
+    CHECK(!rpc::Serializer::is_fixed<std::string>() && rpc::Serializer::min_size<std::string, std::uint16_t>() == 3);
+}
+
+// Длины из канала не выводят чтение за границы буфера
+void test_bounds() {
+    std::uint8_t buffer[protocol::Packet::MaxSize]{};
+    std::uint8_t* end = rpc::Serializer::serialize_values(buffer, std::string_view("abcdef"), std::uint16_t{0x1234});
+    std::size_t length = static_cast<std::size_t>(end - buffer);
+
+    // Усеченный буфер: префикс длины указывает за его конец
+    std::string text;
+    CHECK(!rpc::Serializer::deserialize(buffer, 4, text));
+    CHECK(!rpc::Serializer::deserialize(buffer, 0, text));
+
+    // Префикс длины больше остатка кадра
+    std::uint8_t overlong[] = {200, 'a', 'b'};
+    std::string_view view;
+    CHECK(!rpc::Serializer::deserialize(overlong, sizeof(overlong), view));
+    rpc::Span<std::uint32_t> span;
+    std::uint8_t elements[] = {2, 1, 0, 0, 0, 2, 0, 0};             // 2 элемента по 4 байта, есть 7
+    CHECK(!rpc::Serializer::deserialize(elements, sizeof(elements), span));
+    CHECK(!rpc::Serializer::deserialize(elements, 5, span));
+    elements[0] = 1;
+    CHECK(rpc::Serializer::deserialize(elements, sizeof(elements), span) && span.size() == 1);
+
+    // Кортеж аргументов: длина должна совпасть точно, без недостающих и лишних байт
+    std::tuple<std::string_view, std::uint16_t> arguments;
+    CHECK(rpc::Serializer::deserialize_tuple(buffer, length, arguments));
+    CHECK(std::get<0>(arguments) == "abcdef" && std::get<1>(arguments) == 0x1234);
+    CHECK(!rpc::Serializer::deserialize_tuple(buffer, length - 1, arguments));
+    CHECK(!rpc::Serializer::deserialize_tuple(buffer, length + 1, arguments));
+
+    // После первой ошибки Reader отклоняет и чтения, которые поместились бы
+    rpc::Reader in(buffer, 3);
+    CHECK(in.take(4) == nullptr && in.take(1) == nullptr && !in.ok());
+
+    // std::optional: флаг наличия без самого значения
+    std::uint8_t present[] = {1, 0x01};
+    std::optional<std::uint16_t> maybe;
+    CHECK(!rpc::Serializer::deserialize(present, sizeof(present), maybe));
+}
+
+// Крайние значения целого типа в Encoding::Compact
+template<typename T>
+bool compact_limits() {
+    using Limits = std::numeric_limits<T>;
+    using Codec = rpc::Codec<T, rpc::Encoding::Compact>;
+    const T values[] = {Limits::min(), Limits::max(), T{0}, T{1}, static_cast<T>(Limits::max() / 2)};
+    for (T value : values) {
+        if (!round_trips<rpc::CompactSerializer>(value)) {
+            return false;
+        }
+    }
+    return Codec::size(Limits::max()) == Codec::MaxSize;
+}
+
+// Encoding::Compact: varint и zigzag, отказ на слишком длинных и усеченных значениях
+void test_compact() {
+    std::uint8_t buffer[protocol::Packet::MaxSize]{};
+    CHECK(rpc::CompactSerializer::serialize(std::uint16_t{300}, buffer) - buffer == 2);
+    CHECK(buffer[0] == 0xAC && buffer[1] == 0x02);
+    CHECK(rpc::CompactSerializer::serialize(std::int32_t{-1}, buffer) - buffer == 1 && buffer[0] == 0x01);
+    CHECK(rpc::CompactSerializer::serialize(std::int32_t{1}, buffer) - buffer == 1 && buffer[0] == 0x02);
+    CHECK(rpc::CompactSerializer::serialize(std::int32_t{-64}, buffer) - buffer == 1 && buffer[0] == 0x7F);
+    CHECK(rpc::CompactSerializer::size_of(std::numeric_limits<std::int32_t>::min()) == 5);
+    CHECK(rpc::CompactSerializer::size_of(std::uint8_t{0xFF}) == 1);           // Байт не кодируется varint
+
+    CHECK(compact_limits<std::int16_t>() && compact_limits<std::uint16_t>());
+    CHECK(compact_limits<std::int32_t>() && compact_limits<std::uint32_t>());
+    CHECK(compact_limits<std::int64_t>() && compact_limits<std::uint64_t>());
+    CHECK(round_trips<rpc::CompactSerializer>(Mode::Idle));
+
+    // Наибольшее значение uint16_t - 3 байта; биты за пределами типа и четвертый байт отклоняются
+    std::uint16_t value = 0;
+    const std::uint8_t widest[] = {0xFF, 0xFF, 0x03};
+    CHECK(rpc::CompactSerializer::deserialize(widest, sizeof(widest), value) && value == 0xFFFF);
+    const std::uint8_t wide[] = {0xFF, 0xFF, 0x04};
+    CHECK(!rpc::CompactSerializer::deserialize(wide, sizeof(wide), value));
+    const std::uint8_t overlong[] = {0x80, 0x80, 0x80, 0x00};
+    CHECK(!rpc::CompactSerializer::deserialize(overlong, sizeof(overlong), value));
+    std::int32_t signed_value = 0;
+    const std::uint8_t overlong32[] = {0xFF, 0xFF, 0xFF, 0xFF, 0x7F};
+    CHECK(!rpc::CompactSerializer::deserialize(overlong32, sizeof(overlong32), signed_value));
+
+    // Усеченное значение: последний байт с признаком продолжения
+    const std::uint8_t truncated[] = {0xAC};
+    CHECK(!rpc::CompactSerializer::deserialize(truncated, sizeof(truncated), value));
+
+    // Кортеж с varint: длина неизвестна заранее, лишние байты отклоняются
+    std::uint8_t* end = rpc::CompactSerializer::serialize_values(buffer, std::int32_t{-3}, std::uint32_t{100000});
+    std::size_t length = static_cast<std::size_t>(end - buffer);
+    CHECK(length == 1 + 3);
+    std::tuple<std::int32_t, std::uint32_t> arguments;
+    CHECK(rpc::CompactSerializer::deserialize_tuple(buffer, length, arguments));
+    CHECK(std::get<0>(arguments) == -3 && std::get<1>(arguments) == 100000);
+    CHECK(!rpc::CompactSerializer::deserialize_tuple(buffer, length + 1, arguments));
+}
+
+// Агрегатные структуры: поля подряд без выравнивания, вложенные структуры и строки
+void test_structs() {
+    static_assert(rpc::IsReflectable<Telemetry>::value && rpc::field_count<Telemetry>() == 3);
+    CHECK(rpc::Serializer::min_size<Telemetry>() == 7 && sizeof(Telemetry) > 7);
+    CHECK(rpc::Serializer::is_fixed<Telemetry>() && !rpc::Codec<Telemetry>::Plain);
+    CHECK(rpc::Codec<Rgb>::Plain && rpc::Serializer::min_size<Rgb>() == 3);
+
+    // Поля в порядке объявления, float сразу за байтом id
+    std::uint8_t buffer[protocol::Packet::MaxSize]{};
+    const Telemetry telemetry{0x2A, 1.0f, 0x0304};
+    CHECK(rpc::Serializer::serialize(telemetry, buffer) - buffer == 7);
+    float value = 0.0f;
+    std::uint16_t flags = 0;
+    rpc::load_le(buffer + 1, value);
+    rpc::load_le(buffer + 5, flags);
+    CHECK(buffer[0] == 0x2A && value == 1.0f && flags == 0x0304);
+
+    CHECK(same_fields_after_round_trip<rpc::Serializer>(telemetry));
+    CHECK(same_fields_after_round_trip<rpc::CompactSerializer>(telemetry));
+    CHECK(same_fields_after_round_trip<rpc::Serializer>(Rgb{1, 2, 3}));
+
+    const Reading reading{{10, 20, 30}, {7, -0.5f, 0x0001}, "probe", {-300, 300}};
+    Reading result{};
+    CHECK(round_trip<rpc::Serializer>(reading, result));
+    CHECK(result.color.r == 10 && result.color.g == 20 && result.color.b == 30);
+    CHECK(rpc::fields_of(result.telemetry) == rpc::fields_of(reading.telemetry));
+    CHECK(result.label == "probe" && result.offsets == reading.offsets);
+    CHECK(rpc::Serializer::size_of(reading) == 3 + 7 + 1 + 5 + 4);
+    CHECK(rpc::CompactSerializer::size_of(reading) == rpc::Serializer::size_of(reading) - 1);    // flags - 1 байт varint
+
+    // Структура, обрезанная на середине поля
+    CHECK(!rpc::Serializer::deserialize(buffer, 6, result.telemetry));
+}
+
+// Битовая упаковка: поле 0 в младших битах, слово little-endian, лишние биты отклоняются
+void test_packed() {
+    using Flags = rpc::Packed<bool, bool, Led>;
+    static_assert(Flags::Bits == 4 && Flags::Size == 1);
+    std::uint8_t buffer[protocol::Packet::MaxSize]{};
+    CHECK(rpc::Serializer::serialize(Flags(true, false, Led::On), buffer) - buffer == 1);
+    CHECK(buffer[0] == 0x09);
+    CHECK(round_trips<rpc::Serializer>(Flags(false, true, Led::Blink)));
+
+    Flags flags;
+    const std::uint8_t unused_bits[] = {0x19};
+    CHECK(!rpc::Serializer::deserialize(unused_bits, sizeof(unused_bits), flags));
+
+    // 25 бит - 4 байта из 32-битного слова, порядок байт не зависит от узла
+    using Record = rpc::Packed<std::uint8_t, bool, std::uint16_t>;
+    static_assert(Record::Size == 4);
+    CHECK(rpc::Serializer::serialize(Record(0xAB, true, 0x1234), buffer) - buffer == 4);
+    CHECK(buffer[0] == 0xAB && buffer[1] == 0x69 && buffer[2] == 0x24 && buffer[3] == 0x00);
+    CHECK(round_trips<rpc::CompactSerializer>(Record(0xFF, false, 0xFFFF)));
+    Record record;
+    CHECK(!rpc::Serializer::deserialize(buffer, 3, record));
+
+    // Значение шире поля усекается
+    Flags truncated;
+    CHECK(truncated.unpack(Flags(false, false, static_cast<Led>(7)).pack()) && truncated.get<2>() == static_cast<Led>(3));
+
+    // 40 бит - 5 байт из 64-битного слова
+    using Wide = rpc::Packed<std::uint32_t, std::uint8_t>;
+    static_assert(Wide::Size == 5);
+    CHECK(round_trips<rpc::Serializer>(Wide(0xDEADBEEF, 0x5A)));
+}
+
+// Квантование: шаг (Max - Min) / max(Storage), насыщение к границам
+void test_quantized() {
+    using Temperature = rpc::Quantized<-40, 125>;
+    CHECK(Temperature(-40.0f).encode() == 0 && Temperature(125.0f).encode() == 0xFFFF);
+    CHECK(Temperature(200.0f).encode() == 0xFFFF && Temperature(-100.0f).encode() == 0);
+    CHECK(Temperature(std::nanf("")).encode() == 0);
+
+    bool within_step = true;
+    for (float value = -40.0f; value <= 125.0f; value += 0.37f) {
+        Temperature result;
+        within_step = within_step && round_trip<rpc::Serializer>(Temperature(value), result)
+                      && std::fabs(result.value() - value) <= Temperature::Step / 2 + 1e-4f;
+    }
+    CHECK(within_step);
+
+    using Percent = rpc::Quantized<0, 1000, std::uint8_t, 10>;
+    CHECK(rpc::Serializer::min_size<Percent>() == 1);
+    Percent percent;
+    CHECK(round_trip<rpc::Serializer>(Percent(50.0f), percent) && std::fabs(percent.value() - 50.0f) <= Percent::Step / 2 + 1e-4f);
+}
+
+// IEEE 754 binary16: точные значения, переполнение, денормализованные, NaN
+void test_half() {
+    CHECK(rpc::Half(1.0f).encode() == 0x3C00 && rpc::Half(-2.0f).encode() == 0xC000);
+    CHECK(rpc::Half(65504.0f).encode() == 0x7BFF && rpc::Half(1e5f).encode() == 0x7C00);
+    CHECK(rpc::Half(std::ldexp(1.0f, -24)).encode() == 0x0001);
+    CHECK(rpc::Half(1.0f + std::ldexp(1.0f, -11)).encode() == 0x3C00);     // Середина - к четному
+
+    rpc::Half half;
+    half.decode(0x7E00);
+    CHECK(std::isnan(half.value()));
+    half.decode(0x0001);
+    CHECK(half.value() == std::ldexp(1.0f, -24));
+
+    bool within_precision = true;
+    for (float value = -1000.0f; value <= 1000.0f; value += 3.7f) {
+        rpc::Half result;
+        within_precision = within_precision && round_trip<rpc::Serializer>(rpc::Half(value), result)
+                           && std::fabs(result.value() - value) <= std::fabs(value) * std::ldexp(1.0f, -11) + 1e-7f;
+    }
+    CHECK(within_precision);
+
+    std::uint8_t buffer[protocol::Packet::MaxSize]{};
+    const Status status{{true, false, Led::Blink}, 25.0f, 1.5f};
+    CHECK(rpc::Serializer::serialize(status, buffer) - buffer == 5);
+    Status result{};
+    CHECK(rpc::Serializer::deserialize(buffer, 5, result));
+    CHECK(result.flags == status.flags && std::fabs(result.temperature.value() - 25.0f) <= Status{}.temperature.Step
+          && result.current.value() == 1.5f);
+}
+
+// Декодирование блока: выборки совпадают с samples[0..count) побитово
+bool decodes_to(const rpc::TimeSeriesBlock& block, const rpc::Sample* samples, std::size_t count) {
+    rpc::TimeSeriesDecoder decoder(block);
+    rpc::Sample sample{};
+    for (std::size_t i = 0; i < count; ++i) {
+        if (!decoder.next(sample) || sample.timestamp != samples[i].timestamp
+            || std::memcmp(&sample.value, &samples[i].value, sizeof(float)) != 0) {
+            return false;
+        }
+    }
+    return !decoder.next(sample);
+}
+
+// Временные ряды (Gorilla): все диапазоны разности разностей и окна XOR
+void test_timeseries() {
+    const rpc::Sample samples[] = {
+        {1000, 21.5f}, {1100, 21.5f}, {1200, 21.5f},           // Равномерный шаг, повтор значения
+        {1300, 21.25f}, {1400, 21.375f},                        // XOR в окне предыдущего
+        {1463, -3.0f}, {1800, 1e-30f}, {4000, std::nanf("")},   // dod 7, 9 и 12 бит, новое окно
+        {4000, 0.0f}, {0xFFFFFF00, -0.0f}, {0x00000010, 1e30f},  // Нулевой шаг, прямая разность, переполнение счетчика
+    };
+    constexpr std::size_t Count = sizeof(samples) / sizeof(samples[0]);
+
+    rpc::TimeSeriesEncoder encoder;
+    bool appended = true;
+    for (const rpc::Sample& sample : samples) {
+        appended = appended && encoder.append(sample.timestamp, sample.value);
+    }
+    CHECK(appended && encoder.count() == Count);
+    CHECK(decodes_to(encoder.block(), samples, Count));
+
+    // Блок в кадре указывает в принятый буфер
+    std::uint8_t buffer[protocol::Packet::MaxSize]{};
+    std::uint8_t* end = rpc::Serializer::serialize(encoder.block(), buffer);
+    CHECK(end - buffer == static_cast<std::ptrdiff_t>(2 + encoder.block().length()));
+    rpc::TimeSeriesBlock received;
+    CHECK(rpc::Serializer::deserialize(buffer, static_cast<std::size_t>(end - buffer), received));
+    CHECK(received.data() == buffer + 2 && decodes_to(received, samples, Count));
+    CHECK(!rpc::Serializer::deserialize(buffer, static_cast<std::size_t>(end - buffer) - 1, received));
+
+    // Усеченный поток: декодер останавливается на поврежденной выборке, а не читает за буфер
+    rpc::TimeSeriesBlock truncated(encoder.block().data(), encoder.block().length() / 2, Count);
+    rpc::TimeSeriesDecoder decoder(truncated);
+    rpc::Sample sample{};
+    std::size_t decoded = 0;
+    while (decoder.next(sample)) {
+        ++decoded;
+    }
+    CHECK(decoded > 0 && decoded < Count && !decoder.next(sample));
+
+    // Код «в окне предыдущего XOR», когда окна еще нет
+    std::uint8_t invalid[9]{};
+    rpc::BitWriter writer(invalid, sizeof(invalid));
+    CHECK(writer.write(1000, 32) && writer.write(0, 32) && writer.write(0, 1) && writer.write(0x2, 2));
+    rpc::TimeSeriesDecoder invalid_decoder(rpc::TimeSeriesBlock(invalid, writer.bytes(), 2));
+    CHECK(invalid_decoder.next(sample) && !invalid_decoder.next(sample));
+}
+
+// Заполненный блок: выборка, которая не помещается, не меняет кодировщик
+void test_timeseries_full_block() {
+    rpc::Sample samples[rpc::TimeSeriesEncoder::MaxSamples]{};
+    rpc::TimeSeriesEncoder encoder(rpc::TimeSeriesEncoder::capacity_for(8));
+    std::size_t count = 0;
+    for (; count < rpc::TimeSeriesEncoder::MaxSamples; ++count) {
+        samples[count] = {static_cast<std::uint32_t>(count * 37 + (count % 3) * 500), static_cast<float>(count) * 1.1f};
+        if (!encoder.append(samples[count].timestamp, samples[count].value)) {
+            break;
+        }
+    }
+    CHECK(count > 1 && count < rpc::TimeSeriesEncoder::MaxSamples);
+    CHECK(encoder.count() == count);
+    CHECK(encoder.block().length() <= rpc::TimeSeriesEncoder::capacity_for(8));
+    CHECK(decodes_to(encoder.block(), samples, count));
+
+    // Повторная попытка тоже отклоняется, блок не меняется
+    std::size_t length = encoder.block().length();
+    CHECK(!encoder.append(samples[count].timestamp, samples[count].value));
+    CHECK(encoder.block().length() == length && decodes_to(encoder.block(), samples, count));
+
+    // Новый блок начинается с отклоненной выборки
+    encoder.reset();
+    CHECK(encoder.empty() && encoder.append(samples[count].timestamp, samples[count].value));
+    CHECK(decodes_to(encoder.block(), samples + count, 1));
+
+    CHECK(rpc::TimeSeriesEncoder::capacity_for(rpc::TimeSeriesEncoder::MaxBytes) == 0);
+}
+
+// Распаковка сжатых данных побайтно, как в парсере; пустой результат - ошибка в данных
+std::vector<std::uint8_t> decompress(const std::uint8_t* data, std::size_t length, std::size_t capacity) {
+    std::vector<std::uint8_t> out(capacity);
+    protocol::LzssDecoder decoder;
+    decoder.reset(out.data(), out.size());
+    for (std::size_t i = 0; i < length; ++i) {
+        decoder.feed(data[i]);
+    }
+    out.resize(decoder.failed() ? 0 : decoder.length());
+    return out;
+}
+
+// Сжатие и распаковка length байт; false если сжатие не сократило данные или они не совпали
+bool compresses(const std::uint8_t* data, std::size_t length) {
+    std::uint8_t packed[protocol::Packet::MaxSize]{};
+    std::size_t packed_length = protocol::Lzss::compress(data, length, packed, length - 1);
+    return packed_length > 0 && decompress(packed, packed_length, length) == std::vector<std::uint8_t>(data, data + length);
+}
+
+// Канал, запоминающий отправленные байты
+class Capture : public drivers::Serial {
+public:
+    bool write(const std::uint8_t* data, std::size_t length) override {
+        bytes.insert(bytes.end(), data, data + length);
+        return true;
+    }
+    bool try_write(const std::uint8_t* data, std::size_t length) override {
+        return !busy && write(data, length);
+    }
+    void set_rx_callback(RxCallback, void*) override {}
+
+    std::vector<std::uint8_t> bytes;    // Отправленные байты
+    bool busy{false};                   // Канал занят передачей другой задачи (try_write отказывает)
+};
+
+// Сжатие полезных данных кадров (LZSS): сжатие, распаковка и отказ на поврежденных данных
+void test_lzss() {
+    constexpr std::size_t Size = protocol::Packet::MaxSize;
+    std::uint8_t text[Size];
+    const char line[] = "I 1042 uart: rx ok; ";
+    for (std::size_t i = 0; i < Size; ++i) {
+        text[i] = static_cast<std::uint8_t>(line[i % (sizeof(line) - 1)]);
+    }
+    CHECK(compresses(text, Size));
+    CHECK(compresses(text, protocol::Lzss::Threshold));
+
+    std::uint8_t zeros[Size]{};                                 // Повторы с перекрытием (смещение 1)
+    CHECK(compresses(zeros, Size));
+
+    // Случайные данные не сжимаются - кадр уходит как есть
+    std::uint8_t noise[Size];
+    std::uint32_t state = 0x12345678;
+    for (std::uint8_t& byte : noise) {
+        state = state * 1664525u + 1013904223u;
+        byte = static_cast<std::uint8_t>(state >> 24);
+    }
+    std::uint8_t packed[Size]{};
+    CHECK(protocol::Lzss::compress(noise, Size, packed, Size - 1) == 0);
+
+    // Повтор раньше начала данных: 0 | смещение - 1 = 4 | длина - MinMatch = 0
+    const std::uint8_t early[] = {0x02, 0x00};
+    CHECK(decompress(early, sizeof(early), Size).empty());
+    // Литерал 'A', затем повтор со смещением 2 при одном распакованном байте
+    const std::uint8_t behind[] = {0xA0, 0x80, 0x40};
+    CHECK(decompress(behind, sizeof(behind), Size).empty());
+
+    // Распакованные данные длиннее буфера получателя
+    std::size_t packed_length = protocol::Lzss::compress(zeros, Size, packed, Size - 1);
+    CHECK(packed_length > 0 && decompress(packed, packed_length, Size - 1).empty());
+}
+
+// Кадр целиком: Sender сжимает согласованный канал, Parser распаковывает при приеме
+void test_compressed_frames() {
+    std::uint8_t payload[protocol::Packet::MaxSize];
+    payload[0] = static_cast<std::uint8_t>(rpc::MessageType::Request);
+    payload[1] = 42;
+    for (std::size_t i = 2; i < sizeof(payload); ++i) {
+        payload[i] = static_cast<std::uint8_t>("set_gain:0.50;"[i % 14]);
+    }
+
+    Capture plain;
+    CHECK(protocol::Sender(plain).send_transport(payload, sizeof(payload), 42, rpc::MessageType::Request));
+    CHECK(plain.bytes.size() == protocol::Frame::HeaderSize + sizeof(payload) + protocol::Frame::TrailerSize);
+
+    Capture compressed;
+    compressed.set_features(static_cast<std::uint8_t>(rpc::LinkFeature::Compression));
+    CHECK(protocol::Sender(compressed).send_transport(payload, sizeof(payload), 42, rpc::MessageType::Request));
+    CHECK(compressed.bytes.size() < plain.bytes.size());
+    CHECK(compressed.bytes.size() > 3 && ((compressed.bytes[2] << 8) & protocol::Packet::CompressedFlag) != 0);
+
+    // Оба кадра принимаются одинаково: получатель видит исходные данные
+    for (const Capture* channel : {&plain, &compressed}) {
+        std::vector<std::uint8_t> received;
+        Capture input;
+        protocol::Parser parser(input, [](const protocol::Packet& packet, void* user_data) {
+            static_cast<std::vector<std::uint8_t>*>(user_data)->assign(packet.data, packet.data + packet.data_length);
+        }, &received);
+        for (std::uint8_t byte : channel->bytes) {
+            parser.process_byte(byte);
+        }
+        CHECK(received == std::vector<std::uint8_t>(payload, payload + sizeof(payload)));
+        CHECK(parser.nacks_sent() == 0);
+    }
+
+    // Поврежденные сжатые данные: кадр отбрасывается, отправителю уходит Nack
+    std::vector<std::uint8_t> received;
+    Capture input;
+    protocol::Parser parser(input, [](const protocol::Packet& packet, void* user_data) {
+        static_cast<std::vector<std::uint8_t>*>(user_data)->assign(packet.data, packet.data + packet.data_length);
+    }, &received);
+    compressed.bytes[protocol::Frame::HeaderSize + 4] ^= 0x10;
+    for (std::uint8_t byte : compressed.bytes) {
+        parser.process_byte(byte);
+    }
+    CHECK(received.empty());
+    CHECK(parser.nacks_sent() == (protocol::Parser::NackEnabled ? 1u : 0u));
+}
+
+// Отпечатки сигнатур: значение фиксировано (совпадает на обоих концах канала), код типа - формат в кадре
+void test_signatures() {
+    using rpc::signature_of;
+    static_assert(signature_of<std::int32_t, std::int32_t, std::int32_t>() == 0xB78B);
+    static_assert(signature_of<void, std::string>() == signature_of<void, std::string_view>());
+    static_assert(signature_of<void, const std::string&>() == signature_of<void, std::string>());
+    static_assert(signature_of<void, std::int16_t>() != signature_of<void, std::int32_t>());
+    static_assert(signature_of<void, std::int32_t>() != signature_of<void, std::uint32_t>());
+    static_assert(signature_of<std::int32_t, std::int32_t>() != signature_of<void, std::int32_t, std::int32_t>());
+    static_assert(signature_of<void, Telemetry>() == signature_of<void, rpc::FieldTypesOf<Telemetry>>());
+    static_assert(signature_of<void, char>() != signature_of<void, std::int8_t>());
+    static_assert(signature_of<void, char>() != signature_of<void, std::uint8_t>());
+
+    // Отпечаток в запросе - в порядке байт кадра
+    std::uint8_t bytes[2]{};
+    std::uint16_t signature = signature_of<std::int32_t, std::int32_t, std::int32_t>();
+    CHECK(rpc::write_signature(bytes, signature) == bytes + rpc::SignatureSize);
+    CHECK(rpc::signature_matches(bytes, signature));
+    CHECK(rpc::SignatureSize == 0 || !rpc::signature_matches(bytes, signature_of<void, std::string>()));
+    if (rpc::SignatureSize != 0) {
+        CHECK(bytes[WireBigEndian ? 0 : 1] == 0xB7 && bytes[WireBigEndian ? 1 : 0] == 0x8B);
+    }
+}
+
+// Прием байтов канала парсером
+void receive(protocol::Parser& parser, const std::vector<std::uint8_t>& bytes) {
+    for (std::uint8_t byte : bytes) {
+        parser.process_byte(byte);
+    }
+}
+
+// Сохранение данных принятого пакета (последнего) в std::vector user_data
+void store_packet(const protocol::Packet& packet, void* user_data) {
+    static_cast<std::vector<std::uint8_t>*>(user_data)->assign(packet.data, packet.data + packet.data_length);
+}
+
+// Nack на поврежденный кадр: служебный кадр Nack | seq | type без ожидания канала, занятый канал - без Nack
+void test_nack() {
+    const std::uint8_t payload[] = {static_cast<std::uint8_t>(rpc::MessageType::Request), 7, 'a', 'd', 'd', 0, 1, 2};
+    Capture frame;
+    CHECK(protocol::Sender(frame).send_transport(payload, sizeof(payload), 7, rpc::MessageType::Request));
+    frame.bytes[protocol::Frame::HeaderSize + 4] ^= 0x01;             // Поврежден байт имени, type | seq целы
+
+    std::vector<std::uint8_t> received;
+    Capture link;
+    protocol::Parser parser(link, store_packet, &received);
+    receive(parser, frame.bytes);
+    CHECK(received.empty());
+    if (!protocol::Parser::NackEnabled) {
+        CHECK(link.bytes.empty());
+        return;
+    }
+    CHECK(parser.nacks_sent() == 1);
+
+    std::vector<std::uint8_t> nack;
+    Capture unused;
+    protocol::Parser reader(unused, store_packet, &nack);
+    receive(reader, link.bytes);
+    CHECK(nack == std::vector<std::uint8_t>{static_cast<std::uint8_t>(rpc::MessageType::Nack), 7,
+                                            static_cast<std::uint8_t>(rpc::MessageType::Request)});
+
+    link.bytes.clear();
+    link.busy = true;
+    receive(parser, frame.bytes);
+    CHECK(link.bytes.empty() && parser.nacks_sent() == 1);
+}
+
+// Hello без reply: возможности записываются в канал, ответ Hello - без ожидания канала, занятый канал - без ответа
+void test_hello() {
+    const std::uint8_t hello[] = {static_cast<std::uint8_t>(rpc::MessageType::Hello), 0,
+                                  static_cast<std::uint8_t>(rpc::LinkFeature::Compression), 0};
+    Capture frame;
+    CHECK(protocol::Sender(frame).send_transport(hello, sizeof(hello), 0, rpc::MessageType::Hello));
+
+    std::vector<std::uint8_t> received;
+    Capture link;
+    protocol::Parser parser(link, store_packet, &received);
+    receive(parser, frame.bytes);
+    CHECK(received.empty());                                            // Сообщение канала - получателям не передается
+    CHECK(link.features() == protocol::Parser::LocalFeatures);
+
+    // Ответ Hello принимает парсер другой стороны: возможности записываются, ответа на ответ нет
+    Capture peer;
+    protocol::Parser reader(peer, store_packet, &received);
+    receive(reader, link.bytes);
+    CHECK(link.bytes.size() == protocol::Frame::HeaderSize + sizeof(hello) + protocol::Frame::TrailerSize);
+    CHECK(peer.features() == protocol::Parser::LocalFeatures && peer.bytes.empty());
+
+    link.bytes.clear();
+    link.set_features(0);
+    link.busy = true;
+    receive(parser, frame.bytes);
+    CHECK(link.bytes.empty() && link.features() == protocol::Parser::LocalFeatures);
+}
+
+} // namespace
+
+int main() {
+    test_byte_order();
+    test_scalars<rpc::Serializer>();
+    test_scalars<rpc::CompactSerializer>();
+    test_arrays();
+    test_tuples();
+    test_variable_length();
+    test_bounds();
+    test_compact();
+    test_structs();
+    test_signatures();
+    test_packed();
+    test_quantized();
+    test_half();
+    test_timeseries();
+    test_timeseries_full_block();
+    test_lzss();
+    test_compressed_frames();
+    test_nack();
+    test_hello();
+
+    std::printf("%d checks, %d failed%s\n", g_checks, g_failures, rpc::SwapBytes ? " (byte swapping)" : "");
+    return g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+namespace drivers {
+
+/**
+ * Абстракция байтового последовательного канала для протокольного уровня
+ *
+ * Parser и Sender работают только через этот интерфейс, поэтому один и тот же
+ *       код протокола собирается и для МК (drivers::Uart), и для хоста
+ *       (последовательный порт, pty, loopback в памяти)
+ * Принятые байты передаются в callback по одному, отправка - целыми кадрами
+ * Канал хранит возможности, согласованные протоколом с другой стороной
+ *       (rpc::LinkFeature: сжатие кадров): их выставляет Parser по сообщению
+ *       Hello, читает Sender - оба работают с каналом, а не друг с другом
+ */
+
+class Serial {
+public:
+    // Тип callback-функции для принятых байтов
+    using RxCallback = void (*)(std::uint8_t, void*);
+
+    // Отправка кадра целиком; true если все байты переданы
+    virtual bool write(const std::uint8_t* data, std::size_t length) = 0;
+    // Отправка короткого кадра без ожидания занятого канала (из контекста приема); false если канал занят
+    virtual bool try_write(const std::uint8_t* data, std::size_t length) { return write(data, length); }
+    // Установка callback'а для принятых байтов
+    virtual void set_rx_callback(RxCallback callback, void* user_data) = 0;
+
+    // Возможности, согласованные с другой стороной канала (битовая маска, 0 - до согласования)
+    std::uint8_t features() const { return m_features; }
+    void set_features(std::uint8_t features) { m_features = features; }
+
+protected:
+    ~Serial() = default;    // Не удаляется через указатель на интерфейс
+
+private:
+    std::uint8_t m_features{0};     // Согласованные возможности (запись байта атомарна)
+};
+
+} // namespace drivers
@@ -3,6 +3,8 @@
 #include "stm32f4xx_hal.h"
 #include "FreeRTOS.h"
 #include "queue.h"
+#include "semphr.h"
+#include "serial.hpp"
 #include "../utils/noncopyable.hpp"
 
 namespace drivers {
@@ -13,17 +15,26 @@ namespace drivers {
  * Механизм работы:
  * 1. HAL прерывание получает байт -> кладет в очередь
  * 2. Задача FreeRTOS читает из очереди -> вызывает пользовательский callback
- * 3. Отправка данных блокирующая с таймаутом
+ * 3. Отправка данных блокирующая с таймаутом, кадры из разных задач
+ *    не перемешиваются (отправка под мьютексом)
  * 
  * Для работы должен быть зарегистрирован в HAL_UART_RxCpltCallback
  */
 
-class Uart : private utils::NonCopyable {
+class Uart : public Serial, private utils::NonCopyable {
 public:
+    // Таймаут отправки кадра через интерфейс Serial
+    static constexpr TickType_t WriteTimeout = pdMS_TO_TICKS(100);
+
     explicit Uart(UART_HandleTypeDef* huart);   // Должен быть вызван после создания объекта для начала приема данных
-    void start();
-    void set_rx_callback(void (*callback)(std::uint8_t, void*), void* user_data);
+    // stack_depth - стек задачи приема в словах: callback разбирает кадры, ответы канала (Nack, Hello) - через try_write
+    void start(std::uint16_t stack_depth = configMINIMAL_STACK_SIZE);
+    void set_rx_callback(RxCallback callback, void* user_data) override;
     bool send(const std::uint8_t* data, std::size_t length, TickType_t timeout);
+    // Отправка кадра с таймаутом WriteTimeout (интерфейс Serial)
+    bool write(const std::uint8_t* data, std::size_t length) override { return send(data, length, WriteTimeout); }
+    // Отправка без ожидания мьютекса передачи: кадр не ставится в очередь за чужой передачей
+    bool try_write(const std::uint8_t* data, std::size_t length) override;
 
     // Геттеры для доступа из HAL_UART_RxCpltCallback
     // HAL функции на C не могут работать с методами C++ напрямую
@@ -37,6 +48,7 @@ private:
     static Uart* global_uart_instance;  // Для доступа из HAL прерываний (C-контекст)
     UART_HandleTypeDef* m_huart;
     QueueHandle_t m_rx_queue;   // Очередь для передачи данных из прерывания в задачу
+    SemaphoreHandle_t m_tx_mutex;   // Защита передачи от одновременной отправки из нескольких задач
     void (*m_rx_callback)(std::uint8_t, void*);
     void* m_rx_user_data;
     std::uint8_t m_rx_byte; // Буфер для приема одного байта в прерывании
@@ -14,6 +14,8 @@ namespace protocol {
 class Crc {
 public:
     static bool validate(const Packet& packet);
+    // Проверка только CRC заголовка: длина кадра достоверна, даже если данные повреждены
+    static bool validate_header(const Packet& packet);
      /**
      * Вычисляет контрольную сумму для данных
      * data Указатель на данные для расчета
@@ -0,0 +1,85 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+// Сжатие полезных данных кадров (0 - отключить, переопределяется через build_flags)
+#ifndef RPC_ENABLE_COMPRESSION
+#define RPC_ENABLE_COMPRESSION 1
+#endif
+
+// Наименьшая длина полезных данных, которые пробуется сжать (переопределяется через build_flags)
+#ifndef RPC_COMPRESSION_THRESHOLD
+#define RPC_COMPRESSION_THRESHOLD 32
+#endif
+
+namespace protocol {
+
+/**
+ * LZSS-сжатие полезных данных одного кадра (семейство heatshrink)
+ *
+ * Поток бит, старшие биты первыми:
+ *       1 + 8 бит              - литерал
+ *       0 + 8 бит + 4 бита     - повтор: смещение назад - 1, длина - MinMatch
+ *       хвост последнего байта - нулевые биты (неполная лексема игнорируется)
+ * Окно - сам кадр (смещение до 256 байт покрывает Packet::MaxSize), поэтому
+ *       ни сжатию, ни распаковке не нужен буфер истории: распаковка пишет
+ *       прямо в Packet::data, сжатие держит на стеке только таблицу
+ *       хэш-цепочек (256 + Packet::MaxSize байт)
+ * Логи и блоки конфигурации (повторяющиеся ключи, выравнивающие пробелы
+ *       и нули) в кадрах по 255 байт сжимаются в 2-3 раза, в кадрах по 64
+ *       байта - на 15-30%; случайные данные не сжимаются, и кадр уходит как есть
+ */
+
+class Lzss {
+public:
+    // Сжатие поддерживается сборкой
+    static constexpr bool Enabled = RPC_ENABLE_COMPRESSION != 0;
+    // Полезные данные короче порога не сжимаются: выигрыш меньше байта-двух
+    static constexpr std::size_t Threshold = RPC_COMPRESSION_THRESHOLD;
+
+    static constexpr unsigned OffsetBits = 8;                                       // Смещение повтора: 1..256
+    static constexpr unsigned LengthBits = 4;                                       // Длина повтора: MinMatch..MaxMatch
+    static constexpr std::size_t MinMatch = 2;                                      // 13 бит повтора против 18 бит двух литералов
+    static constexpr std::size_t MaxMatch = MinMatch + (1u << LengthBits) - 1;
+    static constexpr std::size_t Window = std::size_t{1} << OffsetBits;
+    static constexpr std::size_t HashSize = 256;                                    // Начала хэш-цепочек: хэш двух байт - один байт
+    static_assert(Threshold >= MinMatch, "Compression threshold is shorter than a match");
+
+    /**
+     * Сжатие length байт из in в out
+     * Возвращает длину сжатых данных или 0, если они не помещаются в capacity байт
+     *       (вызывающий передает capacity = length - 1: сжатие, которое не
+     *       сокращает кадр, не выполняется)
+     */
+    static std::size_t compress(const std::uint8_t* in, std::size_t length, std::uint8_t* out, std::size_t capacity);
+};
+
+/**
+ * Потоковая распаковка: байты сжатых данных подаются по одному по мере
+ *       приема (Parser, состояние GetData), результат пишется в буфер получателя
+ * Ошибка (повтор раньше начала данных, переполнение буфера) запоминается,
+ *       остальные байты кадра принимаются и игнорируются
+ */
+
+class LzssDecoder {
+public:
+    // Начало распаковки кадра в out (не больше capacity байт)
+    void reset(std::uint8_t* out, std::size_t capacity);
+    // Очередной байт сжатых данных; false если данные повреждены
+    bool feed(std::uint8_t byte);
+
+    // Распаковано байт
+    std::size_t length() const { return m_length; }
+    // Данные кадра повреждены
+    bool failed() const { return m_failed; }
+
+private:
+    std::uint8_t* m_out{nullptr};       // Буфер распакованных данных (он же окно повторов)
+    std::size_t m_capacity{0};          // Емкость буфера
+    std::size_t m_length{0};            // Распаковано байт
+    std::uint32_t m_bits{0};            // Накопленные, еще не разобранные биты (младшие m_count)
+    unsigned m_count{0};                // Число накопленных бит
+    bool m_failed{false};               // Ошибка в данных кадра
+};
+
+} // namespace protocol
@@ -3,6 +3,11 @@
 #include <string>
 #include "../rpc/types.hpp"
 
+// Наибольшая длина полезных данных кадра (не больше 255: длины внутри сообщений - один байт)
+#ifndef RPC_MAX_PACKET_SIZE
+#define RPC_MAX_PACKET_SIZE 64
+#endif
+
 namespace protocol {
 
 /**
@@ -18,10 +23,13 @@ namespace protocol {
  * [N+1]  = data_crc          - CRC полезных данных
  * 
  * Порядок байтов: little-endian (l_l | l_h << 8)
+ * Старший бит длины (CompressedFlag) - данные сжаты LZSS (lzss.hpp), длина -
+ *       сжатых данных в канале; CRC данных считается по распакованным
  */
 
 struct Packet {
-    static constexpr std::size_t MaxSize = 64;
+    static constexpr std::size_t MaxSize = RPC_MAX_PACKET_SIZE;
+    static constexpr std::uint16_t CompressedFlag = 0x8000;   // Флаг сжатых данных в поле длины
     bool valid{false};
     std::uint16_t length{0}; // 16-bit length (l_l | l_h << 8)
     std::uint8_t header_crc{0}; // CRC of header (0xFA, l_l, l_h)
@@ -31,5 +39,6 @@ struct Packet {
     std::uint8_t crc{0}; // CRC of data
     std::string func_name;
     rpc::MessageType type;
+    rpc::Encoding encoding{rpc::Encoding::Fixed};  // Кодирование полезных данных (флаг CompactFlag снят с data[0])
 };
 } // namespace protocol
@@ -1,36 +1,71 @@
 #pragma once
 #include <cstdint>
 #include "packet.hpp"
+#include "lzss.hpp"
 #include "../utils/noncopyable.hpp"
-#include "../drivers/uart.hpp"
+#include "../drivers/serial.hpp"
 #include "../rpc/types.hpp"
 
+// Ответ Nack на кадр с поврежденными данными (0 - отключить, переопределяется через build_flags)
+#ifndef RPC_ENABLE_NACK
+#define RPC_ENABLE_NACK 1
+#endif
+
 namespace protocol {
 
  /**
  * Конечный автомат для разбора бинарных пакетов протокола из UART
  * 
  * Реализует парсинг пакетов в формате:
- *       [0xFA][length_low][length_high][header_crc][seq][data...][data_crc][0xFE]
+ *       [0xFA][length_low][length_high][header_crc][0xFB][data...][data_crc][0xFE]
+ * Полезные данные начинаются с заголовка сообщения type | seq | ...,
+ *       из которого заполняются Packet::type и Packet::seq; флаг CompactFlag
+ *       снимается с байта типа и переносится в Packet::encoding
  * 
  * Не потокобезопасен - должен вызываться из одного контекста
+ * Не зависит от HAL: байты приходят из любого drivers::Serial
+ *
+ * Если CRC заголовка верна, а данные повреждены, кадр потерян, но его длина
+ *       и обычно type | seq известны - парсер сразу отвечает в тот же канал
+ *       Nack | seq | type, и другая сторона повторяет кадр из истории передачи
+ *       через один RTT вместо ожидания таймаута
+ *
+ * Сжатые кадры (Packet::CompressedFlag) распаковываются по мере приема прямо
+ *       в Packet::data, получатели видят обычный пакет
+ * Сообщение Hello | seq | features | reply (согласование возможностей канала)
+ *       обрабатывается самим парсером: возможности другой стороны, которые
+ *       поддерживает и эта сборка, записываются в канал (Serial::set_features)
+ *       для Sender; на Hello без reply парсер отвечает своим Hello, поэтому
+ *       согласование завершается, какая бы сторона ни начала его первой
+ *       (и после перезапуска любой из сторон)
+ * Свои ответы (Nack, Hello) парсер отправляет без ожидания канала
+ *       (Sender::send_control): контекст приема не блокируется передачей
+ *       другой задачи, а пропущенный ответ стоит другой стороне лишь таймаута
  */
 
 class Parser : private utils::NonCopyable {
 public:
     // Тип callback-функции для обработки распарсенных пакетов
     using PacketHandler = void (*)(const Packet&, void*);
+    // Отправка Nack на поврежденные кадры
+    static constexpr bool NackEnabled = RPC_ENABLE_NACK != 0;
+    // Возможности канала, которые поддерживает эта сборка
+    static constexpr std::uint8_t LocalFeatures = Lzss::Enabled ? static_cast<std::uint8_t>(rpc::LinkFeature::Compression) : 0;
 
     // Конструктор парсера
-    explicit Parser(drivers::Uart& uart, PacketHandler handler, void* user_data = nullptr);
+    explicit Parser(drivers::Serial& uart, PacketHandler handler, void* user_data = nullptr);
     void process_byte(std::uint8_t byte);
-    // Возвращает ссылку на UART драйвер
-    drivers::Uart& get_uart() { return m_uart; }
+    // Возвращает ссылку на канал, из которого принимаются байты
+    drivers::Serial& get_uart() { return m_uart; }
     // Устанавливает обработчик пакетов
     void set_handler(PacketHandler handler, void* user_data = nullptr) {
         m_handler = handler;
         m_user_data = user_data;
     }
+    // Число отправленных Nack
+    std::uint32_t nacks_sent() const { return m_nacks_sent; }
+    // Начало согласования возможностей канала (при установке связи; канал уже открыт)
+    bool negotiate();
 
 private:
     enum class State {
@@ -38,18 +73,30 @@ private:
         GetLengthLow,       // Получение младшего байта
         GetLengthHigh,      // Получение старшего байта
         GetHeaderCrc,       // Получение CRC заголовка
-        GetDataStart,       // Получение стартовой нагрузки
+        GetDataStart,       // Ожидание маркера начала данных 0xFB
         GetData,            // Получение полезной нагрузки
         GetFooterCrc,       // Получение CRC данных
         GetStopByte         // Ожидание стопового байта 0xFE
     };
 
-    drivers::Uart& m_uart;              // Ссылка на драйвер UART для приема данных
+    drivers::Serial& m_uart;            // Канал, из которого принимаются данные
     PacketHandler m_handler;            // Callback для обработки готовых пакетов
     void* m_user_data;                  // Пользовательские данные для callback
     State m_state{State::GetHeader};    // Текущее состояние парсера
     Packet m_packet;                    // Текущий обрабатываемый пакет
     std::size_t m_index{0};             // Индекс для накопления данных
+    std::size_t m_length{0};            // Длина данных кадра в канале (без флага сжатия)
+    std::size_t m_received{0};          // Принято байт данных в канале
+    bool m_compressed{false};           // Данные текущего кадра сжаты
+    LzssDecoder m_decoder;              // Распаковка сжатых данных в m_packet.data
+    std::uint32_t m_nacks_sent{0};      // Число отправленных Nack
+
+    // Ответ Nack на текущий (поврежденный) кадр
+    void send_nack();
+    // Обработка Hello: запись согласованных возможностей, ответ на Hello без reply
+    void handle_hello();
+    // Отправка Hello | 0 | LocalFeatures | reply
+    bool send_hello(bool reply);
 };
 
 } // namespace protocol
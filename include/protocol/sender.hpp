@@ -1,7 +1,8 @@
 #pragma once
 #include <cstdint>
 #include "packet.hpp"
-#include "../drivers/uart.hpp"
+#include "lzss.hpp"
+#include "../drivers/serial.hpp"
 #include "../utils/noncopyable.hpp"
 #include "../rpc/types.hpp"
 
@@ -11,22 +12,70 @@ namespace protocol {
  * Класс для формирования и отправки бинарных пакетов протокола через UART
  * 
  * Формирует пакеты в формате:
- *       [0xFA][length_low][length_high][header_crc][seq][data...][data_crc][0xFE]
+ *       [0xFA][length_low][length_high][header_crc][0xFB][data...][data_crc][0xFE]
  * 
- * Автоматически рассчитывает CRC заголовка и данных,
- *          управляет порядковыми номерами пакетов
+ * Автоматически рассчитывает CRC заголовка и данных
+ * Не зависит от HAL: кадр отправляется в любой drivers::Serial
+ *
+ * Если другая сторона согласовала сжатие (rpc::LinkFeature::Compression
+ *       в Serial::features), send сжимает полезные данные кадров не короче
+ *       Lzss::Threshold; кадр, который сжатие не сокращает, уходит как есть
+ * Сжатие выполняется при отправке, а не в seal: кадры в истории передачи
+ *       (повтор по Nack, объединение одинаковых запросов) остаются несжатыми
+ * Сжатие занимает на стеке отправляющей задачи сжатый кадр и хэш-цепочки
+ *       (SendStackBytes): стек задач, вызывающих send (сервис, задача повторов
+ *       клиента), увеличивается на него
+ * Служебные кадры контекста приема (Nack, ответ Hello) отправляет send_control: без
+ *       сжатия, из буфера по размеру кадра и без ожидания занятого канала
  */
 
+/**
+ * Буфер исходящего кадра
+ *
+ * Полезные данные записываются сразу на свое место (payload()), после чего
+ *       Sender::seal дописывает заголовок, CRC и стоповый байт вокруг них -
+ *       без промежуточных буферов и копирования
+ */
+
+struct Frame {
+    static constexpr std::size_t HeaderSize = 5;                            // 0xFA | l_l | l_h | header_crc | 0xFB
+    static constexpr std::size_t TrailerSize = 2;                           // data_crc | 0xFE
+    static constexpr std::size_t Capacity = HeaderSize + Packet::MaxSize + TrailerSize;
+
+    std::uint8_t bytes[Capacity]{};     // Кадр целиком
+    std::size_t length{0};              // Длина готового кадра (0 - кадр не сформирован)
+
+    // Место полезных данных в кадре
+    std::uint8_t* payload() { return bytes + HeaderSize; }
+    const std::uint8_t* payload() const { return bytes + HeaderSize; }
+};
+
 class Sender : private utils::NonCopyable {
 public:
+    // Стек send сверх вызывающего кода: сжатый кадр, таблицы Lzss::compress и кадры вызовов (0 без сжатия)
+    static constexpr std::size_t SendStackBytes = Lzss::Enabled ? sizeof(Frame) + Lzss::HashSize + Packet::MaxSize + 96 : 0;
+    // Наибольшие полезные данные служебного кадра (Hello | seq | features | reply)
+    static constexpr std::size_t ControlSize = 4;
+
     // Конструктор отправителя
-    explicit Sender(drivers::Uart& uart);
+    explicit Sender(drivers::Serial& uart);
     // Отправка данных через транспортный протокол
     bool send_transport(const std::uint8_t* data, std::size_t length, std::uint8_t seq, rpc::MessageType type);
+    // Отправка кадра, сформированного seal
+    bool send(const Frame& frame);
+    // Отправка служебного кадра без ожидания канала (Serial::try_write); false если канал занят
+    bool send_control(const std::uint8_t* data, std::size_t length);
+
+    // Оформление кадра вокруг length байт, уже записанных в frame.payload()
+    static bool seal(Frame& frame, std::size_t length);
 
 private:
-    drivers::Uart& m_uart;          // Ссылка на драйвер UART для отправки данных
-    std::uint8_t m_sequence{0};     // Текущий порядковый номер пакета
+    // Сжатие оформленного кадра в packed; false если сжатие не сокращает кадр
+    static bool compress(const Frame& frame, Frame& packed);
+    // Заголовок и хвост кадра вокруг length байт полезных данных; длина кадра
+    static std::size_t envelope(std::uint8_t* packet, std::size_t length, std::uint16_t length_field, std::uint8_t data_crc);
+
+    drivers::Serial& m_uart;        // Канал для отправки данных
 };
 
 } // namespace protocol
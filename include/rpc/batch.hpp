@@ -0,0 +1,108 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include "FreeRTOS.h"
+#include "types.hpp"
+#include "method.hpp"
+#include "serializer.hpp"
+#include "signature.hpp"
+#include "../protocol/packet.hpp"
+
+namespace rpc {
+
+class Client;
+
+/**
+ * Пакет RPC вызовов, отправляемый одним кадром
+ *
+ * Каждый Client::call платит за заголовок кадра, две CRC и полный круг
+ *       запрос-ответ; пакет собирает N вызовов в один запрос, сервис выполняет
+ *       их по порядку и отвечает одним сводным кадром
+ *
+ * Формат запроса:  BatchRequest | seq | count | (name\0 | signature | args_length | args...) x count
+ *       (функция из IDL - \0 | id вместо name\0, см. method.hpp)
+ * Формат ответа:   BatchResponse | seq | count | (status | result_length | result...) x count
+ * Все вызовы пакета кодируются в кодировании канала клиента (Client::set_encoding)
+ *
+ * Пример:
+ *     auto batch = client.batch();
+ *     if (batch.add<int32_t>("add", 1, 2).add<float>("get_temperature").send()) {
+ *         int32_t sum = batch.result<int32_t>(0);
+ *         float temperature = batch.result<float>(1);
+ *     }
+ */
+
+class Batch {
+public:
+    // Максимальное число вызовов в пакете (совпадает с Service::MaxBatchCalls)
+    static constexpr std::size_t MaxCalls = 8;
+
+    explicit Batch(Client& client, Encoding encoding = Encoding::Fixed) : m_client(client), m_encoding(encoding) {}
+
+    // Добавление вызова в пакет; при переполнении кадра пакет помечается как ошибочный
+    template<typename Result, typename... Args>
+    Batch& add(const Target& target, Args... args) {
+        visit_encoding(m_encoding, [&](auto serializer) {
+            using Codec = decltype(serializer);
+            std::size_t args_length = Codec::size_of_values(args...);
+            std::size_t call_length = target.size() + SignatureSize + 1 + args_length;         // name\0 + signature + args_length + args
+            if (m_count >= MaxCalls || m_length + call_length > protocol::Packet::MaxSize) {
+                m_overflow = true;
+                return;
+            }
+            target.write(m_request + m_length);
+            m_length += target.size();
+            write_signature(m_request + m_length, signature_of<Result, Args...>());
+            m_length += SignatureSize;
+            m_request[m_length++] = static_cast<std::uint8_t>(args_length);
+            Codec::serialize_values(m_request + m_length, args...);
+            m_length += args_length;
+            ++m_count;
+        });
+        return *this;
+    }
+
+    // Отправка пакета и ожидание сводного ответа
+    bool send(TickType_t timeout = pdMS_TO_TICKS(1000));
+
+    // Число вызовов в пакете
+    std::size_t size() const { return m_count; }
+    // Вызов с индексом index выполнен успешно
+    bool ok(std::size_t index) const { return index < m_results && m_ok[index]; }
+    // Причина ошибки вызова с индексом index (Unknown, если вызов успешен или ответа нет)
+    ErrorCode error(std::size_t index) const {
+        bool failed = index < m_results && !m_ok[index] && m_result_length[index] > 0;
+        return failed ? static_cast<ErrorCode>(m_response[m_result_offset[index]]) : ErrorCode::Unknown;
+    }
+
+    // Результат вызова с индексом index или значение по умолчанию при ошибке
+    // string_view и Span указывают в сводный ответ и действительны, пока жив пакет
+    template<typename Result>
+    Result result(std::size_t index) const {
+        Result value{};
+        if (ok(index)) {
+            visit_encoding(m_response_encoding, [&](auto serializer) {
+                decltype(serializer)::deserialize(m_response + m_result_offset[index], m_result_length[index], value);
+            });
+        }
+        return value;
+    }
+
+private:
+    Client& m_client;                                       // Клиент для отправки пакета
+    Encoding m_encoding;                                    // Кодирование аргументов вызовов
+    std::uint8_t m_request[protocol::Packet::MaxSize]{};    // Запрос: заголовок заполняется при отправке
+    std::size_t m_length{3};                                // Длина запроса (type | seq | count уже учтены)
+    std::size_t m_count{0};                                 // Число вызовов в пакете
+    bool m_overflow{false};                                 // Вызов не поместился в кадр
+
+    Encoding m_response_encoding{Encoding::Fixed};          // Кодирование результатов (флаг CompactFlag ответа)
+    std::uint8_t m_response[protocol::Packet::MaxSize]{};   // Сводный ответ
+    std::size_t m_results{0};                               // Число результатов в ответе
+    std::size_t m_result_offset[MaxCalls]{};                // Смещение результата в m_response
+    std::uint8_t m_result_length[MaxCalls]{};               // Длина результата
+    bool m_ok[MaxCalls]{};                                  // Статус вызова
+};
+
+} // namespace rpc
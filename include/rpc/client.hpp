@@ -1,51 +1,573 @@
 #pragma once
 #include <cstdint>
+#include <optional>
 #include <string>
+#include <tuple>
+#include <type_traits>
 #include "FreeRTOS.h"
+#include "task.h"
 #include "queue.h"
+#include "semphr.h"
+#include "timers.h"
 #include "../protocol/packet.hpp"
 #include "../protocol/parser.hpp"
-#include "../drivers/uart.hpp"
+#include "../protocol/sender.hpp"
+#include "../drivers/serial.hpp"
 #include "../rpc/types.hpp"
+#include "method.hpp"
+#include "serializer.hpp"
+#include "signature.hpp"
+#include "batch.hpp"
+#include "rtt.hpp"
+
+// Максимальное число одновременно ожидающих ответа вызовов (степень двойки, переопределяется через build_flags)
+#ifndef RPC_MAX_PENDING_CALLS
+#define RPC_MAX_PENDING_CALLS 4
+#endif
+
+// Число функций с собственной оценкой времени ответа (остальные используют оценку канала)
+#ifndef RPC_MAX_METHOD_ESTIMATORS
+#define RPC_MAX_METHOD_ESTIMATORS 8
+#endif
+
+// Число задач, которые могут присоединиться к уже отправленному одинаковому вызову
+#ifndef RPC_MAX_COALESCED_CALLS
+#define RPC_MAX_COALESCED_CALLS 3
+#endif
 
 namespace rpc {
 
+class Client;
+
+// Тип callback'а асинхронного вызова: void(CallStatus, Result) или void(CallStatus) для void-функций
+template<typename Result>
+struct AsyncCallbackOf { using type = void (*)(CallStatus, Result); };
+template<>
+struct AsyncCallbackOf<void> { using type = void (*)(CallStatus); };
+template<typename Result>
+using AsyncCallback = typename AsyncCallbackOf<Result>::type;
+
+/**
+ * Handle асинхронного RPC вызова (аналог future)
+ * Result Тип результата вызова (может быть void)
+ *
+ * Занимает слот в таблице ожидающих вызовов клиента до уничтожения handle
+ * poll() не блокирует, wait() блокирует до ответа, таймаута вызова или
+ *       истечения времени ожидания; get() возвращает результат после Ok
+ * Только перемещаемый - слот освобождается ровно один раз
+ */
+
+template<typename Result>
+class AsyncCall {
+public:
+    AsyncCall() = default;
+    explicit AsyncCall(CallStatus status) : m_status(status) {}
+    AsyncCall(Client* client, std::uint8_t seq) : m_client(client), m_seq(seq) {}
+    AsyncCall(AsyncCall&& other) noexcept { *this = static_cast<AsyncCall&&>(other); }
+    AsyncCall& operator=(AsyncCall&& other) noexcept;
+    AsyncCall(const AsyncCall&) = delete;
+    AsyncCall& operator=(const AsyncCall&) = delete;
+    ~AsyncCall() { reset(); }
+
+    // Текущее состояние вызова без блокировки
+    CallStatus poll() const;
+    // Ожидание завершения вызова не дольше timeout
+    CallStatus wait(TickType_t timeout = portMAX_DELAY);
+    // Результат вызова (значение по умолчанию, если вызов не завершился успешно)
+    template<typename R = Result>
+    std::enable_if_t<!std::is_void_v<R>, R> get() const;
+    // Причина ошибки из ответа Error (Unknown, если ответ не ошибка или причина не передана)
+    ErrorCode error() const;
+    // Освобождение слота вызова (поздний ответ будет отброшен)
+    void reset();
+
+private:
+    Client* m_client{nullptr};                  // Клиент, в таблице которого занят слот
+    std::uint8_t m_seq{0};                      // Порядковый номер запроса
+    CallStatus m_status{CallStatus::Pending};   // Состояние handle без слота (callback или ошибка отправки)
+};
+
 /**
  * RPC клиент для удаленного вызова процедур через бинарный протокол
  * 
  * Обеспечивает синхронные и асинхронные вызовы с обработкой ответов
  * Для работы требует предварительно инициализированные UART и Parser
+ *
+ * Вызовы из разных задач выполняются конвейерно: каждый запрос занимает слот
+ *       в таблице ожидающих вызовов (индекс слота - младшие биты seq),
+ *       ответ из контекста приема (handle_packet) копируется прямо в слот
+ *       и будит ожидающую задачу уведомлением, не затрагивая чужие ответы
+ * Асинхронные вызовы (call_async) не блокируют задачу: таймауты всех таких
+ *       вызовов обслуживает один программный таймер FreeRTOS, взводимый на
+ *       ближайший срок, а callback'и вызываются из контекста приема
+ * Callback таймера не отправляет кадры: просроченный запрос помечается
+ *       и ставится в очередь задачи повторов, которую приложение запускает
+ *       циклом process_resends() - ожидание канала и передача не задерживают
+ *       задачу таймеров FreeRTOS; так же повторяются запросы по Nack сервера,
+ *       чтобы не блокировать контекст приема
+ *
+ * Таймауты не фиксированы: для канала и для каждой функции ведется оценка
+ *       времени ответа (RttEstimator), запрос без ответа повторяется с тем же
+ *       seq (сервис отвечает из окна повторов, не выполняя handler дважды)
+ *       с экспоненциальным откатом таймаута, до MaxRetries раз
+ *
+ * Для идемпотентных функций (coalesce) одновременные вызовы с теми же
+ *       аргументами из разных задач объединяются: запрос отправляется один
+ *       раз, остальные задачи присоединяются к нему и получают тот же ответ
+ *
+ * Аргументы и результаты по умолчанию кодируются с фиксированным размером;
+ *       set_encoding включает Encoding::Compact (varint) для всего канала
+ *       или для отдельной функции - запрос помечается флагом CompactFlag,
+ *       и сервис отвечает в том же кодировании
  */
 
 class Client {
 public:
     // Конструктор RPC клиента
-    Client(drivers::Uart& uart, protocol::Parser& parser);
+    Client(drivers::Serial& uart, protocol::Parser& parser);
     
+    // Число слотов в таблице ожидающих вызовов (окно конвейера)
+    static constexpr std::size_t MaxPendingCalls = RPC_MAX_PENDING_CALLS;
+    static_assert((MaxPendingCalls & (MaxPendingCalls - 1)) == 0 && MaxPendingCalls <= 256,
+                  "RPC_MAX_PENDING_CALLS must be a power of two");
+    // Число функций с собственной оценкой времени ответа
+    static constexpr std::size_t MaxMethodEstimators = RPC_MAX_METHOD_ESTIMATORS;
+    // Число задач, присоединяемых к одному запросу
+    static constexpr std::size_t MaxCoalescedCalls = RPC_MAX_COALESCED_CALLS;
+    // Число повторных отправок запроса без ответа
+    static constexpr std::uint8_t MaxRetries = RPC_MAX_RETRIES;
+    // Таймаут до первого измерения и границы таймаута
+    static constexpr TickType_t InitialTimeout = pdMS_TO_TICKS(RPC_INITIAL_TIMEOUT_MS);
+    static constexpr TickType_t MinTimeout = pdMS_TO_TICKS(RPC_MIN_TIMEOUT_MS) > 0 ? pdMS_TO_TICKS(RPC_MIN_TIMEOUT_MS) : 1;
+    static constexpr TickType_t MaxTimeout = pdMS_TO_TICKS(RPC_MAX_TIMEOUT_MS);
+
+    // Маршрутизация принятого ответа к ожидающей задаче (из контекста приема)
+    bool handle_packet(const protocol::Packet& packet);
+    // Повтор запроса seq по Nack сервера (ставится в очередь задачи повторов), false если запрос уже не ждет ответа
+    bool handle_nack(std::uint8_t seq);
+    // Отправка запросов, помеченных для повтора (цикл задачи повторов), блокируется до первого
+    void process_resends(TickType_t timeout = portMAX_DELAY);
+
     // Ожидание ответа по порядковому номеру (raw packet)
     bool wait_response(protocol::Packet& response, std::uint8_t seq, TickType_t timeout);
     // Ожидание ответа по порядковому номеру (parsed message)
     bool wait_response(Message& response, std::uint8_t seq, TickType_t timeout);
 
-    // Синхронный вызов RPC функции с ожиданием результата
+    // Синхронный вызов RPC функции с ожиданием результата (по имени или MethodId из IDL)
     template<typename Result, typename... Args>
-    Result call(const std::string& func_name, Args... args);
+    Result call(const Target& target, Args... args);
 
-    // Асинхронный вызов RPC функции без ожидания результата
+    // Асинхронный вызов RPC функции без ожидания результата (всегда Encoding::Fixed)
     template<typename... Args>
     void stream_call(const std::string& func_name, Args... args);
 
+    /**
+     * Асинхронный вызов RPC функции
+     * call_async<Result>(name, args...) возвращает handle для poll()/wait()/get()
+     * call_async<Result>(name, args..., callback) передает результат в callback
+     *       (AsyncCallback<Result>) из контекста приема или таймера; handle
+     *       в этом случае не занимает слот и сообщает только об ошибке отправки
+     * Не блокирует: при заполненном окне конвейера вызов завершается с Error
+     */
+    template<typename Result, typename... Params>
+    AsyncCall<Result> call_async(const Target& target, Params... params);
+
+    // Создание пакета вызовов, отправляемого одним кадром (в кодировании канала)
+    Batch batch() { return Batch(*this, m_encoding); }
+
     // Отправка сырого пакета сообщения
     bool send_message(const protocol::Packet& msg);
 
-    // Возвращает очередь для приема ответов
-    QueueHandle_t get_response_queue() const { return m_response_queue; }
+    // Объединение одновременных вызовов функции с одинаковыми аргументами (только идемпотентные функции)
+    bool coalesce(const std::string& name);
+
+    // Кодирование аргументов и результатов по умолчанию для всех функций, false если Compact отключен сборкой
+    bool set_encoding(Encoding encoding);
+    // Кодирование аргументов и результатов одной функции (перекрывает кодирование канала)
+    bool set_encoding(const std::string& name, Encoding encoding);
+
+    // Оценка времени ответа канала (по всем вызовам)
+    RttStats rtt_stats() const;
+    // Оценка времени ответа одной функции, false если функция еще не вызывалась
+    bool rtt_stats(const std::string& name, RttStats& stats) const;
 
 private:
-    drivers::Uart& m_uart;              // Драйвер UART для отправки запросов
+    friend class Batch;
+    template<typename Result>
+    friend class AsyncCall;
+
+    // Передача результата в типизированный callback (трамплин, инстанцируется для каждого Result)
+    using Completion = void (*)(void (*callback)(), CallStatus status, const std::uint8_t* result, std::size_t length,
+                                Encoding encoding);
+
+    // Слот таблицы ожидающих вызовов
+    struct PendingCall {
+        bool active{false};                             // Слот занят запросом
+        bool async{false};                              // Асинхронный вызов (таймаут по программному таймеру)
+        CallStatus status{CallStatus::Pending};         // Состояние вызова
+        std::uint8_t seq{0};                            // Порядковый номер запроса
+        TaskHandle_t waiter{nullptr};                   // Задача, ожидающая ответ
+        TickType_t deadline{0};                         // Срок ответа асинхронного вызова
+        TickType_t sent{0};                             // Время последней отправки запроса
+        std::uint8_t attempt{0};                        // Номер попытки (0 - первая отправка)
+        std::uint8_t nacks{0};                          // Число повторов по Nack
+        bool resend{false};                             // Кадр ждет повторной отправки задачей повторов
+        RttEstimator* estimator{nullptr};               // Оценка времени ответа функции (nullptr - только канала)
+        bool shared{false};                             // К запросу могут присоединиться другие задачи
+        std::uint8_t users{0};                          // Задачи, использующие слот (освобождается последней)
+        std::uint8_t follower_count{0};                 // Число присоединившихся задач
+        TaskHandle_t followers[MaxCoalescedCalls]{};    // Присоединившиеся задачи, ожидающие ответа
+        Completion complete{nullptr};                   // Трамплин callback'а (nullptr - результат забирает handle)
+        void (*callback)(){nullptr};                    // Callback пользователя (приводится к AsyncCallback<Result>)
+        Encoding encoding{Encoding::Fixed};             // Кодирование результата (флаг CompactFlag ответа)
+        std::size_t length{0};                          // Длина полученного ответа
+        std::uint8_t data[protocol::Packet::MaxSize]{}; // Ответ: type | seq | name\0 | result...
+        protocol::Frame request;                        // Оформленный кадр запроса для повторной отправки
+    };
+
+    // Состояние одной функции: оценка времени ответа и политика объединения
+    struct Method {
+        std::string name;                               // Имя функции (пустое - запись свободна)
+        RttEstimator rtt{InitialTimeout, MinTimeout, MaxTimeout};
+        bool coalesce{false};                           // Одинаковые одновременные вызовы объединяются
+        std::optional<Encoding> encoding;               // Кодирование функции (нет - кодирование канала)
+    };
+
+    // Резервирование слота и порядкового номера для нового запроса
+    bool acquire(std::uint8_t& seq, TickType_t timeout, RttEstimator* estimator = nullptr);
+    // Освобождение слота запроса
+    void release(std::uint8_t seq);
+    // Резервирование слота под асинхронный вызов без блокировки
+    bool acquire_async(std::uint8_t& seq, Completion complete, void (*callback)(), RttEstimator* estimator);
+    // Состояние вызова по порядковому номеру
+    CallStatus status_of(std::uint8_t seq);
+    // Ожидание завершения вызова уведомлением задачи
+    CallStatus wait_for(std::uint8_t seq, TickType_t timeout);
+    // Ожидание ответа с повторами по таймауту из оценки времени ответа
+    CallStatus transact(std::uint8_t seq);
+    // Отправка запроса и ожидание ответа; false если слот не получен
+    template<typename... Args>
+    bool invoke(const Target& target, std::uint16_t signature, std::uint8_t& seq, CallStatus& status,
+                const Args&... args);
+    // Присоединение к отправленному запросу с тем же кадром (кроме seq)
+    bool join(const protocol::Frame& frame, std::uint8_t& seq);
+    // Ожидание ответа на запрос, к которому задача присоединилась
+    CallStatus wait_joined(std::uint8_t seq);
+    // Отправка запроса, к которому могут присоединиться другие задачи
+    bool lead(std::uint8_t seq, const protocol::Frame& frame);
+    // Завершение вызова ошибкой отправки
+    CallStatus fail(std::uint8_t seq);
+    // Пробуждение присоединившихся задач после завершения вызова
+    void wake_followers(PendingCall& call);
+    // Запись запроса type | seq | name\0 (или \0 | id) | signature | args... прямо в кадр
+    template<typename... Args>
+    static bool encode_request(protocol::Frame& frame, MessageType type, std::uint8_t seq, Encoding encoding,
+                               const Target& target, std::uint16_t signature, const Args&... args);
+    // Отправка готового кадра с сохранением в слоте
+    bool send_frame(std::uint8_t seq, const std::uint8_t* data, std::size_t length);
+    // Повторная отправка сохраненного запроса с тем же seq
+    bool retransmit(std::uint8_t seq);
+    // Пометка запроса для повтора и постановка в очередь задачи повторов (без отправки)
+    void schedule_resend(std::uint8_t seq);
+    // Состояние функции (создается при первом вызове; nullptr если таблица заполнена)
+    Method* method_for(const char* function_name);
+    // Кодирование вызова функции: собственное, если задано, иначе кодирование канала
+    Encoding encoding_for(const Method* method) const {
+        return method != nullptr && method->encoding ? *method->encoding : m_encoding;
+    }
+    // Таймаут попытки: по оценке функции, если она уже измерена, иначе по оценке канала
+    TickType_t timeout_for(RttEstimator* estimator, std::uint8_t attempt);
+    // Запуск асинхронного вызова с уже отделенным callback'ом
+    template<typename Result, typename Tuple, std::size_t... I>
+    AsyncCall<Result> start_async(const Target& target, AsyncCallback<Result> callback,
+                                  const Tuple& params, std::index_sequence<I...>);
+    // Трамплин: десериализация результата и вызов типизированного callback'а
+    template<typename Result>
+    static void complete_with(void (*callback)(), CallStatus status, const std::uint8_t* result, std::size_t length,
+                              Encoding encoding);
+    // Десериализация результата в кодировании ответа
+    template<typename Result>
+    static bool decode_result(const std::uint8_t* result, std::size_t length, Encoding encoding, Result& value) {
+        return visit_encoding(encoding, [&](auto serializer) {
+            return decltype(serializer)::deserialize(result, length, value);
+        });
+    }
+    // Поиск результата в ответе type | seq | name\0 | result... (при вызове по идентификатору имя пустое)
+    static const std::uint8_t* result_of(const std::uint8_t* data, std::size_t length, std::size_t& result_length);
+    // Завершение просроченных асинхронных вызовов и перевзвод таймера
+    void expire_calls();
+    // Взвод таймера на ближайший срок асинхронного вызова
+    void arm_timer();
+    // Callback программного таймера таймаутов
+    static void timeout_callback(TimerHandle_t timer);
+
+    drivers::Serial& m_uart;            // Канал для отправки запросов
     protocol::Parser& m_parser;         // Парсер для обработки ответов
-    std::uint8_t m_sequence{0};         // Текущий порядковый номер
-    QueueHandle_t m_response_queue;     // Очередь для приема ответов
+    std::uint8_t m_sequence{0};         // Следующий порядковый номер
+    Encoding m_encoding{Encoding::Fixed};   // Кодирование канала по умолчанию
+    SemaphoreHandle_t m_free_slots;     // Счетный семафор свободных слотов
+    TimerHandle_t m_timeout_timer;      // Единственный таймер таймаутов асинхронных вызовов
+    QueueHandle_t m_resend_queue;       // Порядковые номера запросов для задачи повторов
+    SemaphoreHandle_t m_rtt_mutex;      // Защита таблицы оценок функций (имена)
+    PendingCall m_pending[MaxPendingCalls];     // Таблица ожидающих вызовов, индекс = seq & (MaxPendingCalls - 1)
+    RttEstimator m_link_rtt{InitialTimeout, MinTimeout, MaxTimeout};   // Оценка времени ответа канала
+    Method m_methods[MaxMethodEstimators];      // Состояние функций (оценки времени ответа, объединение)
 };
 
+/**
+ * Запись запроса type | seq | name\0 | signature | args... прямо в кадр
+ * frame Кадр, в полезные данные которого записывается запрос
+ * type Тип сообщения (Request или Stream)
+ * encoding Кодирование аргументов (Compact - флаг CompactFlag в байте типа)
+ * target Имя функции или MethodId (вместо имени - \0 | id)
+ * signature Отпечаток сигнатуры Result(Args...) вызываемой функции
+ * false если имя функции с аргументами не помещается в кадр
+ *
+ * Минимальный размер аргументов проверяется static_assert, точный (строки,
+ *       массивы, varint) - во время выполнения; аргументы сериализуются
+ *       сверткой на свое место в кадре, без кортежа и промежуточных буферов,
+ *       затем Sender::seal дописывает заголовок и CRC
+ */
+
+template<typename... Args>
+bool Client::encode_request(protocol::Frame& frame, MessageType type, std::uint8_t seq, Encoding encoding,
+                            const Target& target, std::uint16_t signature, const Args&... args) {
+    static_assert(Serializer::min_size<Args...>() + 3 + SignatureSize <= protocol::Packet::MaxSize, "RPC arguments do not fit into a frame");
+    return visit_encoding(encoding, [&](auto serializer) {
+        using Codec = decltype(serializer);
+        std::size_t args_length = Codec::size_of_values(args...);
+        std::size_t header_length = 2 + target.size() + SignatureSize;              // type + seq + name\0 или \0 | id + signature
+        if (header_length + args_length > protocol::Packet::MaxSize) {              // Длина имени и строк известна только во время выполнения
+            return false;
+        }
+        std::uint8_t* payload = frame.payload();
+        payload[0] = static_cast<std::uint8_t>(type);
+        if (Codec::encoding == Encoding::Compact) {
+            payload[0] |= CompactFlag;
+        }
+        payload[1] = seq;
+        write_signature(target.write(payload + 2), signature);
+        Codec::serialize_values(payload + header_length, args...);
+        return protocol::Sender::seal(frame, header_length + args_length);
+    });
+}
+
+/**
+ * Синхронный вызов RPC функции с ожиданием результата
+ * Result Тип возвращаемого значения (может быть void)
+ * Args Типы аргументов функции
+ * target Имя вызываемой RPC функции или ее MethodId (вызов по идентификатору)
+ * args Аргументы функции
+ * Результат выполнения функции или значение по умолчанию при ошибке
+ * 
+ * Блокирует задачу на время выполнения RPC вызова; таймаут и повторы - по оценке
+ *       времени ответа функции (transact)
+ * Для void функций возвращает void, для остальных - значение по умолчанию при ошибке
+ */
+
+template<typename Result, typename... Args>
+Result Client::call(const Target& target, Args... args) {
+    std::uint8_t seq = 0;
+    CallStatus status = CallStatus::Error;
+    bool held = invoke(target, signature_of<Result, Args...>(), seq, status, args...);   // Слот занят до release
+    if constexpr (!std::is_void_v<Result>) {
+        static_assert(!Serializer::is_view<Result>(), "Result would point into a released slot: use std::string or a fixed-size type");
+        Result value{};                                                             // Значение по умолчанию при ошибке или таймауте
+        if (held && status == CallStatus::Ok) {
+            const PendingCall& call = m_pending[seq & (MaxPendingCalls - 1)];
+            std::size_t length = 0;
+            const std::uint8_t* result = result_of(call.data, call.length, length);
+            if (result != nullptr) {
+                decode_result(result, length, call.encoding, value);
+            }
+        }
+        if (held) {
+            release(seq);
+        }
+        return value;
+    } else if (held) {
+        release(seq);
+    }
+}
+
+/**
+ * Отправка запроса и ожидание ответа для синхронного вызова
+ * seq Выходной параметр - порядковый номер слота с ответом
+ * signature Отпечаток сигнатуры вызываемой функции
+ * status Выходной параметр - состояние вызова
+ * false если слот не получен (окно конвейера заполнено) - release не нужен
+ *
+ * Вызов функции с coalesce сначала ищет уже отправленный запрос с теми же
+ *       именем и аргументами и присоединяется к нему; иначе отправляет свой,
+ *       к которому могут присоединиться другие задачи
+ */
+
+template<typename... Args>
+bool Client::invoke(const Target& target, std::uint16_t signature, std::uint8_t& seq, CallStatus& status,
+                    const Args&... args) {
+    Method* method = method_for(target.name());
+    RttEstimator* estimator = method != nullptr ? &method->rtt : nullptr;
+    Encoding encoding = encoding_for(method);
+    if (method != nullptr && method->coalesce) {
+        protocol::Frame frame;                                                      // Запрос с seq = 0 - ключ (имя, аргументы)
+        if (!encode_request(frame, MessageType::Request, 0, encoding, target, signature, args...)) {
+            return false;
+        }
+        if (join(frame, seq)) {
+            status = wait_joined(seq);
+            return true;
+        }
+        if (!acquire(seq, pdMS_TO_TICKS(1000), estimator)) {                        // Ожидание свободного слота в окне конвейера
+            return false;
+        }
+        status = lead(seq, frame) ? transact(seq) : fail(seq);
+        return true;
+    }
+    if (!acquire(seq, pdMS_TO_TICKS(1000), estimator)) {
+        return false;
+    }
+    PendingCall& call = m_pending[seq & (MaxPendingCalls - 1)];
+    bool sent = encode_request(call.request, MessageType::Request, seq, encoding, target, signature, args...)
+                && retransmit(seq);
+    status = sent ? transact(seq) : fail(seq);                                      // Ожидание ответа с повторами
+    return true;
+}
+
+/**
+ * Асинхронный вызов RPC функции без ожидания результата
+ * Args Типы аргументов функции
+ * function_name Имя вызываемой RPC функции
+ * args Аргументы функции
+ * 
+ * Отправляет запрос и немедленно возвращает управление
+ * Не возвращает результат и не обрабатывает ошибки
+ * Кодируется всегда с фиксированным размером: Stream-сообщения читают и
+ *       подписчики сырых кадров, которые не разбирают varint
+ */
+
+template<typename... Args>
+void Client::stream_call(const std::string& function_name, Args... args) {
+    taskENTER_CRITICAL();                                                           // Номер разделяется с вызовами из других задач
+    std::uint8_t seq = m_sequence++;                                                // Автоинкремент порядкового номера
+    taskEXIT_CRITICAL();
+    protocol::Frame frame;                                                          // Аргументы кодируются сразу в кадр
+    if (encode_request(frame, MessageType::Stream, seq, Encoding::Fixed, function_name, signature_of<void, Args...>(), args...)) {
+        protocol::Sender sender(m_uart);
+        sender.send(frame);                                                         // Отправка без ожидания ответа
+    }
+}
+
+template<typename Result, typename... Params>
+AsyncCall<Result> Client::call_async(const Target& target, Params... params) {
+    constexpr std::size_t count = sizeof...(Params);
+    if constexpr (count > 0) {
+        using Last = std::tuple_element_t<count - 1, std::tuple<Params...>>;
+        if constexpr (std::is_convertible_v<Last, AsyncCallback<Result>>) {                 // Последний параметр - callback
+            std::tuple<Params...> all{params...};
+            return start_async<Result>(target, std::get<count - 1>(all), all, std::make_index_sequence<count - 1>{});
+        } else {
+            return start_async<Result>(target, nullptr, std::tuple<Params...>{params...}, std::make_index_sequence<count>{});
+        }
+    } else {
+        return start_async<Result>(target, nullptr, std::tuple<>{}, std::index_sequence<>{});
+    }
+}
+
+template<typename Result, typename Tuple, std::size_t... I>
+AsyncCall<Result> Client::start_async(const Target& target, AsyncCallback<Result> callback,
+                                      const Tuple& params, std::index_sequence<I...>) {
+    std::uint8_t seq = 0;
+    Completion complete = callback != nullptr ? &Client::complete_with<Result> : nullptr;
+    Method* method = method_for(target.name());
+    if (!acquire_async(seq, complete, reinterpret_cast<void (*)()>(callback), method != nullptr ? &method->rtt : nullptr)) {
+        return AsyncCall<Result>(CallStatus::Error);                                        // Окно конвейера заполнено
+    }
+    PendingCall& call = m_pending[seq & (MaxPendingCalls - 1)];
+    if (!encode_request(call.request, MessageType::Request, seq, encoding_for(method), target,
+                        signature_of<Result, std::tuple_element_t<I, Tuple>...>(), std::get<I>(params)...)
+        || !retransmit(seq)) {
+        (void)params;
+        release(seq);
+        return AsyncCall<Result>(CallStatus::Error);
+    }
+    if (callback != nullptr) {
+        return AsyncCall<Result>(CallStatus::Pending);                                      // Результат придет в callback
+    }
+    return AsyncCall<Result>(this, seq);
+}
+
+template<typename Result>
+void Client::complete_with(void (*callback)(), CallStatus status, const std::uint8_t* result, std::size_t length,
+                           Encoding encoding) {
+    if constexpr (std::is_void_v<Result>) {
+        (void)result;
+        (void)length;
+        (void)encoding;
+        reinterpret_cast<AsyncCallback<void>>(callback)(status);
+    } else {
+        Result value{};                                                                     // string_view и Span действительны во время callback'а
+        if (status == CallStatus::Ok && !decode_result(result, length, encoding, value)) {
+            status = CallStatus::Error;                                                     // Ответ короче результата
+        }
+        reinterpret_cast<AsyncCallback<Result>>(callback)(status, value);
+    }
+}
+
+template<typename Result>
+AsyncCall<Result>& AsyncCall<Result>::operator=(AsyncCall&& other) noexcept {
+    if (this != &other) {
+        reset();
+        m_client = other.m_client;
+        m_seq = other.m_seq;
+        m_status = other.m_status;
+        other.m_client = nullptr;
+    }
+    return *this;
+}
+
+template<typename Result>
+CallStatus AsyncCall<Result>::poll() const {
+    return m_client != nullptr ? m_client->status_of(m_seq) : m_status;
+}
+
+template<typename Result>
+CallStatus AsyncCall<Result>::wait(TickType_t timeout) {
+    return m_client != nullptr ? m_client->wait_for(m_seq, timeout) : m_status;
+}
+
+template<typename Result>
+template<typename R>
+std::enable_if_t<!std::is_void_v<R>, R> AsyncCall<Result>::get() const {
+    R value{};                                                                              // string_view и Span действительны до reset
+    if (m_client == nullptr || poll() != CallStatus::Ok) {
+        return value;
+    }
+    const Client::PendingCall& call = m_client->m_pending[m_seq & (Client::MaxPendingCalls - 1)];
+    std::size_t length = 0;
+    const std::uint8_t* result = Client::result_of(call.data, call.length, length);
+    if (result != nullptr) {
+        Client::decode_result(result, length, call.encoding, value);
+    }
+    return value;
+}
+
+template<typename Result>
+ErrorCode AsyncCall<Result>::error() const {
+    if (m_client == nullptr || poll() != CallStatus::Error) {
+        return ErrorCode::Unknown;
+    }
+    const Client::PendingCall& call = m_client->m_pending[m_seq & (Client::MaxPendingCalls - 1)];
+    bool reported = call.length >= 3 && call.data[0] == static_cast<std::uint8_t>(MessageType::Error);
+    return reported ? static_cast<ErrorCode>(call.data[2]) : ErrorCode::Unknown;                // Error | seq | reason
+}
+
+template<typename Result>
+void AsyncCall<Result>::reset() {
+    if (m_client != nullptr) {
+        m_status = m_client->status_of(m_seq);
+        m_client->release(m_seq);
+        m_client = nullptr;
+    }
+}
+
 } // namespace rpc
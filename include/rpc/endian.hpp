@@ -0,0 +1,117 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+// Перестановка байт и на little-endian узле (1 - путь big-endian узла в тестах хоста)
+#ifndef RPC_FORCE_BYTE_SWAP
+#define RPC_FORCE_BYTE_SWAP 0
+#endif
+
+namespace rpc {
+
+/**
+ * Порядок байт в кадре
+ *
+ * Контракт формата: многобайтные числа в кадре - little-endian, float и
+ *       double - IEEE 754 (4 и 8 байт) с тем же порядком байт
+ * На little-endian узлах (Cortex-M, x86, ARM64) запись и чтение - обычный
+ *       memcpy; на big-endian узлах байты переставляются при записи и чтении
+ * Массивы (std::array, rpc::Span) переставляются одним циклом без
+ *       зависимостей между итерациями - компилятор хоста векторизует его
+ * RPC_FORCE_BYTE_SWAP включает перестановку на любом узле: кадр тогда
+ *       big-endian и несовместим с другими сборками, но запись и чтение идут
+ *       тем же кодом, что на big-endian узле, и проверяются тестами хоста
+ */
+
+#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__) && defined(__ORDER_BIG_ENDIAN__)
+constexpr bool NativeLittleEndian = __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__;
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ || __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__,
+              "Mixed-endian targets are not supported");
+#else
+#error "Target byte order is unknown: __BYTE_ORDER__ is required"
+#endif
+
+#if defined(__FLOAT_WORD_ORDER__)
+static_assert(__FLOAT_WORD_ORDER__ == __BYTE_ORDER__, "Floating-point word order differs from integer byte order");
+#endif
+static_assert(std::numeric_limits<float>::is_iec559 && sizeof(float) == 4, "Wire format requires IEEE 754 binary32 float");
+static_assert(std::numeric_limits<double>::is_iec559 && sizeof(double) == 8, "Wire format requires IEEE 754 binary64 double");
+
+// Беззнаковое целое размера Size байт
+template<std::size_t Size>
+struct UnsignedOfSize;
+template<>
+struct UnsignedOfSize<2> { using type = std::uint16_t; };
+template<>
+struct UnsignedOfSize<4> { using type = std::uint32_t; };
+template<>
+struct UnsignedOfSize<8> { using type = std::uint64_t; };
+
+// Байты переставляются при переходе между памятью и кадром
+constexpr bool SwapBytes = !NativeLittleEndian || RPC_FORCE_BYTE_SWAP != 0;
+
+// Значение T переставляется при переходе между памятью и кадром
+template<typename T>
+constexpr bool needs_swap() {
+    return SwapBytes && sizeof(T) > 1 && (std::is_arithmetic_v<T> || std::is_enum_v<T>);
+}
+
+inline std::uint16_t byteswap(std::uint16_t value) { return __builtin_bswap16(value); }
+inline std::uint32_t byteswap(std::uint32_t value) { return __builtin_bswap32(value); }
+inline std::uint64_t byteswap(std::uint64_t value) { return __builtin_bswap64(value); }
+
+// Запись значения в кадр (out без требований к выравниванию)
+template<typename T>
+inline void store_le(std::uint8_t* out, const T& value) {
+    if constexpr (needs_swap<T>()) {
+        typename UnsignedOfSize<sizeof(T)>::type bits;
+        std::memcpy(&bits, &value, sizeof(T));
+        bits = byteswap(bits);
+        std::memcpy(out, &bits, sizeof(T));
+    } else {
+        std::memcpy(out, &value, sizeof(T));
+    }
+}
+
+// Чтение значения из кадра
+template<typename T>
+inline void load_le(const std::uint8_t* in, T& value) {
+    if constexpr (needs_swap<T>()) {
+        typename UnsignedOfSize<sizeof(T)>::type bits;
+        std::memcpy(&bits, in, sizeof(T));
+        bits = byteswap(bits);
+        std::memcpy(&value, &bits, sizeof(T));
+    } else {
+        std::memcpy(&value, in, sizeof(T));
+    }
+}
+
+/**
+ * Перестановка байт count элементов размера sizeof(T) из in в out
+ * Выполняется на любом узле (на little-endian используется только в замерах);
+ *       каждая итерация независима, поэтому цикл векторизуется
+ */
+template<typename T>
+void swap_bytes(std::uint8_t* out, const std::uint8_t* in, std::size_t count) {
+    using Bits = typename UnsignedOfSize<sizeof(T)>::type;
+    for (std::size_t i = 0; i < count; ++i) {
+        Bits bits;
+        std::memcpy(&bits, in + i * sizeof(Bits), sizeof(Bits));
+        bits = byteswap(bits);
+        std::memcpy(out + i * sizeof(Bits), &bits, sizeof(Bits));
+    }
+}
+
+// Копирование count элементов между памятью и кадром: memcpy или перестановка байт
+template<typename T>
+inline void copy_le(std::uint8_t* out, const std::uint8_t* in, std::size_t count) {
+    if constexpr (needs_swap<T>()) {
+        swap_bytes<T>(out, in, count);
+    } else {
+        std::memcpy(out, in, count * sizeof(T));
+    }
+}
+
+} // namespace rpc
@@ -0,0 +1,83 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "../drivers/serial.hpp"
+#include "../protocol/packet.hpp"
+#include "../protocol/parser.hpp"
+#include "../utils/noncopyable.hpp"
+#include "client.hpp"
+#include "service.hpp"
+
+// Максимальное число подписчиков на Stream-сообщения (переопределяется через build_flags)
+#ifndef RPC_MAX_STREAM_SUBSCRIBERS
+#define RPC_MAX_STREAM_SUBSCRIBERS 4
+#endif
+
+namespace rpc {
+
+/**
+ * Двунаправленная точка RPC на одном полнодуплексном канале
+ *
+ * Владеет единственным парсером канала и маршрутизирует принятые сообщения
+ *       по MessageType:
+ *       Request, BatchRequest                          → Service (входящая очередь)
+ *       Response, CachedResponse, Error, BatchResponse → Client (таблица ожидающих вызовов)
+ *       Stream                                         → подписчики по имени, иначе Service
+ *       Nack                                           → Client или Service по типу поврежденного кадра
+ *       Hello                                          → обрабатывается парсером (согласование канала)
+ * Исходящие кадры Service и Client идут через один канал, который сам
+ *       сериализует отправку целыми кадрами (мьютекс передачи Uart)
+ *
+ * Узел одновременно вызывает функции другой стороны и обслуживает ее вызовы
+ *
+ * Пример:
+ *     static rpc::Endpoint endpoint(uart);
+ *     endpoint.service().register_handler("add", &add);
+ *     endpoint.subscribe("log", on_log);
+ *     endpoint.negotiate();                            // после запуска планировщика
+ *     float t = endpoint.client().call<float>("get_temperature");
+ */
+
+class Endpoint : private utils::NonCopyable {
+public:
+    // Тип обработчика Stream-сообщения: аргументы сообщения и пользовательские данные
+    using StreamHandler = void (*)(const std::uint8_t* args, std::size_t length, void* user_data);
+
+    // Максимальное число подписчиков на Stream-сообщения
+    static constexpr std::size_t MaxStreamSubscribers = RPC_MAX_STREAM_SUBSCRIBERS;
+
+    // Конструктор точки: канал должен быть инициализирован до создания
+    explicit Endpoint(drivers::Serial& uart);
+
+    // Сервер: регистрация handlers и обработка входящих вызовов
+    Service& service() { return m_service; }
+    // Клиент: вызовы функций другой стороны
+    Client& client() { return m_client; }
+
+    // Подписка на Stream-сообщения с именем name (вызывается до начала приема)
+    bool subscribe(const std::string& name, StreamHandler handler, void* user_data = nullptr);
+    // Согласование возможностей канала с другой стороной (сжатие кадров); вызывается при установке связи
+    bool negotiate() { return m_parser.negotiate(); }
+
+private:
+    // Подписчик на Stream-сообщения
+    struct Subscriber {
+        std::string name;                   // Имя сообщения (пустое - запись свободна)
+        StreamHandler handler{nullptr};     // Обработчик
+        void* user_data{nullptr};           // Пользовательские данные обработчика
+    };
+
+    // Маршрутизация принятого пакета (callback парсера)
+    static void route(const protocol::Packet& packet, void* user_data);
+    // Передача Nack стороне, отправившей поврежденный кадр
+    void route_nack(const protocol::Packet& packet);
+    // Доставка Stream-сообщения подписчикам, false если подписчиков нет
+    bool publish(const protocol::Packet& packet);
+
+    protocol::Parser m_parser;                          // Единственный парсер канала
+    Service m_service;                                  // Обработка входящих вызовов
+    Client m_client;                                    // Исходящие вызовы
+    Subscriber m_subscribers[MaxStreamSubscribers];     // Подписчики на Stream-сообщения
+};
+
+} // namespace rpc
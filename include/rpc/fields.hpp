@@ -0,0 +1,174 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace rpc {
+
+/**
+ * Разбор агрегатной структуры на поля без макросов и ручных описаний
+ *
+ * Число полей определяется на этапе компиляции подбором: структура
+ *       инициализируется списком из N значений AnyField, приводимых к любому
+ *       типу, и наибольшее допустимое N - число полей; затем структурное
+ *       связывание (auto& [f0, f1, ...]) дает ссылки на поля в порядке объявления
+ *
+ * C-массив в списке инициализации раскрывается поэлементно и сбивает подсчет,
+ *       поэтому число полей проверяется вторым подсчетом с инициализаторами
+ *       в фигурных скобках ({AnyValue} инициализирует массив целиком); при
+ *       расхождении структура не раскладывается (IsReflectable - false)
+ * Поддерживаются агрегаты до MaxFields полей без базовых классов и битовых полей
+ *
+ * Пример:
+ *     struct Telemetry { std::uint8_t id; float value; std::uint16_t flags; };
+ *     auto fields = rpc::fields_of(telemetry);     // std::tuple<uint8_t&, float&, uint16_t&>
+ */
+
+// Максимальное число полей разбираемой структуры
+constexpr std::size_t MaxFields = 16;
+
+namespace detail {
+
+// Значение, приводимое к любому типу поля (используется только в невычисляемом контексте)
+struct AnyField {
+    template<typename T>
+    operator T&() const noexcept;
+};
+
+// То же для инициализатора {AnyValue}: без указателей, иначе у std::string_view
+//       два равноценных конструктора и инициализация неоднозначна
+struct AnyValue {
+    template<typename T, typename = std::enable_if_t<!std::is_pointer_v<T>>>
+    operator T&() const noexcept;
+};
+
+template<typename T>
+struct IsStdArray : std::false_type {};
+template<typename T, std::size_t N>
+struct IsStdArray<std::array<T, N>> : std::true_type {};
+
+// T{AnyField...} с sizeof...(I) инициализаторами допустимо
+template<typename T, std::size_t... I>
+constexpr auto initializable(std::index_sequence<I...>) -> decltype(void(T{(void(I), AnyField{})...}), true) {
+    return true;
+}
+template<typename T>
+constexpr bool initializable(...) {
+    return false;
+}
+
+// T{{AnyValue}...} с sizeof...(I) инициализаторами в фигурных скобках допустимо
+template<typename T, std::size_t... I>
+constexpr auto braced_initializable(std::index_sequence<I...>) -> decltype(void(T{{(void(I), AnyValue{})}...}), true) {
+    return true;
+}
+template<typename T>
+constexpr bool braced_initializable(...) {
+    return false;
+}
+
+// Наибольшее число инициализаторов (MaxFields + 1 - полей больше, чем поддерживается)
+template<typename T, std::size_t N = 0>
+constexpr std::size_t count_fields() {
+    if constexpr (N <= MaxFields && initializable<T>(std::make_index_sequence<N + 1>{})) {
+        return count_fields<T, N + 1>();
+    } else {
+        return N;
+    }
+}
+
+// То же для инициализаторов в фигурных скобках (массивы не раскрываются)
+template<typename T, std::size_t N = 0>
+constexpr std::size_t count_braced_fields() {
+    if constexpr (N <= MaxFields && braced_initializable<T>(std::make_index_sequence<N + 1>{})) {
+        return count_braced_fields<T, N + 1>();
+    } else {
+        return N;
+    }
+}
+
+} // namespace detail
+
+// Структура раскладывается на поля: агрегат (не std::array) хотя бы с одним полем, оба подсчета совпали
+template<typename T, typename Enable = void>
+struct IsReflectable : std::false_type {};
+template<typename T>
+struct IsReflectable<T, std::enable_if_t<std::is_class_v<T> && std::is_aggregate_v<T> && !detail::IsStdArray<T>::value>>
+    : std::bool_constant<(detail::count_fields<T>() > 0 && detail::count_fields<T>() <= MaxFields
+                          && detail::count_fields<T>() == detail::count_braced_fields<T>())> {};
+
+// Число полей агрегата T
+template<typename T>
+constexpr std::size_t field_count() {
+    return detail::count_fields<std::remove_const_t<T>>();
+}
+
+// Кортеж ссылок на поля агрегата в порядке объявления (const T - ссылки на const)
+template<typename T>
+auto fields_of(T& value) {
+    constexpr std::size_t count = field_count<T>();
+    static_assert(count > 0 && count <= MaxFields, "Type is not a reflectable aggregate");
+    if constexpr (count == 1) {
+        auto& [f0] = value;
+        return std::tie(f0);
+    } else if constexpr (count == 2) {
+        auto& [f0, f1] = value;
+        return std::tie(f0, f1);
+    } else if constexpr (count == 3) {
+        auto& [f0, f1, f2] = value;
+        return std::tie(f0, f1, f2);
+    } else if constexpr (count == 4) {
+        auto& [f0, f1, f2, f3] = value;
+        return std::tie(f0, f1, f2, f3);
+    } else if constexpr (count == 5) {
+        auto& [f0, f1, f2, f3, f4] = value;
+        return std::tie(f0, f1, f2, f3, f4);
+    } else if constexpr (count == 6) {
+        auto& [f0, f1, f2, f3, f4, f5] = value;
+        return std::tie(f0, f1, f2, f3, f4, f5);
+    } else if constexpr (count == 7) {
+        auto& [f0, f1, f2, f3, f4, f5, f6] = value;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6);
+    } else if constexpr (count == 8) {
+        auto& [f0, f1, f2, f3, f4, f5, f6, f7] = value;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7);
+    } else if constexpr (count == 9) {
+        auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8] = value;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8);
+    } else if constexpr (count == 10) {
+        auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9] = value;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9);
+    } else if constexpr (count == 11) {
+        auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10] = value;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10);
+    } else if constexpr (count == 12) {
+        auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11] = value;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11);
+    } else if constexpr (count == 13) {
+        auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12] = value;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12);
+    } else if constexpr (count == 14) {
+        auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13] = value;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13);
+    } else if constexpr (count == 15) {
+        auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14] = value;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14);
+    } else {
+        auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15] = value;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15);
+    }
+}
+
+// Типы полей агрегата T: std::tuple<поле0, поле1, ...>
+template<typename T>
+struct FieldTypes;
+template<typename... Refs>
+struct FieldTypes<std::tuple<Refs...>> {
+    using type = std::tuple<std::remove_cv_t<std::remove_reference_t<Refs>>...>;
+};
+template<typename T>
+using FieldTypesOf = typename FieldTypes<decltype(fields_of(std::declval<T&>()))>::type;
+
+} // namespace rpc
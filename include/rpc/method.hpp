@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include "endian.hpp"
+
+namespace rpc {
+
+/**
+ * Функция по идентификатору из IDL
+ *
+ * Описания функций генерируются из IDL (scripts/rpc_idl.py): идентификатор,
+ *       имя, структура аргументов и размеры известны на этапе компиляции
+ * Запрос по идентификатору несет вместо имени пустое имя и идентификатор:
+ *       type | seq | \0 | id(2) | signature | args...
+ *       ответ - с пустым именем: type | seq | \0 | result...
+ * Сервис находит handler по идентификатору без сравнения строк; имя остается
+ *       ключом регистрации в сервисе и таблиц клиента (оценка времени ответа,
+ *       кодирование, объединение вызовов, кэш хоста)
+ * Сервис без идентификаторов видит пустое имя и отвечает UnknownFunction
+ */
+
+struct MethodId {
+    std::uint16_t id;       // Идентификатор в запросе
+    const char* name;       // Имя функции
+};
+
+/**
+ * Адресат запроса: функция по имени (name\0) или по идентификатору (\0 | id)
+ * Создается неявно из имени или MethodId и живет до конца вызова
+ */
+
+class Target {
+public:
+    // Размер поля адресата при вызове по идентификатору
+    static constexpr std::size_t IdSize = 1 + sizeof(std::uint16_t);
+
+    Target(const char* name) : m_name(name), m_length(std::strlen(name)) {}
+    Target(const std::string& name) : m_name(name.c_str()), m_length(name.size()) {}
+    Target(const MethodId& method) : m_name(method.name), m_length(std::strlen(method.name)), m_id(method.id), m_by_id(true) {}
+
+    // Имя функции
+    const char* name() const { return m_name; }
+    // Вызов по идентификатору
+    bool by_id() const { return m_by_id; }
+    // Размер поля адресата в запросе
+    std::size_t size() const { return m_by_id ? IdSize : m_length + 1; }
+    // Длина имени в ответе (пустое при вызове по идентификатору)
+    std::size_t reply_name_length() const { return m_by_id ? 0 : m_length; }
+
+    // Запись поля адресата; возвращает позицию за ним
+    std::uint8_t* write(std::uint8_t* out) const {
+        if (m_by_id) {
+            *out = '\0';
+            store_le(out + 1, m_id);
+        } else {
+            std::memcpy(out, m_name, m_length + 1);
+        }
+        return out + size();
+    }
+
+private:
+    const char* m_name;         // Имя функции
+    std::size_t m_length;       // Длина имени
+    std::uint16_t m_id{0};      // Идентификатор
+    bool m_by_id{false};        // Вызов по идентификатору
+};
+
+} // namespace rpc
@@ -0,0 +1,265 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <tuple>
+#include <type_traits>
+#include "endian.hpp"
+
+namespace rpc {
+
+/**
+ * Плотные форматы значений: битовая упаковка и квантование
+ *
+ * Типы-обертки задают формат поля или аргумента в кадре, в памяти хранится
+ *       обычное значение:
+ *       Packed<Fields...>          - bool, enum и беззнаковые целые подряд по битам
+ *       Quantized<Min, Max, S, K>  - float в диапазоне [Min/K, Max/K] как целое S
+ *       Half                       - float как IEEE 754 binary16
+ * Преобразования без ветвлений по данным: сдвиги и маски, сравнения для
+ *       насыщения компилируются в условные пересылки (IT-блоки Thumb-2),
+ *       Half на Cortex-M4 с -mfp16-format=ieee - инструкция VCVTB
+ *
+ * Пример:
+ *     enum class Mode : std::uint8_t { Off, Blink, On };
+ *     template<> struct rpc::BitWidth<Mode> : std::integral_constant<std::size_t, 2> {};
+ *     struct Status { rpc::Packed<bool, bool, Mode> flags; rpc::Quantized<-40, 125> temperature; rpc::Half current; };
+ *     // 1 + 2 + 2 = 5 байт вместо 1 + 1 + 1 + 4 + 4
+ */
+
+// Число бит поля в Packed: bool - 1, enum и беззнаковые целые - полный размер,
+//       если не задан специализацией (для enum - число бит наибольшего значения)
+template<typename T, typename Enable = void>
+struct BitWidth;
+template<>
+struct BitWidth<bool> : std::integral_constant<std::size_t, 1> {};
+template<typename T>
+struct BitWidth<T, std::enable_if_t<std::is_enum_v<T> || (std::is_unsigned_v<T> && !std::is_same_v<T, bool>)>>
+    : std::integral_constant<std::size_t, sizeof(T) * 8> {};
+
+/**
+ * Битовая упаковка полей: поле 0 в младших битах первого байта, следующие -
+ *       выше, без выравнивания; размер в кадре - (сумма BitWidth + 7) / 8 байт
+ * Значение шире своего BitWidth усекается при записи; ненулевые биты
+ *       за последним полем отклоняются при чтении
+ */
+
+template<typename... Fields>
+class Packed {
+public:
+    static_assert(sizeof...(Fields) > 0, "Packed needs at least one field");
+
+    // Число значащих бит и размер в кадре
+    static constexpr std::size_t Bits = (BitWidth<Fields>::value + ... + 0);
+    static constexpr std::size_t Size = (Bits + 7) / 8;
+    static_assert(Bits <= 64, "Packed fields do not fit into 64 bits");
+
+    // Слово, в котором собираются биты
+    using Word = std::conditional_t<(Bits <= 32), std::uint32_t, std::uint64_t>;
+
+    Packed() = default;
+    // Шаблон, а не Packed(Fields...): иначе инициализатор {value} в подсчете полей структуры (fields.hpp) неоднозначен
+    template<typename... Values, typename = std::enable_if_t<sizeof...(Values) == sizeof...(Fields)
+                                                             && ((std::is_convertible_v<Values, Fields> && !std::is_class_v<Values>) && ...)>>
+    Packed(Values... values) : m_fields(static_cast<Fields>(values)...) {}
+
+    template<std::size_t I>
+    auto& get() { return std::get<I>(m_fields); }
+    template<std::size_t I>
+    const auto& get() const { return std::get<I>(m_fields); }
+
+    // Сборка полей в слово
+    Word pack() const {
+        return pack_fields(std::index_sequence_for<Fields...>{});
+    }
+    // Разбор слова на поля; false если заняты биты за последним полем
+    bool unpack(Word word) {
+        unpack_fields(word, std::index_sequence_for<Fields...>{});
+        if constexpr (Bits < sizeof(Word) * 8) {
+            return (word >> Bits) == 0;
+        } else {
+            return true;
+        }
+    }
+
+    bool operator==(const Packed& other) const { return m_fields == other.m_fields; }
+    bool operator!=(const Packed& other) const { return m_fields != other.m_fields; }
+
+private:
+    // Маска поля шириной Width бит
+    template<std::size_t Width>
+    static constexpr Word mask() {
+        return Width >= sizeof(Word) * 8 ? ~Word{0} : (Word{1} << Width) - 1;
+    }
+
+    // Смещение поля I в слове
+    template<std::size_t I>
+    static constexpr std::size_t offset() {
+        constexpr std::size_t widths[] = {BitWidth<Fields>::value...};
+        std::size_t result = 0;
+        for (std::size_t i = 0; i < I; ++i) {
+            result += widths[i];
+        }
+        return result;
+    }
+
+    template<std::size_t... I>
+    Word pack_fields(std::index_sequence<I...>) const {
+        return (((to_word(std::get<I>(m_fields)) & mask<BitWidth<Fields>::value>()) << offset<I>()) | ... | Word{0});
+    }
+    template<std::size_t... I>
+    void unpack_fields(Word word, std::index_sequence<I...>) {
+        ((std::get<I>(m_fields) = from_word<Fields>((word >> offset<I>()) & mask<BitWidth<Fields>::value>())), ...);
+    }
+
+    template<typename T>
+    static Word to_word(T value) {
+        if constexpr (std::is_enum_v<T>) {
+            return static_cast<Word>(static_cast<std::make_unsigned_t<std::underlying_type_t<T>>>(value));
+        } else {
+            return static_cast<Word>(value);
+        }
+    }
+    template<typename T>
+    static T from_word(Word bits) {
+        if constexpr (std::is_same_v<T, bool>) {
+            return bits != 0;
+        } else {
+            return static_cast<T>(bits);
+        }
+    }
+
+    std::tuple<Fields...> m_fields;     // Значения полей
+};
+
+/**
+ * float в объявленном диапазоне [Min / Scale, Max / Scale] как беззнаковое
+ *       целое Storage: 0 - нижняя граница, максимум Storage - верхняя
+ * Шаг квантования - (Max - Min) / Scale / max(Storage): для Quantized<-40, 125>
+ *       (uint16_t) это 0.0025; значения за пределами диапазона и NaN
+ *       насыщаются к границам при записи
+ */
+
+template<std::int32_t Min, std::int32_t Max, typename Storage = std::uint16_t, std::int32_t Scale = 1>
+class Quantized {
+public:
+    static_assert(Min < Max && Scale > 0, "Quantized range is empty");
+    static_assert(std::is_unsigned_v<Storage> && !std::is_same_v<Storage, bool> && sizeof(Storage) <= 2,
+                  "Quantized storage must be std::uint8_t or std::uint16_t");
+
+    static constexpr float Lower = static_cast<float>(Min) / static_cast<float>(Scale);
+    static constexpr float Upper = static_cast<float>(Max) / static_cast<float>(Scale);
+    static constexpr float Steps = static_cast<float>(std::numeric_limits<Storage>::max());
+    static constexpr float Step = (Upper - Lower) / Steps;
+
+    Quantized() = default;
+    // Шаблон по той же причине, что у Packed: {value} в подсчете полей структуры
+    template<typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+    Quantized(T value) : m_value(static_cast<float>(value)) {}
+
+    operator float() const { return m_value; }
+    float value() const { return m_value; }
+
+    // Значение в кадре: насыщение к диапазону (NaN - к нижней границе) и округление
+    Storage encode() const {
+        float clamped = !(m_value >= Lower) ? Lower : m_value;
+        clamped = clamped > Upper ? Upper : clamped;
+        return static_cast<Storage>((clamped - Lower) * (Steps / (Upper - Lower)) + 0.5f);
+    }
+    void decode(Storage bits) {
+        m_value = Lower + static_cast<float>(bits) * Step;
+    }
+
+private:
+    float m_value{0.0f};                // Значение
+};
+
+// Преобразование float ↔ IEEE 754 binary16 (округление к ближайшему четному)
+#if defined(__ARM_FP16_FORMAT_IEEE)
+inline std::uint16_t float_to_half(float value) {
+    __fp16 half = static_cast<__fp16>(value);                   // VCVTB.F16.F32
+    std::uint16_t bits;
+    std::memcpy(&bits, &half, sizeof(bits));
+    return bits;
+}
+inline float half_to_float(std::uint16_t bits) {
+    __fp16 half;
+    std::memcpy(&half, &bits, sizeof(bits));
+    return static_cast<float>(half);                            // VCVTB.F32.F16
+}
+#else
+inline std::uint16_t float_to_half(float value) {
+    constexpr std::uint32_t Infinity = 255u << 23;
+    constexpr std::uint32_t HalfOverflow = (127u + 16) << 23;  // 65536.0f - за пределами binary16
+    constexpr std::uint32_t NormalMin = 113u << 23;             // 2^-14 - наименьшее нормализованное
+    constexpr std::uint32_t DenormalMagicBits = ((127u - 15) + (23 - 10) + 1) << 23;
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    std::uint32_t sign = bits & 0x80000000u;
+    bits ^= sign;
+    std::uint16_t half;
+    if (bits >= HalfOverflow) {
+        half = bits > Infinity ? 0x7E00 : 0x7C00;               // NaN или бесконечность
+    } else if (bits < NormalMin) {
+        float magic;                                            // Денормализованное: сложение сдвигает мантиссу
+        std::memcpy(&magic, &DenormalMagicBits, sizeof(magic));
+        float shifted;
+        std::memcpy(&shifted, &bits, sizeof(shifted));
+        shifted += magic;
+        std::uint32_t result;
+        std::memcpy(&result, &shifted, sizeof(result));
+        half = static_cast<std::uint16_t>(result - DenormalMagicBits);
+    } else {
+        std::uint32_t odd = (bits >> 13) & 1;                   // Округление к четному
+        bits += ((15u - 127u) << 23) + 0xFFF + odd;
+        half = static_cast<std::uint16_t>(bits >> 13);
+    }
+    return static_cast<std::uint16_t>(half | (sign >> 16));
+}
+inline float half_to_float(std::uint16_t half) {
+    constexpr std::uint32_t ExponentMask = 0x7C00u << 13;
+    constexpr std::uint32_t MagicBits = 113u << 23;
+    std::uint32_t bits = (half & 0x7FFFu) << 13;
+    std::uint32_t exponent = bits & ExponentMask;
+    bits += (127u - 15) << 23;
+    if (exponent == ExponentMask) {
+        bits += (128u - 16) << 23;                              // Бесконечность или NaN
+    } else if (exponent == 0) {
+        bits += 1u << 23;                                       // Денормализованное: нормализация вычитанием
+        float value;
+        float magic;
+        std::memcpy(&value, &bits, sizeof(value));
+        std::memcpy(&magic, &MagicBits, sizeof(magic));
+        value -= magic;
+        std::memcpy(&bits, &value, sizeof(bits));
+    }
+    bits |= static_cast<std::uint32_t>(half & 0x8000u) << 16;
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+#endif
+
+/**
+ * float как IEEE 754 binary16: 11 значащих бит, нормализованный диапазон
+ *       до ±65504; больше - бесконечность, как при аппаратном преобразовании
+ */
+
+class Half {
+public:
+    Half() = default;
+    // Шаблон по той же причине, что у Packed: {value} в подсчете полей структуры
+    template<typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+    Half(T value) : m_value(static_cast<float>(value)) {}
+
+    operator float() const { return m_value; }
+    float value() const { return m_value; }
+
+    std::uint16_t encode() const { return float_to_half(m_value); }
+    void decode(std::uint16_t bits) { m_value = half_to_float(bits); }
+
+private:
+    float m_value{0.0f};                // Значение
+};
+
+} // namespace rpc
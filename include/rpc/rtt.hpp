@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+
+// Границы таймаута ответа в миллисекундах и число повторов запроса (переопределяются через build_flags)
+#ifndef RPC_MIN_TIMEOUT_MS
+#define RPC_MIN_TIMEOUT_MS 10
+#endif
+#ifndef RPC_MAX_TIMEOUT_MS
+#define RPC_MAX_TIMEOUT_MS 2000
+#endif
+#ifndef RPC_INITIAL_TIMEOUT_MS
+#define RPC_INITIAL_TIMEOUT_MS 1000
+#endif
+#ifndef RPC_MAX_RETRIES
+#define RPC_MAX_RETRIES 2
+#endif
+
+namespace rpc {
+
+// Оценка времени ответа для мониторинга (в тиках)
+struct RttStats {
+    std::uint32_t srtt{0};          // Сглаженное время ответа
+    std::uint32_t rttvar{0};        // Сглаженное отклонение времени ответа
+    std::uint32_t timeout{0};       // Текущий таймаут первой попытки
+    std::uint32_t samples{0};       // Число измерений
+    std::uint32_t retries{0};       // Число повторных отправок
+    std::uint32_t timeouts{0};      // Число вызовов, оставшихся без ответа
+};
+
+/**
+ * Оценщик времени ответа по алгоритму Джекобсона/Карелса (как RTO в TCP)
+ *
+ * srtt   += (rtt - srtt) / 8
+ * rttvar += (|rtt - srtt| - rttvar) / 4
+ * timeout = srtt + 4 * rttvar, в пределах [min_ticks, max_ticks]
+ *
+ * Попытка attempt ждет timeout * 2^attempt, но не дольше max_ticks
+ *       (экспоненциальный откат); до первого измерения используется initial_ticks
+ * Хранит srtt * 8 и rttvar * 4 в целых числах - без плавающей точки
+ * Не потокобезопасен - вызывающий код защищает оценщик сам
+ */
+
+class RttEstimator {
+public:
+    RttEstimator(std::uint32_t initial_ticks, std::uint32_t min_ticks, std::uint32_t max_ticks)
+        : m_initial(initial_ticks), m_min(min_ticks), m_max(max_ticks) {}
+
+    // Учет измеренного времени ответа (только для запросов без повторов - алгоритм Карна)
+    void sample(std::uint32_t rtt);
+    // Учет повторной отправки запроса
+    void retry() { ++m_stats.retries; }
+    // Учет вызова, оставшегося без ответа после всех попыток
+    void expire() { ++m_stats.timeouts; }
+
+    // Таймаут попытки attempt (0 - первая отправка)
+    std::uint32_t timeout(std::uint8_t attempt) const;
+    // Есть ли хотя бы одно измерение
+    bool calibrated() const { return m_stats.samples > 0; }
+    // Текущая оценка для мониторинга
+    RttStats stats() const;
+
+private:
+    std::uint32_t m_initial;        // Таймаут до первого измерения
+    std::uint32_t m_min;            // Нижняя граница таймаута
+    std::uint32_t m_max;            // Верхняя граница таймаута (и отката)
+    std::uint32_t m_srtt8{0};       // srtt * 8
+    std::uint32_t m_rttvar4{0};     // rttvar * 4
+    RttStats m_stats;               // Счетчики
+};
+
+} // namespace rpc
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "../utils/noncopyable.hpp"
+#include "client.hpp"
+#include "timeseries.hpp"
+
+namespace rpc {
+
+/**
+ * Поток выборок телеметрии блоками Stream-сообщений
+ *
+ * Выборки накапливаются в сжатом блоке (timeseries.hpp); заполненный блок
+ *       отправляется одним Stream-сообщением name(TimeSeriesBlock) и
+ *       выборка переходит в новый блок
+ * Задержка доставки - до заполнения блока: для редких выборок flush()
+ *       вызывается по таймеру или по числу выборок
+ * Не потокобезопасен: выборки добавляет одна задача
+ *
+ * Пример:
+ *     static rpc::SampleStream temperature(endpoint.client(), "temperature");
+ *     temperature.push(xTaskGetTickCount() * portTICK_PERIOD_MS, read_temperature());
+ */
+
+class SampleStream : private utils::NonCopyable {
+public:
+    SampleStream(Client& client, std::string name);
+
+    // Добавление выборки; заполненный блок отправляется
+    void push(std::uint32_t timestamp, float value);
+    // Отправка накопленных выборок (неполного блока)
+    void flush();
+
+    // Отправлено блоков
+    std::uint32_t blocks() const { return m_blocks; }
+
+private:
+    Client& m_client;                   // Канал для отправки блоков
+    std::string m_name;                 // Имя Stream-сообщения
+    TimeSeriesEncoder m_encoder;        // Текущий блок
+    std::uint32_t m_blocks{0};          // Отправлено блоков
+};
+
+} // namespace rpc
@@ -1,69 +1,629 @@
 #pragma once
+#include <array>
 #include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
 #include <tuple>
 #include <type_traits>
 #include <cstring>
+#include "endian.hpp"
+#include "fields.hpp"
+#include "packing.hpp"
+#include "span.hpp"
+#include "types.hpp"
+#include "../protocol/packet.hpp"
 
 namespace rpc {
 
+/**
+ * Чтение значений из принятого буфера с контролем границ
+ *
+ * Длины строк и массивов приходят из канала, поэтому каждое чтение
+ *       проверяет остаток буфера; после первой ошибки все чтения неуспешны
+ */
+
+class Reader {
+public:
+    Reader(const std::uint8_t* data, std::size_t length) : m_position(data), m_end(data + length) {}
+
+    // Указатель на следующие length байт (с продвижением) или nullptr, если буфер короче
+    const std::uint8_t* take(std::size_t length) {
+        if (!m_ok || length > remaining()) {
+            m_ok = false;
+            return nullptr;
+        }
+        const std::uint8_t* data = m_position;
+        m_position += length;
+        return data;
+    }
+
+    // Все чтения были в пределах буфера
+    bool ok() const { return m_ok; }
+    // Число непрочитанных байт
+    std::size_t remaining() const { return static_cast<std::size_t>(m_end - m_position); }
+
+private:
+    const std::uint8_t* m_position;     // Следующий непрочитанный байт
+    const std::uint8_t* m_end;          // Конец буфера
+    bool m_ok{true};                    // Ошибок чтения не было
+};
+
+// Префикс длины строк и массивов: кадр короче 256 байт, одного байта достаточно
+using LengthPrefix = std::uint8_t;
+static_assert(protocol::Packet::MaxSize <= 0xFF, "LengthPrefix does not cover a frame");
+
+/**
+ * Формат типа T в кадре при кодировании E
+ *
+ * Общий шаблон - тривиально копируемые типы (числа, enum, std::array из них):
+ *       размер sizeof(T), числа little-endian (endian.hpp) - на little-endian
+ *       узле это memcpy; прочие тривиальные типы (структуры с C-массивами)
+ *       копируются как есть и переносимы только между little-endian узлами
+ * Агрегатные структуры записываются по полям, без выравнивания (fields.hpp)
+ * Битовая упаковка и квантование задаются типами-обертками (packing.hpp)
+ * В Encoding::Compact целые числа шире байта (и enum) записываются varint
+ * Для остальных типов - специализации ниже; собственный тип подключается
+ *       своей специализацией Codec с теми же членами:
+ *       Fixed   - размер не зависит от значения
+ *       MinSize - минимальный размер в кадре (для Fixed - точный)
+ *       Plain   - байты в кадре совпадают с байтами в памяти (допустим memcpy)
+ *       View    - прочитанное значение указывает в буфер кадра
+ *       size(value), write(out, value) → позиция за записью, read(in, value) → успех
+ */
+
+template<typename T, Encoding E = Encoding::Fixed, typename Enable = void>
+struct Codec {
+    static_assert(!std::is_pointer_v<T>, "Pointers are not serializable: pass std::string_view or rpc::Span");
+    static_assert(std::is_trivially_copyable_v<T>, "Type is not serializable: specialize rpc::Codec for it");
+
+    static constexpr bool Fixed = true;
+    static constexpr std::size_t MinSize = sizeof(T);
+    static constexpr bool Plain = !needs_swap<T>();
+    static constexpr bool View = false;
+
+    static std::size_t size(const T&) { return sizeof(T); }
+    static std::uint8_t* write(std::uint8_t* out, const T& value) {
+        store_le(out, value);
+        return out + sizeof(T);
+    }
+    static bool read(Reader& in, T& value) {
+        const std::uint8_t* data = in.take(sizeof(T));
+        if (data != nullptr) {
+            load_le(data, value);
+        }
+        return data != nullptr;
+    }
+};
+
+/**
+ * Целое число в Encoding::Compact: LEB128 varint, 7 бит на байт, младшие
+ *       группы первыми, старший бит байта - признак продолжения
+ * Знаковые значения предварительно переводятся zigzag (0, -1, 1, -2 → 0, 1, 2, 3),
+ *       чтобы малые по модулю отрицательные числа тоже занимали 1-2 байта
+ * int32_t занимает от 1 до 5 байт; значение длиннее MaxSize байт или с битами
+ *       за пределами типа отклоняется при чтении
+ */
+
+template<typename T>
+struct Codec<T, Encoding::Compact, std::enable_if_t<(std::is_integral_v<T> || std::is_enum_v<T>) && (sizeof(T) > 1)>> {
+    using Integer = typename std::conditional_t<std::is_enum_v<T>, std::underlying_type<T>, std::enable_if<true, T>>::type;
+    using Unsigned = std::make_unsigned_t<Integer>;
+    static constexpr std::size_t Bits = sizeof(T) * 8;
+    static constexpr std::size_t MaxSize = (Bits + 6) / 7;
+
+    static constexpr bool Fixed = false;
+    static constexpr std::size_t MinSize = 1;
+    static constexpr bool Plain = false;
+    static constexpr bool View = false;
+
+    static Unsigned encode(T value) {
+        auto integer = static_cast<Integer>(value);
+        if constexpr (std::is_signed_v<Integer>) {
+            return static_cast<Unsigned>((static_cast<Unsigned>(integer) << 1) ^ static_cast<Unsigned>(integer >> (Bits - 1)));
+        } else {
+            return integer;
+        }
+    }
+    static T decode(Unsigned bits) {
+        if constexpr (std::is_signed_v<Integer>) {
+            return static_cast<T>(static_cast<Integer>((bits >> 1) ^ (~(bits & 1) + 1)));
+        } else {
+            return static_cast<T>(bits);
+        }
+    }
+
+    static std::size_t size(const T& value) {
+        Unsigned bits = encode(value);
+        std::size_t length = 1;
+        while (bits >= 0x80) {
+            bits >>= 7;
+            ++length;
+        }
+        return length;
+    }
+    static std::uint8_t* write(std::uint8_t* out, const T& value) {
+        Unsigned bits = encode(value);
+        while (bits >= 0x80) {
+            *out++ = static_cast<std::uint8_t>(bits | 0x80);
+            bits >>= 7;
+        }
+        *out++ = static_cast<std::uint8_t>(bits);
+        return out;
+    }
+    static bool read(Reader& in, T& value) {
+        Unsigned bits = 0;
+        for (std::size_t i = 0; i < MaxSize; ++i) {
+            const std::uint8_t* byte = in.take(1);
+            if (byte == nullptr) {
+                return false;
+            }
+            std::size_t shift = i * 7;
+            if (i == MaxSize - 1 && (*byte >> (Bits - shift)) != 0) {
+                return false;                                   // Биты за пределами типа
+            }
+            bits |= static_cast<Unsigned>(*byte & 0x7F) << shift;
+            if ((*byte & 0x80) == 0) {
+                value = decode(bits);
+                return true;
+            }
+        }
+        return false;                                           // Нет завершающего байта
+    }
+};
+
+// Строка: length | chars...; при чтении - представление символов в кадре
+template<Encoding E>
+struct Codec<std::string_view, E> {
+    static constexpr bool Fixed = false;
+    static constexpr std::size_t MinSize = sizeof(LengthPrefix);
+    static constexpr bool Plain = false;
+    static constexpr bool View = true;
+
+    static std::size_t size(std::string_view value) { return sizeof(LengthPrefix) + value.size(); }
+    static std::uint8_t* write(std::uint8_t* out, std::string_view value) {
+        *out++ = static_cast<LengthPrefix>(value.size());
+        std::memcpy(out, value.data(), value.size());
+        return out + value.size();
+    }
+    static bool read(Reader& in, std::string_view& value) {
+        const std::uint8_t* length = in.take(sizeof(LengthPrefix));
+        const std::uint8_t* data = length != nullptr ? in.take(*length) : nullptr;
+        if (data != nullptr) {
+            value = std::string_view(reinterpret_cast<const char*>(data), *length);
+        }
+        return data != nullptr;
+    }
+};
+
+// std::string - тот же формат, что string_view, но при чтении символы копируются
+template<Encoding E>
+struct Codec<std::string, E> {
+    static constexpr bool Fixed = false;
+    static constexpr std::size_t MinSize = sizeof(LengthPrefix);
+    static constexpr bool Plain = false;
+    static constexpr bool View = false;
+
+    static std::size_t size(const std::string& value) { return Codec<std::string_view, E>::size(value); }
+    static std::uint8_t* write(std::uint8_t* out, const std::string& value) { return Codec<std::string_view, E>::write(out, value); }
+    static bool read(Reader& in, std::string& value) {
+        std::string_view view;
+        if (!Codec<std::string_view, E>::read(in, view)) {
+            return false;
+        }
+        value.assign(view.data(), view.size());
+        return true;
+    }
+};
+
+// Массив: count | elements...; при чтении - представление элементов в кадре
+// Элементы всегда фиксированного размера (и в Encoding::Compact) - иначе представление без копирования невозможно
+template<typename T, Encoding E>
+struct Codec<Span<T>, E> {
+    static_assert(Codec<T>::Plain || needs_swap<T>(), "Span elements must be stored as raw bytes (no padding, fixed-width fields)");
+
+    static constexpr bool Fixed = false;
+    static constexpr std::size_t MinSize = sizeof(LengthPrefix);
+    static constexpr bool Plain = false;
+    static constexpr bool View = true;
+
+    static std::size_t size(const Span<T>& value) { return sizeof(LengthPrefix) + value.size_bytes(); }
+    static std::uint8_t* write(std::uint8_t* out, const Span<T>& value) {
+        *out++ = static_cast<LengthPrefix>(value.size());
+        if (value.wire_order()) {
+            std::memcpy(out, value.bytes(), value.size_bytes());    // Уже little-endian
+        } else {
+            copy_le<T>(out, value.bytes(), value.size());
+        }
+        return out + value.size_bytes();
+    }
+    static bool read(Reader& in, Span<T>& value) {
+        const std::uint8_t* count = in.take(sizeof(LengthPrefix));
+        const std::uint8_t* data = count != nullptr ? in.take(*count * sizeof(T)) : nullptr;
+        if (data != nullptr) {
+            value = Span<T>::from_bytes(data, *count);
+        }
+        return data != nullptr;
+    }
+};
+
+// Необязательное значение: present(1) | value, если present != 0
+template<typename T, Encoding E>
+struct Codec<std::optional<T>, E> {
+    static constexpr bool Fixed = false;
+    static constexpr std::size_t MinSize = 1;
+    static constexpr bool Plain = false;
+    static constexpr bool View = Codec<T, E>::View;
+
+    static std::size_t size(const std::optional<T>& value) { return 1 + (value ? Codec<T, E>::size(*value) : 0); }
+    static std::uint8_t* write(std::uint8_t* out, const std::optional<T>& value) {
+        *out++ = value.has_value();
+        return value ? Codec<T, E>::write(out, *value) : out;
+    }
+    static bool read(Reader& in, std::optional<T>& value) {
+        const std::uint8_t* present = in.take(1);
+        if (present == nullptr) {
+            return false;
+        }
+        if (*present == 0) {
+            value.reset();
+            return true;
+        }
+        return Codec<T, E>::read(in, value.emplace());
+    }
+};
+
+// Вложенный кортеж: элементы подряд без разделителей
+template<Encoding E, typename... Ts>
+struct Codec<std::tuple<Ts...>, E> {
+    static constexpr bool Fixed = (Codec<Ts, E>::Fixed && ...);
+    static constexpr std::size_t MinSize = (Codec<Ts, E>::MinSize + ... + 0);
+    static constexpr bool Plain = false;
+    static constexpr bool View = (Codec<Ts, E>::View || ...);
+
+    static std::size_t size(const std::tuple<Ts...>& value) {
+        return std::apply([](const Ts&... element) { return (Codec<Ts, E>::size(element) + ... + 0); }, value);
+    }
+    static std::uint8_t* write(std::uint8_t* out, const std::tuple<Ts...>& value) {
+        std::apply([&out](const Ts&... element) { ((out = Codec<Ts, E>::write(out, element)), ...); }, value);
+        return out;
+    }
+    static bool read(Reader& in, std::tuple<Ts...>& value) {
+        return std::apply([&in](Ts&... element) { return (Codec<Ts, E>::read(in, element) && ...); }, value);
+    }
+};
+
+/**
+ * Агрегатная структура: поля подряд в порядке объявления, без выравнивания
+ *
+ * В кадр попадают только байты полей - формат не зависит от выравнивания
+ *       и ABI компиляторов на концах канала; размер и смещения полей
+ *       фиксированного размера известны на этапе компиляции
+ * Структура без выравнивания из побайтных полей остается Plain и копируется
+ *       одним memcpy (в памяти поля лежат подряд в том же порядке)
+ * Поля кодируются своими Codec: вложенные структуры, строки, varint в Compact
+ *
+ * Пример: struct Telemetry { std::uint8_t id; float value; } - 5 байт вместо sizeof 8
+ */
+
+// Все типы кортежа Tuple хранятся в кадре побайтно
+template<Encoding E, typename Tuple>
+struct AllPlain;
+template<Encoding E, typename... Ts>
+struct AllPlain<E, std::tuple<Ts...>> : std::bool_constant<(Codec<Ts, E>::Plain && ...)> {};
+
+template<typename T, Encoding E>
+struct Codec<T, E, std::enable_if_t<IsReflectable<T>::value>> {
+    using Fields = FieldTypesOf<T>;
+
+    static constexpr bool Fixed = Codec<Fields, E>::Fixed;
+    static constexpr std::size_t MinSize = Codec<Fields, E>::MinSize;
+    static constexpr bool Plain = Fixed && MinSize == sizeof(T) && AllPlain<E, Fields>::value;
+    static constexpr bool View = Codec<Fields, E>::View;
+
+    static std::size_t size(const T& value) {
+        if constexpr (Plain) {
+            return sizeof(T);
+        } else {
+            return Codec<Fields, E>::size(fields_of(value));
+        }
+    }
+    static std::uint8_t* write(std::uint8_t* out, const T& value) {
+        if constexpr (Plain) {
+            std::memcpy(out, &value, sizeof(T));
+            return out + sizeof(T);
+        } else {
+            return std::apply([&out](const auto&... field) {
+                ((out = Codec<std::decay_t<decltype(field)>, E>::write(out, field)), ...);
+                return out;
+            }, fields_of(value));
+        }
+    }
+    static bool read(Reader& in, T& value) {
+        if constexpr (Plain) {
+            const std::uint8_t* data = in.take(sizeof(T));
+            if (data != nullptr) {
+                std::memcpy(&value, data, sizeof(T));
+            }
+            return data != nullptr;
+        } else {
+            return std::apply([&in](auto&... field) {
+                return (Codec<std::decay_t<decltype(field)>, E>::read(in, field) && ...);
+            }, fields_of(value));
+        }
+    }
+};
+
+// std::array из сериализуемых не побайтно элементов (строк, кортежей, varint): элементы подряд
+// Числа фиксированного размера на big-endian узле переставляются одним циклом (Bulk)
+template<typename T, std::size_t N, Encoding E>
+struct Codec<std::array<T, N>, E, std::enable_if_t<!Codec<T, E>::Plain>> {
+    static constexpr bool Bulk = needs_swap<T>() && Codec<T, E>::Fixed;
+    static constexpr bool Fixed = Codec<T, E>::Fixed;
+    static constexpr std::size_t MinSize = Codec<T, E>::MinSize * N;
+    static constexpr bool Plain = false;
+    static constexpr bool View = Codec<T, E>::View;
+
+    static std::size_t size(const std::array<T, N>& value) {
+        if constexpr (Fixed) {
+            return MinSize;
+        } else {
+            std::size_t total = 0;
+            for (const T& element : value) {
+                total += Codec<T, E>::size(element);
+            }
+            return total;
+        }
+    }
+    static std::uint8_t* write(std::uint8_t* out, const std::array<T, N>& value) {
+        if constexpr (Bulk) {
+            swap_bytes<T>(out, reinterpret_cast<const std::uint8_t*>(value.data()), N);
+            return out + sizeof(T) * N;
+        } else {
+            for (const T& element : value) {
+                out = Codec<T, E>::write(out, element);
+            }
+            return out;
+        }
+    }
+    static bool read(Reader& in, std::array<T, N>& value) {
+        if constexpr (Bulk) {
+            const std::uint8_t* data = in.take(sizeof(T) * N);
+            if (data != nullptr) {
+                swap_bytes<T>(reinterpret_cast<std::uint8_t*>(value.data()), data, N);
+            }
+            return data != nullptr;
+        } else {
+            for (T& element : value) {
+                if (!Codec<T, E>::read(in, element)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+};
+
+/**
+ * Плотные форматы (packing.hpp): фиксированный размер в обоих кодированиях
+ * Packed - Size младших байт слова, младший первым: байты выделяются
+ *       сдвигами, а не store_le, чтобы усечение слова не зависело от порядка
+ *       байт узла; Quantized и Half - целое своего размера
+ * Запись и чтение без ветвлений по значению (циклы Packed развертываются)
+ */
+
+template<typename... Fields, Encoding E>
+struct Codec<Packed<Fields...>, E> {
+    using Value = Packed<Fields...>;
+    using Word = typename Value::Word;
+
+    static constexpr bool Fixed = true;
+    static constexpr std::size_t MinSize = Value::Size;
+    static constexpr bool Plain = false;
+    static constexpr bool View = false;
+
+    static std::size_t size(const Value&) { return Value::Size; }
+    static std::uint8_t* write(std::uint8_t* out, const Value& value) {
+        Word bits = value.pack();
+        for (std::size_t i = 0; i < Value::Size; ++i) {
+            out[i] = static_cast<std::uint8_t>(bits >> (8 * i));
+        }
+        return out + Value::Size;
+    }
+    static bool read(Reader& in, Value& value) {
+        const std::uint8_t* data = in.take(Value::Size);
+        if (data == nullptr) {
+            return false;
+        }
+        Word bits = 0;
+        for (std::size_t i = 0; i < Value::Size; ++i) {
+            bits |= static_cast<Word>(data[i]) << (8 * i);
+        }
+        return value.unpack(bits);
+    }
+};
+
+template<std::int32_t Min, std::int32_t Max, typename Storage, std::int32_t Scale, Encoding E>
+struct Codec<Quantized<Min, Max, Storage, Scale>, E> {
+    using Value = Quantized<Min, Max, Storage, Scale>;
+
+    static constexpr bool Fixed = true;
+    static constexpr std::size_t MinSize = sizeof(Storage);
+    static constexpr bool Plain = false;
+    static constexpr bool View = false;
+
+    static std::size_t size(const Value&) { return sizeof(Storage); }
+    static std::uint8_t* write(std::uint8_t* out, const Value& value) {
+        store_le(out, value.encode());
+        return out + sizeof(Storage);
+    }
+    static bool read(Reader& in, Value& value) {
+        const std::uint8_t* data = in.take(sizeof(Storage));
+        if (data != nullptr) {
+            Storage bits;
+            load_le(data, bits);
+            value.decode(bits);
+        }
+        return data != nullptr;
+    }
+};
+
+template<Encoding E>
+struct Codec<Half, E> {
+    static constexpr bool Fixed = true;
+    static constexpr std::size_t MinSize = sizeof(std::uint16_t);
+    static constexpr bool Plain = false;
+    static constexpr bool View = false;
+
+    static std::size_t size(const Half&) { return sizeof(std::uint16_t); }
+    static std::uint8_t* write(std::uint8_t* out, const Half& value) {
+        store_le(out, value.encode());
+        return out + sizeof(std::uint16_t);
+    }
+    static bool read(Reader& in, Half& value) {
+        const std::uint8_t* data = in.take(sizeof(std::uint16_t));
+        if (data != nullptr) {
+            std::uint16_t bits;
+            load_le(data, bits);
+            value.decode(bits);
+        }
+        return data != nullptr;
+    }
+};
+
 /**
  * Статический класс для бинарной сериализации и десериализации данных
- * 
- * Использует простое копирование памяти (memcpy) для POD-типов
- * Работает только с тривиально копируемыми типами (POD)
- * Поддерживает сериализацию кортежей с автоматическим вычислением смещений
+ *
+ * Формат каждого типа задает Codec: числа little-endian (на little-endian
+ *       узле - memcpy), структуры - по полям без выравнивания,
+ *       строки и массивы (std::string_view, rpc::Span) передаются с префиксом
+ *       длины, std::optional - с флагом наличия, кортежи - поэлементно
+ * Значения пишутся подряд сразу в буфер кадра; string_view и Span при чтении
+ *       указывают в принятый кадр - объемные данные не копируются
+ * Чтение из принятого буфера всегда проверяет его длину (Reader)
+ *
+ * Политика E задает кодирование целых чисел: Serializer - фиксированный
+ *       размер (memcpy), CompactSerializer - varint/zigzag; кодирование
+ *       сообщения указывает флаг CompactFlag в байте типа
  */
 
-class Serializer {
+template<Encoding E>
+class BasicSerializer {
 public:
-    // Сериализация значения в буфер
+    static constexpr Encoding encoding = E;
+
+    // Размер значения зависит только от типа
+    template<typename... Args>
+    static constexpr bool is_fixed() {
+        return (Codec<std::decay_t<Args>, E>::Fixed && ...);
+    }
+
+    // Прочитанное значение указывает в буфер кадра и действительно, пока жив буфер
+    template<typename... Args>
+    static constexpr bool is_view() {
+        return (Codec<std::decay_t<Args>, E>::View || ...);
+    }
+
+    // Минимальный размер значений в буфере (для фиксированных типов - точный)
+    template<typename... Args>
+    static constexpr std::size_t min_size() {
+        return (Codec<std::decay_t<Args>, E>::MinSize + ... + 0);
+    }
+
+    // Вычисление размера буфера для кортежа фиксированных типов
+    template<typename... Args>
+    static constexpr std::size_t tuple_size() {
+        static_assert(is_fixed<Args...>(), "Size of variable-length values is known only at run time: use size_of");
+        return min_size<Args...>();
+    }
+
+    // Размер сериализованного значения
+    template<typename T>
+    static std::size_t size_of(const T& value) {
+        return Codec<T, E>::size(value);
+    }
+
+    // Суммарный размер значений, записываемых serialize_values
+    template<typename... Args>
+    static std::size_t size_of_values(const Args&... args) {
+        return (Codec<Args, E>::size(args) + ... + 0);
+    }
+
+    // Сериализация значения в буфер; возвращает позицию за последним байтом
     template<typename T>
-    static void serialize(const T& value, std::uint8_t* buffer) {
+    static std::uint8_t* serialize(const T& value, std::uint8_t* buffer) {
         static_assert(!std::is_void_v<T>, "Cannot serialize void type");
-        std::memcpy(buffer, &value, sizeof(T));
+        return Codec<T, E>::write(buffer, value);
     }
 
-    // Десериализация значения из буфера
+    // Десериализация значения фиксированного размера из буфера
     template<typename T>
     static T deserialize(const std::uint8_t* buffer) {
         static_assert(!std::is_void_v<T>, "Cannot deserialize void type");
-        T value;
-        std::memcpy(&value, buffer, sizeof(T));
+        static_assert(Codec<T, E>::Fixed, "Variable-length values need the buffer length");
+        T value{};
+        Reader in(buffer, Codec<T, E>::MinSize);
+        Codec<T, E>::read(in, value);
         return value;
     }
 
+    // Десериализация значения из буфера длиной length; false если буфер короче значения
+    template<typename T>
+    static bool deserialize(const std::uint8_t* buffer, std::size_t length, T& value) {
+        Reader in(buffer, length);
+        T read{};
+        if (!Codec<T, E>::read(in, read)) {
+            return false;
+        }
+        value = read;
+        return true;
+    }
+
     // Сериализация кортежа в буфер
     template<typename... Args>
-    static void serialize_tuple(const std::tuple<Args...>& tuple, std::uint8_t* buffer) {
-        serialize_tuple_impl(tuple, buffer, std::index_sequence_for<Args...>{});
+    static std::uint8_t* serialize_tuple(const std::tuple<Args...>& tuple, std::uint8_t* buffer) {
+        return Codec<std::tuple<Args...>, E>::write(buffer, tuple);
     }
 
-    // Десериализация кортежа из буфера
+    // Сериализация значений подряд без промежуточного кортежа; возвращает позицию за последним байтом
     template<typename... Args>
-    static std::tuple<Args...> deserialize_tuple(const std::uint8_t* buffer) {
-        return deserialize_tuple_impl<Args...>(buffer, std::index_sequence_for<Args...>{});
+    static std::uint8_t* serialize_values(std::uint8_t* buffer, const Args&... args) {
+        ((buffer = Codec<Args, E>::write(buffer, args)), ...);
+        return buffer;
     }
 
-    // Вычисление размера буфера для кортежа
+    /**
+     * Десериализация кортежа значений фиксированного размера из буфера
+     * Длина буфера не проверяется: вызывающий код сравнивает ее с
+     *       tuple_size<Args...>() один раз; побайтные типы читаются memcpy
+     *       по смещениям, известным на этапе компиляции
+     */
     template<typename... Args>
-    static constexpr std::size_t tuple_size() {
-        return (sizeof(Args) + ... + 0);
+    static std::tuple<Args...> deserialize_tuple(const std::uint8_t* buffer) {
+        if constexpr ((Codec<Args, E>::Plain && ...)) {
+            return deserialize_plain<Args...>(buffer, std::index_sequence_for<Args...>{});
+        } else {
+            return deserialize<std::tuple<Args...>>(buffer);
+        }
     }
 
-private:
-    // Вспомогательная функция для сериализации кортежа
-    template<typename... Args, std::size_t... I>
-    static void serialize_tuple_impl(const std::tuple<Args...>& tuple, std::uint8_t* buffer, std::index_sequence<I...>) {
-        (serialize(std::get<I>(tuple), buffer + offset_of<I, Args...>()), ...);
+    // Десериализация кортежа из буфера длиной length; false если длина не совпадает с размером кортежа
+    template<typename... Args>
+    static bool deserialize_tuple(const std::uint8_t* buffer, std::size_t length, std::tuple<Args...>& tuple) {
+        Reader in(buffer, length);
+        return Codec<std::tuple<Args...>, E>::read(in, tuple) && in.remaining() == 0;
     }
 
-    // Вспомогательная функция для десериализации кортежа
+private:
+    // Чтение побайтных значений по смещениям, вычисленным на этапе компиляции
     template<typename... Args, std::size_t... I>
-    static std::tuple<Args...> deserialize_tuple_impl(const std::uint8_t* buffer, std::index_sequence<I...>) {
-        return std::tuple<Args...>{deserialize<std::tuple_element_t<I, std::tuple<Args...>>>(buffer + offset_of<I, Args...>())...};
+    static std::tuple<Args...> deserialize_plain([[maybe_unused]] const std::uint8_t* buffer, std::index_sequence<I...>) {
+        std::tuple<Args...> tuple;
+        (std::memcpy(&std::get<I>(tuple), buffer + offset_of<I, Args...>(), sizeof(Args)), ...);
+        return tuple;
     }
 
-    // Вычисление смещения элемента в сериализованном кортеже
+    // Смещение элемента N в сериализованном кортеже
     template<std::size_t N, typename... Args>
     static constexpr std::size_t offset_of() {
         if constexpr (N == 0) {
@@ -74,4 +634,27 @@ private:
     }
 };
 
+// Фиксированный размер целых чисел (формат по умолчанию)
+using Serializer = BasicSerializer<Encoding::Fixed>;
+// Целые числа varint/zigzag
+using CompactSerializer = BasicSerializer<Encoding::Compact>;
+
+/**
+ * Выбор сериализатора по кодированию, известному только во время выполнения
+ * visitor - обобщенная лямбда, получающая BasicSerializer<E> по значению
+ * При RPC_ENABLE_COMPACT=0 экземпляр для Compact не создается: такие сообщения
+ *       отклоняются раньше, до разбора полезных данных
+ * Пример: visit_encoding(encoding, [&](auto serializer) { return decltype(serializer)::size_of(value); })
+ */
+
+template<typename Visitor>
+decltype(auto) visit_encoding(Encoding encoding, Visitor&& visitor) {
+    if constexpr (CompactEnabled) {
+        if (encoding == Encoding::Compact) {
+            return visitor(CompactSerializer{});
+        }
+    }
+    return visitor(Serializer{});
+}
+
 } // namespace rpc
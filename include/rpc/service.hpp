@@ -3,58 +3,449 @@
 #include <string>
 #include <functional>
 #include <map>
+#include <memory>
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "semphr.h"
 #include "types.hpp"
 #include "../protocol/parser.hpp"
+#include "../utils/slot_pool.hpp"
+#include "method.hpp"
 #include "serializer.hpp"
+#include "signature.hpp"
+
+// Максимальное число одновременно незавершенных отложенных вызовов (переопределяется через build_flags)
+#ifndef RPC_MAX_DEFERRED_CALLS
+#define RPC_MAX_DEFERRED_CALLS 4
+#endif
+
+// Число последних отправленных ответов, хранимых для повторных запросов (переопределяется через build_flags)
+#ifndef RPC_REPLAY_WINDOW
+#define RPC_REPLAY_WINDOW 4
+#endif
 
 namespace rpc {
 
+class Service;
+
+/**
+ * Токен завершения отложенного (асинхронного) RPC вызова
+ * Result Тип результата вызова (может быть void)
+ *
+ * Выдается сервисом handler'у, зарегистрированному через register_deferred_handler
+ * Handler запускает долгую операцию (АЦП, I2C), сохраняет токен и возвращает его
+ *       сервису; ответ отправляется позже вызовом complete() из любой задачи
+ *       или complete_from_isr() из прерывания
+ * Пустой токен (созданный конструктором по умолчанию) означает отказ - сервис
+ *       отвечает клиенту ошибкой
+ */
+
+template<typename Result>
+class Deferred {
+public:
+    Deferred() = default;
+
+    // Токен привязан к незавершенному вызову
+    bool valid() const { return m_service != nullptr; }
+    // Порядковый номер запроса, к которому относится токен
+    std::uint8_t seq() const { return m_seq; }
+
+    // Завершение вызова с отправкой ответа (из контекста задачи)
+    template<typename... Value>
+    bool complete(const Value&... value) const;
+    // Завершение вызова из прерывания - ответ отправит задача сервиса
+    template<typename... Value>
+    bool complete_from_isr(BaseType_t* higher_priority_task_woken, const Value&... value) const;
+
+private:
+    friend class Service;
+    Deferred(Service* service, std::uint8_t slot, std::uint8_t generation, std::uint8_t seq, Encoding encoding)
+        : m_service(service), m_slot(slot), m_generation(generation), m_seq(seq), m_encoding(encoding) {}
+
+    // Сериализация результата в кодировании запроса, возвращает длину
+    // (больше Packet::MaxSize - результат не помещается и не записан)
+    template<typename... Value>
+    std::size_t encode(std::uint8_t* buffer, const Value&... value) const;
+
+    Service* m_service{nullptr};    // Сервис, ожидающий завершения
+    std::uint8_t m_slot{0};         // Индекс слота отложенного вызова
+    std::uint8_t m_generation{0};   // Поколение слота (защита от устаревших токенов)
+    std::uint8_t m_seq{0};          // Порядковый номер запроса
+    Encoding m_encoding{Encoding::Fixed};   // Кодирование запроса - в нем же кодируется результат
+};
+
+/**
+ * Параметры регистрации handler'а
+ *
+ * Для медленно меняющихся значений (get_temperature) результат можно кэшировать:
+ *       повтор вызова с теми же аргументами в пределах ttl получает
+ *       сохраненный сериализованный результат без вызова handler'а
+ * Результат можно разрешить кэшировать и клиенту (max_age_ms): ответ
+ *       уходит как CachedResponse, и клиент отвечает из своего кэша без
+ *       обращения к UART, пока не истечет срок или не придет Invalidate
+ *       (Service::invalidate при изменении значения)
+ */
+
+struct HandlerOptions {
+    TickType_t ttl{0};              // Время жизни результата в тиках FreeRTOS (0 - без кэша, portMAX_DELAY - бессрочно)
+    std::uint16_t max_age_ms{0};    // Срок кэширования результата клиентом (0 - не кэшируется, UntilInvalidated - до Invalidate)
+
+    // Чистая функция: результат зависит только от аргументов
+    static constexpr HandlerOptions pure() { return HandlerOptions{portMAX_DELAY}; }
+    // Результат действителен ttl тиков
+    static constexpr HandlerOptions cached(TickType_t ttl) { return HandlerOptions{ttl}; }
+    // Клиент может кэшировать результат max_age_ms миллисекунд или до Invalidate
+    static constexpr HandlerOptions client_cached(std::uint16_t max_age_ms = UntilInvalidated) {
+        return HandlerOptions{0, max_age_ms};
+    }
+};
+
+// Счетчики попаданий и промахов кэша результатов
+struct CacheStats {
+    std::uint32_t hits{0};      // Ответ отправлен из кэша
+    std::uint32_t misses{0};    // Handler выполнен, результат сохранен
+};
+
 /**
  * RPC сервер для регистрации и выполнения удаленных процедур
- * 
+ *
  * Принимает входящие RPC запросы, выполняет зарегистрированные handlers
  *       и возвращает результаты обратно через протокол
- * Все handlers должны быть thread-safe (вызываются из контекста парсера)
+ * Парсер только кладет запросы во входящую очередь, handlers выполняются
+ *       в задаче сервиса, которая блокируется в process() до прихода запроса
+ * Отложенные handlers не блокируют задачу сервиса: ответ на них отправляется
+ *       по токену Deferred, пока сервис продолжает обрабатывать другие запросы
+ * Последние ответы хранятся в кольцевом окне: повтор запроса с тем же seq
+ *       и теми же данными получает сохраненный ответ без повторного выполнения
+ *       handler'а (не более одного выполнения, например, для set_led)
+ * То же окно служит историей передачи: Nack клиента на поврежденный ответ
+ *       сразу повторяет его, не дожидаясь повторного запроса по таймауту
+ * Функции из IDL регистрируются с MethodId (сгенерированный bind) и
+ *       вызываются по идентификатору: поиск handler'а - по 16-битному ключу
+ *       вместо строки; по имени они доступны так же, как остальные
  */
 
 class Service {
 public:
+    // Глубина входящей очереди (число слотов запросов)
+    static constexpr std::size_t RequestQueueLength = 4;
+    // Максимальное число одновременно незавершенных отложенных вызовов
+    static constexpr std::size_t MaxDeferredCalls = RPC_MAX_DEFERRED_CALLS;
+    // Размер окна сохраненных ответов для повторных запросов
+    static constexpr std::size_t ReplayWindowSize = RPC_REPLAY_WINDOW;
+    // Максимальное число вызовов в одном пакетном запросе
+    static constexpr std::size_t MaxBatchCalls = 8;
+
     // Конструктор RPC сервиса
     explicit Service(protocol::Parser& parser);
-    // Основной цикл обработки входящих запросов
-    void process();
-    // Обработчик входящего пакета
-    void handle_packet(const protocol::Packet& packet);
+    // Ожидание и обработка всех накопившихся запросов
+    void process(TickType_t timeout = portMAX_DELAY);
+    // Обработчик входящего пакета (постановка запроса в очередь)
+    bool handle_packet(const protocol::Packet& packet);
+
+    // Суммарная статистика кэша результатов
+    CacheStats cache_stats() const;
+    // Статистика кэша результатов одной функции, false если функция не кэшируется
+    bool cache_stats(const std::string& name, CacheStats& stats) const;
+    // Сообщение клиентам об изменении значения функции (сбрасывает и кэш сервиса), из любой задачи
+    bool invalidate(const std::string& name);
 
-    // Регистрация handler'а RPC функции
+    /**
+     * Регистрация handler'а RPC функции
+     * Аргументы std::string_view и rpc::Span указывают прямо в принятый кадр
+     *       и действительны только во время выполнения handler'а
+     * Запрос с отпечатком других типов (signature.hpp) получает ошибку
+     *       ErrorCode::SignatureMismatch, запрос, длина аргументов которого не
+     *       совпадает с сигнатурой, - ErrorCode::BadArguments; handler не вызывается
+     * Аргументы декодируются, а результат кодируется в кодировании запроса
+     *       (Encoding::Compact, если клиент выставил CompactFlag)
+     */
+    template<typename Result, typename... Args>
+    bool register_handler(const std::string& name, Result (*func)(Args...), HandlerOptions options = {}) {
+        Handler& handler = m_handlers[name];
+        handler.cache.reset(options.ttl != 0 ? new CachedResult{} : nullptr);
+        handler.ttl = options.ttl;
+        handler.max_age_ms = options.max_age_ms;
+        handler.deferred = false;
+        handler.signature = signature_of<Result, Args...>();
+        handler.invoke = [func](const std::uint8_t* args, std::size_t args_length, Encoding encoding,
+                                std::uint8_t* res, std::size_t* res_length) {
+            return visit_encoding(encoding, [&](auto serializer) {
+                using Codec = decltype(serializer);
+                // Десериализация аргументов из бинарных данных (строки и массивы - без копирования)
+                std::tuple<std::decay_t<Args>...> args_tuple;
+                if (!decode_arguments<Codec>(args, args_length, args_tuple)) {
+                    return HandlerStatus::BadArguments;
+                }
+                if constexpr (std::is_void_v<Result>) {
+                    // Для void-функций: только выполняем, не возвращаем результат
+                    std::apply(func, args_tuple);
+                    *res_length = 0;
+                } else {
+                    // Для не-void функций: выполняем и сериализуем результат
+                    auto result = std::apply(func, args_tuple);
+                    std::size_t length = Codec::size_of(result);
+                    if (length > protocol::Packet::MaxSize) {
+                        return HandlerStatus::ResultTooLarge;
+                    }
+                    Codec::serialize(result, res);
+                    *res_length = length;
+                }
+                return HandlerStatus::Done;
+            });
+        };
+        return true;
+    }
+
+    // Регистрация handler'а функции из IDL: по имени и по идентификатору
     template<typename Result, typename... Args>
-    bool register_handler(const std::string& name, Result (*func)(Args...)) {
-        m_handlers[name] = [func](const std::uint8_t* args, std::size_t args_length, std::uint8_t* res, std::size_t* res_length) {
-            // Десериализация аргументов из бинарных данных
-            auto args_tuple = Serializer::deserialize_tuple<Args...>(args);
-            if constexpr (std::is_void_v<Result>) {
-                // Для void-функций: только выполняем, не возвращаем результат
-                std::apply(func, args_tuple);
-                *res_length = 0;
-            } else {
-                // Для не-void функций: выполняем и сериализуем результат
-                auto result = std::apply(func, args_tuple);
-                Serializer::serialize(result, res);
-                *res_length = sizeof(result);
+    bool register_handler(const MethodId& method, Result (*func)(Args...), HandlerOptions options = {}) {
+        return register_handler(method.name, func, options) && register_id(method);
+    }
+
+    /**
+     * Регистрация отложенного handler'а RPC функции
+     * Handler получает токен завершения первым аргументом и возвращает его,
+     *       если ответ будет отправлен позже, или пустой токен при отказе
+     * Пример: Deferred<float> read_adc(Deferred<float> done, std::uint8_t channel)
+     */
+    template<typename Result, typename... Args>
+    bool register_deferred_handler(const std::string& name, Deferred<Result> (*func)(Deferred<Result>, Args...)) {
+        Handler& handler = m_handlers[name];
+        handler.cache.reset();
+        handler.ttl = 0;
+        handler.max_age_ms = 0;
+        handler.deferred = true;
+        handler.signature = signature_of<Result, Args...>();
+        handler.invoke = [this, func](const std::uint8_t* args, std::size_t args_length, Encoding encoding,
+                                      std::uint8_t*, std::size_t*) {
+            std::tuple<std::decay_t<Args>...> args_tuple;       // string_view и Span действительны только до возврата из handler'а
+            bool decoded = visit_encoding(encoding, [&](auto serializer) {
+                return decode_arguments<decltype(serializer)>(args, args_length, args_tuple);
+            });
+            if (!decoded) {
+                return HandlerStatus::BadArguments;
+            }
+            int slot = acquire_deferred();
+            if (slot < 0) {
+                return HandlerStatus::Busy;                     // Достигнут лимит незавершенных вызовов
             }
+            std::uint8_t generation = m_deferred[slot].generation;
+            Deferred<Result> token(this, static_cast<std::uint8_t>(slot), generation, m_deferred[slot].seq, encoding);
+            Deferred<Result> pending = std::apply([&](auto... unpacked) { return func(token, unpacked...); }, args_tuple);
+            if (!pending.valid()) {
+                release_deferred(static_cast<std::uint8_t>(slot), generation);
+                return HandlerStatus::Rejected;                 // Handler отказался выполнять вызов
+            }
+            return HandlerStatus::Deferred;
         };
         return true;
     }
 
+    // Регистрация отложенного handler'а функции из IDL: по имени и по идентификатору
+    template<typename Result, typename... Args>
+    bool register_deferred_handler(const MethodId& method, Deferred<Result> (*func)(Deferred<Result>, Args...)) {
+        return register_deferred_handler(method.name, func) && register_id(method);
+    }
+
 private:
-    protocol::Parser& m_parser; // Парсер для получения входящих пакетов
+    template<typename Result>
+    friend class Deferred;
+
+    // Результат выполнения handler'а; остальные значения - отказ, клиенту отправляется ошибка
+    enum class HandlerStatus : std::uint8_t {
+        Done,           // Результат готов и записан в буфер ответа
+        Deferred,       // Ответ будет отправлен позже по токену Deferred
+        BadArguments,   // Длина аргументов не совпадает с сигнатурой
+        ResultTooLarge, // Результат не помещается в ответ
+        Busy,           // Нет свободного слота отложенного вызова
+        Rejected        // Handler отказался выполнять вызов
+    };
+
+    /**
+     * Декодирование аргументов handler'а
+     * Для аргументов фиксированного размера ожидаемая длина вычисляется на
+     *       этапе компиляции: горячий путь - одно сравнение и memcpy по
+     *       известным смещениям; строки и массивы читаются с проверкой каждой
+     *       длины и должны занять аргументы целиком
+     */
+    template<typename Codec, typename... Args>
+    static bool decode_arguments(const std::uint8_t* args, std::size_t length, std::tuple<Args...>& tuple) {
+        if constexpr (Codec::template is_fixed<Args...>()) {
+            if (length != Codec::template tuple_size<Args...>()) {
+                return false;
+            }
+            tuple = Codec::template deserialize_tuple<Args...>(args);
+            return true;
+        } else {
+            return Codec::deserialize_tuple(args, length, tuple);
+        }
+    }
+
+    // Причина ошибки для отказа handler'а
+    static ErrorCode reason_of(HandlerStatus status);
+
+    // Вид элемента входящей очереди
+    enum class RequestKind : std::uint8_t {
+        Call,       // Запрос от клиента
+        Completion  // Завершение отложенного вызова из прерывания
+    };
+
+    // Запрос в пуле входящих запросов; через очередь передается только индекс слота
+    struct Request {
+        RequestKind kind;                               // Вид элемента
+        std::uint8_t seq;                               // Порядковый номер запроса
+        std::uint8_t crc;                               // CRC данных запроса (отличает повтор от нового запроса с тем же seq)
+        std::uint8_t slot;                              // Слот отложенного вызова (для Completion)
+        std::uint8_t generation;                        // Поколение слота (для Completion)
+        Encoding encoding;                              // Кодирование аргументов (флаг CompactFlag запроса)
+        std::size_t length;                             // Длина полезных данных
+        std::uint8_t data[protocol::Packet::MaxSize];   // type | seq | name\0 | args... или результат
+    };
+
+    // Незавершенный отложенный вызов
+    struct DeferredCall {
+        bool active{false};                 // Слот занят
+        std::uint8_t generation{0};         // Увеличивается при каждом занятии слота
+        std::uint8_t seq{0};                // Порядковый номер запроса
+        std::uint8_t request_crc{0};        // CRC данных запроса
+        Encoding encoding{Encoding::Fixed}; // Кодирование запроса - в нем же отправляется результат
+        const std::string* name{nullptr};   // Имя функции (ключ в m_handlers)
+    };
+
+    // Сохраненный ответ в окне повторов, ключ - (seq, CRC запроса)
+    struct ReplayEntry {
+        bool valid{false};                              // Запись заполнена
+        std::uint8_t seq{0};                            // Порядковый номер запроса
+        std::uint8_t request_crc{0};                    // CRC данных запроса
+        MessageType type{MessageType::Response};        // Тип ответа
+        std::size_t length{0};                          // Длина сохраненного ответа
+        std::uint8_t data[protocol::Packet::MaxSize]{}; // Сериализованный ответ: type | seq | name\0 | result...
+    };
+
+    // Сохраненный результат кэшируемого handler'а (последний набор аргументов)
+    struct CachedResult {
+        bool valid{false};                                  // Результат сохранен
+        TickType_t timestamp{0};                            // Момент выполнения handler'а
+        Encoding encoding{Encoding::Fixed};                 // Кодирование аргументов и результата
+        std::size_t args_length{0};                         // Длина аргументов
+        std::size_t result_length{0};                       // Длина сериализованного результата
+        std::uint8_t args[protocol::Packet::MaxSize]{};     // Аргументы, для которых сохранен результат
+        std::uint8_t result[protocol::Packet::MaxSize]{};   // Сериализованный результат
+        CacheStats stats;                                   // Счетчики попаданий и промахов
+    };
+
+    // Зарегистрированный handler
+    struct Handler {
+        std::function<HandlerStatus(const std::uint8_t*, std::size_t, Encoding, std::uint8_t*, std::size_t*)> invoke;  // Функтор обработки
+        TickType_t ttl{0};                      // Время жизни результата (0 - без кэша)
+        std::uint16_t max_age_ms{0};            // Срок кэширования результата клиентом (0 - не кэшируется)
+        bool deferred{false};                   // Отложенный handler (ответ по токену Deferred)
+        std::uint16_t signature{0};             // Отпечаток сигнатуры Result(Args...)
+        std::unique_ptr<CachedResult> cache;    // Кэш результата, только для кэшируемых функций
+    };
+
+    // Таблица handlers по имени
+    using HandlerMap = std::map<std::string, Handler>;
+
+    // Привязка идентификатора к уже зарегистрированному по имени handler'у
+    bool register_id(const MethodId& method);
+    // Поиск handler'а по полю адресата name\0 или \0 | id; field_length - длина поля (0 - поле повреждено)
+    HandlerMap::iterator find_handler(const std::uint8_t* field, std::size_t available, std::size_t& field_length);
+
+    // Выполнение запроса и отправка ответа
+    void dispatch(const Request& request);
+    // Выполнение пакетного запроса и отправка сводного ответа
+    void dispatch_batch(const Request& request);
+    // Выполнение handler'а с учетом кэша результатов
+    HandlerStatus execute(Handler& handler, const std::uint8_t* args, std::size_t args_length, Encoding encoding,
+                          std::uint8_t* res, std::size_t* res_length);
+    // Занятие слота под текущий запрос, -1 если свободных нет
+    int acquire_deferred();
+    // Освобождение слота, если токен еще актуален
+    bool release_deferred(std::uint8_t slot, std::uint8_t generation);
+    // Отправка результата отложенного вызова и освобождение слота
+    bool complete_deferred(std::uint8_t slot, std::uint8_t generation, const std::uint8_t* result, std::size_t length);
+    // Передача результата отложенного вызова из прерывания в задачу сервиса
+    bool complete_deferred_from_isr(std::uint8_t slot, std::uint8_t generation, const std::uint8_t* result,
+                                    std::size_t length, BaseType_t* higher_priority_task_woken);
+    // Повторная отправка сохраненного ответа, false если запрос новый
+    bool replay(std::uint8_t seq, std::uint8_t request_crc);
+    // Повторная отправка последнего ответа с порядковым номером seq по Nack
+    bool resend(std::uint8_t seq);
+    // Отправка ответа (type | seq | name\0 | result...) с сохранением в окне, вызывается под m_tx_mutex
+    // Результат в Encoding::Compact помечается флагом CompactFlag в байте типа
+    void send_response(std::uint8_t seq, std::uint8_t request_crc, const std::string& name,
+                       const std::uint8_t* result, std::size_t length, std::uint16_t max_age_ms = 0,
+                       Encoding encoding = Encoding::Fixed);
+    // Сохранение готового ответа в окне повторов и отправка, вызывается под m_tx_mutex
+    void send_reply(std::uint8_t seq, std::uint8_t request_crc, MessageType type,
+                    const std::uint8_t* data, std::size_t length);
+    // Отправка сообщения об ошибке Error | seq | reason, вызывается под m_tx_mutex
+    void send_error(std::uint8_t seq, ErrorCode reason);
+
+    protocol::Parser& m_parser;             // Парсер для получения входящих пакетов
+    utils::SlotPool<Request, RequestQueueLength> m_requests;    // Слоты входящих запросов
+    QueueHandle_t m_request_queue;          // Очередь индексов слотов от парсера к задаче сервиса
+    SemaphoreHandle_t m_tx_mutex;           // Защита UART и слотов при завершении вызовов из других задач
+    DeferredCall m_deferred[MaxDeferredCalls];  // Таблица незавершенных отложенных вызовов
+    ReplayEntry m_replay[ReplayWindowSize]; // Кольцевое окно последних ответов
+    std::size_t m_replay_next{0};           // Индекс следующей записи в окне
+    std::uint8_t m_current_seq{0};          // Порядковый номер запроса, выполняемого в dispatch
+    std::uint8_t m_current_crc{0};          // CRC запроса, выполняемого в dispatch
+    const std::string* m_current_name{nullptr}; // Имя функции запроса, выполняемого в dispatch
+    Encoding m_current_encoding{Encoding::Fixed};   // Кодирование запроса, выполняемого в dispatch
     /**
      * Map зарегистрированных обработчиков RPC функций
      * Имя RPC функции (std::string)
-     * Функтор обработки: void(const uint8_t* args, size_t args_length, 
-     *                                uint8_t* res, size_t* res_length)
+     * Handler: функтор HandlerStatus(const uint8_t* args, size_t args_length, Encoding encoding,
+     *                                uint8_t* res, size_t* res_length) и кэш результата
      */
-    std::map<std::string, std::function<void(const std::uint8_t*, std::size_t, std::uint8_t*, std::size_t*)>> m_handlers;
+    HandlerMap m_handlers;
+    // Handlers функций из IDL по идентификатору (ссылки в m_handlers)
+    std::map<std::uint16_t, HandlerMap::iterator> m_ids;
 };
 
+template<typename Result>
+template<typename... Value>
+std::size_t Deferred<Result>::encode(std::uint8_t* buffer, const Value&... value) const {
+    if constexpr (std::is_void_v<Result>) {
+        static_assert(sizeof...(Value) == 0, "void call is completed without a value");
+        (void)buffer;
+        return 0;
+    } else {
+        static_assert(sizeof...(Value) == 1, "call is completed with exactly one result value");
+        return visit_encoding(m_encoding, [&](auto serializer) {
+            using Codec = decltype(serializer);
+            std::size_t length = (Codec::size_of(static_cast<const Result&>(value)) + ...);
+            if (length <= protocol::Packet::MaxSize) {
+                (Codec::serialize(static_cast<const Result&>(value), buffer), ...);
+            }
+            return length;
+        });
+    }
+}
+
+template<typename Result>
+template<typename... Value>
+bool Deferred<Result>::complete(const Value&... value) const {
+    if (!valid()) {
+        return false;
+    }
+    std::uint8_t buffer[protocol::Packet::MaxSize];
+    std::size_t length = encode(buffer, value...);
+    return m_service->complete_deferred(m_slot, m_generation, buffer, length);
+}
+
+template<typename Result>
+template<typename... Value>
+bool Deferred<Result>::complete_from_isr(BaseType_t* higher_priority_task_woken, const Value&... value) const {
+    if (!valid()) {
+        return false;
+    }
+    std::uint8_t buffer[protocol::Packet::MaxSize];
+    std::size_t length = encode(buffer, value...);
+    return m_service->complete_deferred_from_isr(m_slot, m_generation, buffer, length, higher_priority_task_woken);
+}
+
 } // namespace rpc
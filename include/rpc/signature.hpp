@@ -0,0 +1,184 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include "endian.hpp"
+#include "fields.hpp"
+#include "packing.hpp"
+#include "span.hpp"
+
+// Отпечаток сигнатуры в запросах (0 - не передается; значение должно совпадать на обоих концах канала)
+#ifndef RPC_ENABLE_SIGNATURES
+#define RPC_ENABLE_SIGNATURES 1
+#endif
+
+namespace rpc {
+
+/**
+ * Отпечаток сигнатуры Result(Args...) вызова
+ *
+ * Запрос несет после имени функции 16-битный отпечаток типов результата
+ *       и аргументов: type | seq | name\0 | signature | args...
+ * Отпечаток вычисляется на этапе компиляции (FNV-1a по коду каждого типа),
+ *       сервис сравнивает его с отпечатком handler'а одним сравнением до
+ *       разбора аргументов и отвечает ErrorCode::SignatureMismatch
+ *
+ * Код типа описывает формат в кадре, а не имя типа: std::string и
+ *       std::string_view совпадают, структура кодируется своими полями,
+ *       поэтому отпечаток одинаков у прошивки и хоста с разными компиляторами
+ * Собственный тип со своей специализацией Codec описывается специализацией
+ *       TypeSignature с тем же членом fold
+ */
+
+// Размер отпечатка в запросе
+constexpr std::size_t SignatureSize = RPC_ENABLE_SIGNATURES ? sizeof(std::uint16_t) : 0;
+
+// Шаг FNV-1a: добавление байта кода типа к отпечатку
+constexpr std::uint32_t fnv1a(std::uint32_t hash, std::uint8_t byte) {
+    return (hash ^ byte) * 16777619u;
+}
+
+// Код типа T в отпечатке: fold(hash) добавляет байты кода
+// Общий шаблон - тривиально копируемые типы без разбора на поля (копируются как есть)
+template<typename T, typename Enable = void>
+struct TypeSignature {
+    static constexpr std::uint32_t fold(std::uint32_t hash) {
+        return fnv1a(fnv1a(hash, 'r'), static_cast<std::uint8_t>(sizeof(T)));
+    }
+};
+
+template<>
+struct TypeSignature<void> {
+    static constexpr std::uint32_t fold(std::uint32_t hash) { return fnv1a(hash, 'v'); }
+};
+
+template<>
+struct TypeSignature<bool> {
+    static constexpr std::uint32_t fold(std::uint32_t hash) { return fnv1a(hash, 'b'); }
+};
+
+// char отдельно: его знаковость различается у компиляторов прошивки и хоста
+template<>
+struct TypeSignature<char> {
+    static constexpr std::uint32_t fold(std::uint32_t hash) { return fnv1a(hash, 'c'); }
+};
+
+// Целые числа и enum (по базовому типу): знаковость и размер
+template<typename T>
+struct TypeSignature<T, std::enable_if_t<(std::is_integral_v<T> && !std::is_same_v<T, bool> && !std::is_same_v<T, char>)
+                                         || std::is_enum_v<T>>> {
+    using Integer = typename std::conditional_t<std::is_enum_v<T>, std::underlying_type<T>, std::enable_if<true, T>>::type;
+    static constexpr std::uint32_t fold(std::uint32_t hash) {
+        return fnv1a(fnv1a(hash, std::is_signed_v<Integer> ? 'i' : 'u'), static_cast<std::uint8_t>(sizeof(T)));
+    }
+};
+
+template<typename T>
+struct TypeSignature<T, std::enable_if_t<std::is_floating_point_v<T>>> {
+    static constexpr std::uint32_t fold(std::uint32_t hash) {
+        return fnv1a(fnv1a(hash, 'f'), static_cast<std::uint8_t>(sizeof(T)));
+    }
+};
+
+// Строки: один формат length | chars...
+template<>
+struct TypeSignature<std::string_view> {
+    static constexpr std::uint32_t fold(std::uint32_t hash) { return fnv1a(hash, 's'); }
+};
+template<>
+struct TypeSignature<std::string> : TypeSignature<std::string_view> {};
+
+template<typename T>
+struct TypeSignature<Span<T>> {
+    static constexpr std::uint32_t fold(std::uint32_t hash) { return TypeSignature<T>::fold(fnv1a(hash, 'a')); }
+};
+
+template<typename T>
+struct TypeSignature<std::optional<T>> {
+    static constexpr std::uint32_t fold(std::uint32_t hash) { return TypeSignature<T>::fold(fnv1a(hash, 'o')); }
+};
+
+template<typename... Ts>
+struct TypeSignature<std::tuple<Ts...>> {
+    static constexpr std::uint32_t fold(std::uint32_t hash) {
+        hash = fnv1a(fnv1a(hash, 't'), static_cast<std::uint8_t>(sizeof...(Ts)));
+        ((hash = TypeSignature<Ts>::fold(hash)), ...);
+        return hash;
+    }
+};
+
+template<typename T, std::size_t N>
+struct TypeSignature<std::array<T, N>> {
+    static constexpr std::uint32_t fold(std::uint32_t hash) {
+        hash = fnv1a(fnv1a(fnv1a(hash, 'A'), static_cast<std::uint8_t>(N)), static_cast<std::uint8_t>(N >> 8));
+        return TypeSignature<T>::fold(hash);
+    }
+};
+
+// Плотные форматы: ширины полей Packed, диапазон и размер Quantized
+template<typename... Fields>
+struct TypeSignature<Packed<Fields...>> {
+    static constexpr std::uint32_t fold(std::uint32_t hash) {
+        hash = fnv1a(fnv1a(hash, 'p'), static_cast<std::uint8_t>(sizeof...(Fields)));
+        ((hash = TypeSignature<Fields>::fold(fnv1a(hash, static_cast<std::uint8_t>(BitWidth<Fields>::value)))), ...);
+        return hash;
+    }
+};
+
+template<std::int32_t Min, std::int32_t Max, typename Storage, std::int32_t Scale>
+struct TypeSignature<Quantized<Min, Max, Storage, Scale>> {
+    static constexpr std::uint32_t fold(std::uint32_t hash) {
+        hash = fnv1a(fnv1a(hash, 'q'), static_cast<std::uint8_t>(sizeof(Storage)));
+        for (std::uint32_t word : {static_cast<std::uint32_t>(Min), static_cast<std::uint32_t>(Max), static_cast<std::uint32_t>(Scale)}) {
+            for (int shift = 0; shift < 32; shift += 8) {
+                hash = fnv1a(hash, static_cast<std::uint8_t>(word >> shift));
+            }
+        }
+        return hash;
+    }
+};
+
+template<>
+struct TypeSignature<Half> {
+    static constexpr std::uint32_t fold(std::uint32_t hash) { return fnv1a(hash, 'h'); }
+};
+
+// Агрегатная структура - как кортеж своих полей: в кадре они лежат так же, подряд
+template<typename T>
+struct TypeSignature<T, std::enable_if_t<IsReflectable<T>::value>> : TypeSignature<FieldTypesOf<T>> {};
+
+// Отпечаток сигнатуры Result(Args...): 32-битный FNV-1a, свернутый в 16 бит
+template<typename Result, typename... Args>
+constexpr std::uint16_t signature_of() {
+    std::uint32_t hash = TypeSignature<std::remove_cv_t<Result>>::fold(2166136261u);
+    hash = fnv1a(hash, '(');
+    ((hash = TypeSignature<std::decay_t<Args>>::fold(hash)), ...);
+    return static_cast<std::uint16_t>(hash ^ (hash >> 16));
+}
+
+// Запись отпечатка в запрос; возвращает позицию за ним
+inline std::uint8_t* write_signature(std::uint8_t* out, std::uint16_t signature) {
+    if constexpr (SignatureSize != 0) {
+        store_le(out, signature);
+    }
+    return out + SignatureSize;
+}
+
+// Отпечаток запроса совпадает с ожидаемым (всегда, если отпечатки отключены)
+inline bool signature_matches(const std::uint8_t* in, std::uint16_t expected) {
+    if constexpr (SignatureSize != 0) {
+        std::uint16_t received;
+        load_le(in, received);
+        return received == expected;
+    } else {
+        (void)in;
+        (void)expected;
+        return true;
+    }
+}
+
+} // namespace rpc
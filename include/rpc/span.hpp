@@ -0,0 +1,95 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include "endian.hpp"
+
+namespace rpc {
+
+/**
+ * Представление массива элементов T без копирования (аналог std::span для C++17)
+ *
+ * Аргумент вызова: Span ссылается на массив вызывающего кода, элементы
+ *       сериализуются прямо в кадр как count | elements...
+ * Аргумент handler'а: Span указывает в принятый кадр - массив не копируется,
+ *       представление действительно только во время выполнения handler'а
+ *
+ * Элементы в кадре не выровнены, поэтому читаются по значению через memcpy
+ *       (operator[], итератор): доступ безопасен и для float/uint32_t на Cortex-M
+ * Span из кадра помнит, что элементы в нем little-endian: на big-endian узле
+ *       они переставляются при чтении, а при повторной отправке копируются как есть
+ *
+ * Пример:
+ *     float set_gains(rpc::Span<float> gains) { for (float g : gains) { ... } }
+ *     client.call<float>("set_gains", rpc::Span<float>(gains, 4));
+ */
+
+template<typename T>
+class Span {
+public:
+    static_assert(std::is_trivially_copyable_v<T>, "Span elements must be trivially copyable");
+
+    // Итератор по значениям элементов
+    class Iterator {
+    public:
+        Iterator(const std::uint8_t* position, bool wire) : m_position(position), m_wire(wire) {}
+        T operator*() const {
+            T value;
+            if (needs_swap<T>() && m_wire) {
+                load_le(m_position, value);                     // Порядок байт кадра
+            } else {
+                std::memcpy(&value, m_position, sizeof(T));
+            }
+            return value;
+        }
+        Iterator& operator++() {
+            m_position += sizeof(T);
+            return *this;
+        }
+        bool operator==(const Iterator& other) const { return m_position == other.m_position; }
+        bool operator!=(const Iterator& other) const { return m_position != other.m_position; }
+
+    private:
+        const std::uint8_t* m_position;     // Первый байт текущего элемента
+        bool m_wire;                        // Элементы в порядке байт кадра
+    };
+
+    Span() = default;
+    Span(const T* data, std::size_t size) : m_bytes(reinterpret_cast<const std::uint8_t*>(data)), m_size(size) {}
+    template<std::size_t N>
+    Span(const T (&array)[N]) : Span(array, N) {}
+    template<std::size_t N>
+    Span(const std::array<T, N>& array) : Span(array.data(), N) {}
+
+    // Представление size элементов, лежащих little-endian с произвольным выравниванием в bytes (в кадре)
+    static Span from_bytes(const std::uint8_t* bytes, std::size_t size) {
+        Span span;
+        span.m_bytes = bytes;
+        span.m_size = size;
+        span.m_wire = true;
+        return span;
+    }
+
+    // Число элементов
+    std::size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    // Элемент с индексом index (по значению)
+    T operator[](std::size_t index) const { return *Iterator(m_bytes + index * sizeof(T), m_wire); }
+
+    // Байтовое представление элементов
+    const std::uint8_t* bytes() const { return m_bytes; }
+    std::size_t size_bytes() const { return m_size * sizeof(T); }
+    // Байты уже в порядке кадра (Span из принятого кадра)
+    bool wire_order() const { return m_wire; }
+
+    Iterator begin() const { return Iterator(m_bytes, m_wire); }
+    Iterator end() const { return Iterator(m_bytes + size_bytes(), m_wire); }
+
+private:
+    const std::uint8_t* m_bytes{nullptr};   // Первый байт первого элемента
+    std::size_t m_size{0};                  // Число элементов
+    bool m_wire{false};                     // Элементы little-endian (из кадра), иначе - в порядке узла
+};
+
+} // namespace rpc
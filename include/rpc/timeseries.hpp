@@ -0,0 +1,251 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include "serializer.hpp"
+#include "signature.hpp"
+#include "../protocol/packet.hpp"
+#include "../utils/noncopyable.hpp"
+
+namespace rpc {
+
+/**
+ * Блочное сжатие временных рядов (Gorilla) для потоков телеметрии
+ *
+ * Выборки (отметка времени в мс, float) кодируются потоком бит:
+ *       первая - как есть (32 + 32 бита), далее отметка времени - разность
+ *       разностей (0 бит для равномерного шага), значение - XOR с предыдущим
+ *       (1 бит для повторов, для медленно меняющихся показаний - значащие
+ *       биты XOR без ведущих и хвостовых нулей)
+ * Блок заполняет одно Stream-сообщение: вместо кадра на каждую выборку
+ *       (~27 байт для одного float) - несколько байт на выборку
+ *
+ * Формат блока в кадре: count | length | bits... (count выборок, length байт)
+ *
+ * Отметка времени:                         Значение:
+ *     0                  - dod = 0             0                 - повтор
+ *     10   + 7 бит       - dod в [-64, 63]     10 + биты         - в окне предыдущего XOR
+ *     110  + 9 бит       - dod в [-256, 255]   11 + 5 + 5 + биты - ведущие нули, длина - 1, биты
+ *     1110 + 12 бит      - dod в [-2048, 2047]
+ *     1111 + 32 бита     - сама разность
+ *
+ * Пример (прошивка): rpc::SampleStream (sample_stream.hpp) заполняет блоки
+ *       и отправляет их; хост принимает их через host::Client::subscribe_series
+ */
+
+// Выборка временного ряда
+struct Sample {
+    std::uint32_t timestamp;            // Отметка времени, мс
+    float value;                        // Значение
+};
+
+/**
+ * Запись потока бит (старшие биты первыми) в буфер фиксированной емкости
+ */
+
+class BitWriter {
+public:
+    BitWriter(std::uint8_t* data, std::size_t capacity) : m_data(data), m_capacity_bits(capacity * 8) {}
+
+    // Запись count младших бит value (count <= 32); false без записи, если буфер заполнен
+    bool write(std::uint32_t value, unsigned count) {
+        if (m_bits + count > m_capacity_bits) {
+            return false;
+        }
+        while (count > 0) {
+            unsigned used = static_cast<unsigned>(m_bits & 7);
+            unsigned take = count < 8 - used ? count : 8 - used;
+            if (used == 0) {
+                m_data[m_bits >> 3] = 0;
+            }
+            std::uint32_t chunk = (value >> (count - take)) & ((1u << take) - 1);
+            m_data[m_bits >> 3] |= static_cast<std::uint8_t>(chunk << (8 - used - take));
+            m_bits += take;
+            count -= take;
+        }
+        return true;
+    }
+
+    // Возврат к позиции bits (отмена последних записей)
+    void rewind(std::size_t bits) {
+        m_bits = bits;
+        if ((m_bits & 7) != 0) {
+            m_data[m_bits >> 3] &= static_cast<std::uint8_t>(0xFF << (8 - (m_bits & 7)));
+        }
+    }
+
+    std::size_t bits() const { return m_bits; }
+    std::size_t bytes() const { return (m_bits + 7) / 8; }
+
+private:
+    std::uint8_t* m_data;               // Буфер
+    std::size_t m_capacity_bits;        // Емкость буфера в битах
+    std::size_t m_bits{0};              // Записано бит
+};
+
+/**
+ * Чтение потока бит с контролем границ: после выхода за буфер все чтения неуспешны
+ */
+
+class BitReader {
+public:
+    BitReader(const std::uint8_t* data, std::size_t length) : m_data(data), m_length_bits(length * 8) {}
+
+    // Чтение count бит (count <= 32) в value; false если буфер короче
+    bool read(unsigned count, std::uint32_t& value) {
+        if (m_bits + count > m_length_bits) {
+            return false;
+        }
+        value = 0;
+        while (count > 0) {
+            unsigned used = static_cast<unsigned>(m_bits & 7);
+            unsigned take = count < 8 - used ? count : 8 - used;
+            std::uint32_t chunk = (m_data[m_bits >> 3] >> (8 - used - take)) & ((1u << take) - 1);
+            value = (value << take) | chunk;
+            m_bits += take;
+            count -= take;
+        }
+        return true;
+    }
+
+    // Число единиц подряд до нуля (не больше limit): префикс кода
+    bool read_prefix(unsigned limit, unsigned& ones) {
+        ones = 0;
+        std::uint32_t bit = 1;
+        while (ones < limit && read(1, bit) && bit == 1) {
+            ++ones;
+        }
+        return ones == limit || bit == 0;
+    }
+
+private:
+    const std::uint8_t* m_data;         // Буфер
+    std::size_t m_length_bits;          // Длина буфера в битах
+    std::size_t m_bits{0};              // Прочитано бит
+};
+
+/**
+ * Сжатый блок выборок - представление буфера кодировщика или принятого кадра
+ * Действителен, пока жив буфер (как std::string_view и rpc::Span)
+ */
+
+class TimeSeriesBlock {
+public:
+    TimeSeriesBlock() = default;
+    TimeSeriesBlock(const std::uint8_t* data, std::size_t length, std::size_t count)
+        : m_data(data), m_length(length), m_count(count) {}
+
+    const std::uint8_t* data() const { return m_data; }
+    std::size_t length() const { return m_length; }
+    std::size_t count() const { return m_count; }
+
+private:
+    const std::uint8_t* m_data{nullptr};    // Поток бит
+    std::size_t m_length{0};                // Длина потока, байт
+    std::size_t m_count{0};                 // Число выборок
+};
+
+/**
+ * Кодировщик блока выборок
+ * append возвращает false, когда выборка не помещается: блок отправляется,
+ *       кодировщик сбрасывается (reset) и выборка добавляется в новый блок
+ */
+
+class TimeSeriesEncoder : private utils::NonCopyable {
+public:
+    // Наибольшая длина потока бит: кадр без заголовка Stream-сообщения и count | length
+    static constexpr std::size_t MaxBytes = protocol::Packet::MaxSize - 3 - SignatureSize - 2;
+    // Наибольшее число выборок в блоке (count - один байт)
+    static constexpr std::size_t MaxSamples = 0xFF;
+
+    // Емкость блока для Stream-сообщения с именем длиной name_length
+    static constexpr std::size_t capacity_for(std::size_t name_length) {
+        return name_length < MaxBytes ? MaxBytes - name_length : 0;
+    }
+
+    explicit TimeSeriesEncoder(std::size_t capacity = MaxBytes)
+        : m_writer(m_data, capacity < MaxBytes ? capacity : MaxBytes) {}
+
+    // Добавление выборки; false если блок заполнен (выборка не добавлена)
+    bool append(std::uint32_t timestamp, float value);
+    // Начало нового блока
+    void reset();
+
+    std::size_t count() const { return m_count; }
+    bool empty() const { return m_count == 0; }
+    // Блок для отправки (указывает в буфер кодировщика до следующего append или reset)
+    TimeSeriesBlock block() const { return TimeSeriesBlock(m_data, m_writer.bytes(), m_count); }
+
+private:
+    // Отметка времени: разность разностей
+    bool write_timestamp(std::uint32_t timestamp);
+    // Значение: XOR с предыдущим
+    bool write_value(std::uint32_t bits);
+
+    std::uint8_t m_data[MaxBytes]{};    // Поток бит блока
+    BitWriter m_writer;                 // Запись в m_data
+    std::size_t m_count{0};             // Выборок в блоке
+    std::uint32_t m_timestamp{0};       // Предыдущая отметка времени
+    std::int32_t m_delta{0};            // Предыдущая разность отметок
+    std::uint32_t m_value{0};           // Биты предыдущего значения
+    unsigned m_leading{32};             // Окно предыдущего XOR: ведущие нули (32 - окна нет)
+    unsigned m_trailing{0};             // Окно предыдущего XOR: хвостовые нули
+};
+
+/**
+ * Декодер блока выборок
+ * next возвращает выборки по порядку; false в конце блока или на
+ *       поврежденном потоке (выход за длину, неверный код)
+ */
+
+class TimeSeriesDecoder {
+public:
+    explicit TimeSeriesDecoder(const TimeSeriesBlock& block)
+        : m_reader(block.data(), block.length()), m_count(block.count()) {}
+
+    bool next(Sample& sample);
+
+private:
+    bool read_timestamp(std::uint32_t& timestamp);
+    bool read_value(std::uint32_t& bits);
+
+    BitReader m_reader;                 // Чтение потока бит
+    std::size_t m_count;                // Выборок в блоке
+    std::size_t m_index{0};             // Прочитано выборок
+    std::uint32_t m_timestamp{0};       // Предыдущая отметка времени
+    std::int32_t m_delta{0};            // Предыдущая разность отметок
+    std::uint32_t m_value{0};           // Биты предыдущего значения
+    unsigned m_leading{32};             // Окно предыдущего XOR: ведущие нули (32 - окна нет)
+    unsigned m_trailing{0};             // Окно предыдущего XOR: хвостовые нули
+};
+
+// Блок в кадре: count | length | bits...; при чтении - представление потока бит в кадре
+template<Encoding E>
+struct Codec<TimeSeriesBlock, E> {
+    static constexpr bool Fixed = false;
+    static constexpr std::size_t MinSize = 2 * sizeof(LengthPrefix);
+    static constexpr bool Plain = false;
+    static constexpr bool View = true;
+
+    static std::size_t size(const TimeSeriesBlock& value) { return MinSize + value.length(); }
+    static std::uint8_t* write(std::uint8_t* out, const TimeSeriesBlock& value) {
+        *out++ = static_cast<LengthPrefix>(value.count());
+        *out++ = static_cast<LengthPrefix>(value.length());
+        std::memcpy(out, value.data(), value.length());
+        return out + value.length();
+    }
+    static bool read(Reader& in, TimeSeriesBlock& value) {
+        const std::uint8_t* header = in.take(MinSize);
+        const std::uint8_t* data = header != nullptr ? in.take(header[1]) : nullptr;
+        if (data != nullptr) {
+            value = TimeSeriesBlock(data, header[1], header[0]);
+        }
+        return data != nullptr;
+    }
+};
+
+template<>
+struct TypeSignature<TimeSeriesBlock> {
+    static constexpr std::uint32_t fold(std::uint32_t hash) { return fnv1a(hash, 'g'); }
+};
+
+} // namespace rpc
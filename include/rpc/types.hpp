@@ -2,6 +2,11 @@
 #include <cstdint>
 #include <string>
 
+// Поддержка Encoding::Compact (0 - только фиксированный формат и меньше кода; переопределяется через build_flags)
+#ifndef RPC_ENABLE_COMPACT
+#define RPC_ENABLE_COMPACT 1
+#endif
+
 namespace rpc {
 
 /**
@@ -15,7 +20,52 @@ enum class MessageType : std::uint8_t {
     Request = 0x0B,     // Запрос на выполнение RPC функции (клиент → сервер)
     Stream = 0x0C,      // Stream-сообщение (одностороннее, без ответа)
     Response = 0x16,    // Ответ на RPC запрос (сервер → клиент)
-    Error = 0x21        // Сообщение об ошибке выполнения
+    Error = 0x21,       // Сообщение об ошибке выполнения
+    BatchRequest = 0x2C,    // Пакет из нескольких запросов в одном кадре (клиент → сервер)
+    BatchResponse = 0x37,   // Сводный ответ на пакетный запрос (сервер → клиент)
+    CachedResponse = 0x42,  // Ответ, который клиент может кэшировать: name\0 | max_age_ms(2) | result (сервер → клиент)
+    Invalidate = 0x4D,      // Значение функции изменилось - кэш клиента по ней недействителен (сервер → клиент)
+    Nack = 0x58,            // Принят кадр с поврежденными данными: Nack | seq | type - повторить из истории передачи
+    Hello = 0x63            // Согласование возможностей канала: Hello | seq | features | reply (обрабатывает Parser)
+};
+
+// Старший бит байта типа: аргументы и результат сообщения закодированы в Encoding::Compact
+constexpr std::uint8_t CompactFlag = 0x80;
+
+// Возможности канала в сообщении Hello (битовая маска)
+enum class LinkFeature : std::uint8_t {
+    Compression = 0x01      // Прием кадров, сжатых LZSS (Packet::CompressedFlag)
+};
+
+// Кодирование целых чисел в полезных данных сообщения
+enum class Encoding : std::uint8_t {
+    Fixed,      // Фиксированный размер: int32_t всегда 4 байта
+    Compact     // LEB128 varint, знаковые - zigzag: малые по модулю значения занимают 1-2 байта
+};
+
+// Encoding::Compact поддерживается сборкой
+constexpr bool CompactEnabled = RPC_ENABLE_COMPACT != 0;
+
+// Причина ошибки в сообщении Error | seq | reason (и в статусе вызова пакета)
+enum class ErrorCode : std::uint8_t {
+    Unknown = 0x00,             // Причина не передана
+    UnknownFunction = 0x01,     // Handler с таким именем не зарегистрирован
+    BadArguments = 0x02,        // Длина аргументов не совпадает с сигнатурой handler'а
+    ResultTooLarge = 0x03,      // Результат не помещается в кадр
+    Busy = 0x04,                // Нет свободного слота отложенного вызова
+    Rejected = 0x05,            // Handler отказался выполнять вызов
+    SignatureMismatch = 0x06    // Отпечаток типов запроса не совпадает с сигнатурой handler'а
+};
+
+// max_age_ms в CachedResponse: результат действителен до сообщения Invalidate
+constexpr std::uint16_t UntilInvalidated = 0xFFFF;
+
+// Состояние RPC вызова, ожидающего ответа
+enum class CallStatus : std::uint8_t {
+    Pending,    // Запрос отправлен, ответ еще не получен
+    Ok,         // Получен успешный ответ
+    Error,      // Получено сообщение об ошибке или запрос не отправлен
+    Timeout     // Ответ не получен за отведенное время
 };
 
 // Структура RPC сообщения для внутренней обработки. Распарсенное представление сообщения
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "noncopyable.hpp"
+
+namespace utils {
+
+/**
+ * Пул слотов фиксированного размера для передачи данных между задачами
+ * T Тип слота
+ * Size Число слотов (не больше 255 - индекс передается одним байтом)
+ *
+ * Вместо копирования целых объектов через очередь FreeRTOS производитель
+ *       заполняет слот на месте, а в очередь кладет только его индекс;
+ *       потребитель обрабатывает слот по индексу и возвращает его в пул
+ * Список свободных слотов - тоже очередь индексов, поэтому acquire/release
+ *       безопасны из разных задач, а варианты _from_isr - из прерываний
+ */
+
+template<typename T, std::size_t Size>
+class SlotPool : private NonCopyable {
+    static_assert(Size > 0 && Size < 0xFF, "SlotPool index must fit into one byte");
+
+public:
+    // Значение индекса, означающее отсутствие свободного слота
+    static constexpr std::uint8_t None = 0xFF;
+
+    SlotPool() : m_free(xQueueCreate(Size, sizeof(std::uint8_t))) {
+        for (std::uint8_t i = 0; i < Size; ++i) {
+            xQueueSend(m_free, &i, 0);
+        }
+    }
+
+    // Занятие свободного слота; None если свободных нет за время timeout
+    std::uint8_t acquire(TickType_t timeout = 0) {
+        std::uint8_t index = None;
+        return xQueueReceive(m_free, &index, timeout) == pdPASS ? index : None;
+    }
+
+    // Занятие свободного слота из прерывания
+    std::uint8_t acquire_from_isr(BaseType_t* higher_priority_task_woken) {
+        std::uint8_t index = None;
+        return xQueueReceiveFromISR(m_free, &index, higher_priority_task_woken) == pdPASS ? index : None;
+    }
+
+    // Возврат слота в пул
+    void release(std::uint8_t index) {
+        xQueueSend(m_free, &index, 0);
+    }
+
+    // Возврат слота в пул из прерывания
+    void release_from_isr(std::uint8_t index, BaseType_t* higher_priority_task_woken) {
+        xQueueSendFromISR(m_free, &index, higher_priority_task_woken);
+    }
+
+    // Доступ к слоту по индексу
+    T& operator[](std::uint8_t index) { return m_slots[index]; }
+    const T& operator[](std::uint8_t index) const { return m_slots[index]; }
+
+private:
+    QueueHandle_t m_free;   // Очередь индексов свободных слотов
+    T m_slots[Size];        // Слоты
+};
+
+} // namespace utils
@@ -18,7 +18,11 @@
 #define configIDLE_SHOULD_YIELD                 1
 #define configUSE_MUTEXES                       1
 #define configQUEUE_REGISTRY_SIZE               8
+#ifdef __PLATFORMIO_BUILD_DEBUG__                   /* Отладочная сборка: проверка стека при переключении задач */
+#define configCHECK_FOR_STACK_OVERFLOW          2
+#else
 #define configCHECK_FOR_STACK_OVERFLOW          0
+#endif
 #define configUSE_RECURSIVE_MUTEXES             1
 #define configUSE_MALLOC_FAILED_HOOK            0
 #define configUSE_APPLICATION_TASK_TAG          0
@@ -0,0 +1,322 @@
+"""
+Генератор заглушек RPC по описанию интерфейса (IDL)
+
+Из файла idl/<name>.rpc создаются заголовки:
+    <name>_idl.hpp   - описания функций: MethodId, структура аргументов,
+                       тип результата, отпечаток сигнатуры и размеры кадров
+    <name>_stubs.hpp - прошивка: прокси над rpc::Client и регистрация
+                       реализации в rpc::Service (bind<Impl>)
+    <name>_host.hpp  - хост: прокси над host::Client (корутины)
+
+Формат IDL (одна функция в строке, // - комментарий):
+    service Device {
+        1: add(int32 a, int32 b) -> int32;
+        2: get_temperature() -> float [cached=500];
+        3: set_led(bool on);
+    }
+Типы: bool, int8..int64, uint8..uint64, float, double, string
+Атрибуты: cached=мс, pure, client_cached=мс (rpc::HandlerOptions)
+
+Запуск:
+    python3 scripts/rpc_idl.py idl/device.rpc -o <каталог>
+    PlatformIO: extra_scripts = pre:scripts/rpc_idl.py - все idl/*.rpc
+        генерируются в $BUILD_DIR/idl, каталог добавляется в пути включения
+"""
+
+import argparse
+import os
+import re
+import sys
+
+# Тип IDL: (аргумент, результат)
+TYPES = {
+    "bool": ("bool", "bool"),
+    "int8": ("std::int8_t", "std::int8_t"),
+    "int16": ("std::int16_t", "std::int16_t"),
+    "int32": ("std::int32_t", "std::int32_t"),
+    "int64": ("std::int64_t", "std::int64_t"),
+    "uint8": ("std::uint8_t", "std::uint8_t"),
+    "uint16": ("std::uint16_t", "std::uint16_t"),
+    "uint32": ("std::uint32_t", "std::uint32_t"),
+    "uint64": ("std::uint64_t", "std::uint64_t"),
+    "float": ("float", "float"),
+    "double": ("double", "double"),
+    "string": ("std::string_view", "std::string"),   # Результат не может указывать в кадр
+}
+
+ATTRIBUTES = {"cached", "pure", "client_cached"}
+
+IDENT = r"[A-Za-z_][A-Za-z0-9_]*"
+SERVICE_RE = re.compile(r"^service\s+(" + IDENT + r")\s*\{$")
+METHOD_RE = re.compile(r"^(\d+)\s*:\s*(" + IDENT + r")\s*\(([^)]*)\)\s*(?:->\s*(" + IDENT + r"))?"
+                       r"\s*(?:\[([^\]]*)\])?\s*;$")
+PARAM_RE = re.compile(r"^(" + IDENT + r")\s+(" + IDENT + r")$")
+
+HEADER = "// Сгенерировано scripts/rpc_idl.py из {source} - не редактировать\n#pragma once\n"
+
+
+class IdlError(Exception):
+    pass
+
+
+class Method:
+    def __init__(self, ident, name, params, result, attributes):
+        self.id = ident
+        self.name = name
+        self.params = params            # [(тип IDL, имя)]
+        self.result = result            # Тип IDL или None
+        self.attributes = attributes    # {имя: значение или None}
+
+    @property
+    def struct(self):
+        return "".join(part.capitalize() for part in self.name.split("_") if part)
+
+    def arg_types(self):
+        return [TYPES[kind][0] for kind, _ in self.params]
+
+    def result_type(self):
+        return TYPES[self.result][1] if self.result else "void"
+
+    def param_list(self):
+        return ", ".join("{} {}".format(TYPES[kind][0], name) for kind, name in self.params)
+
+    def arg_names(self):
+        return ", ".join(name for _, name in self.params)
+
+
+class Service:
+    def __init__(self, name):
+        self.name = name
+        self.methods = []
+
+    @property
+    def namespace(self):
+        return re.sub(r"(?<!^)(?=[A-Z])", "_", self.name).lower()
+
+
+def parse(text, path):
+    services = []
+    current = None
+    for number, raw in enumerate(text.splitlines(), 1):
+        line = raw.split("//", 1)[0].strip()
+        if not line:
+            continue
+        where = "{}:{}: ".format(path, number)
+        if current is None:
+            match = SERVICE_RE.match(line)
+            if not match:
+                raise IdlError(where + "expected 'service Name {'")
+            current = Service(match.group(1))
+            continue
+        if line == "}":
+            services.append(current)
+            current = None
+            continue
+        match = METHOD_RE.match(line)
+        if not match:
+            raise IdlError(where + "expected 'id: name(type arg, ...) [-> type] [attributes];'")
+        ident, name, params, result, attributes = match.groups()
+        method = Method(int(ident), name, parse_params(params, where), result, parse_attributes(attributes, where))
+        if not 1 <= method.id <= 0xFFFF:
+            raise IdlError(where + "method id must be in 1..65535")
+        if result is not None and result not in TYPES:
+            raise IdlError(where + "unknown type '{}'".format(result))
+        for other in current.methods:
+            if other.id == method.id or other.name == method.name or other.struct == method.struct:
+                raise IdlError(where + "'{}' clashes with '{}' (id {})".format(name, other.name, other.id))
+        current.methods.append(method)
+    if current is not None:
+        raise IdlError("{}: service {} is not closed".format(path, current.name))
+    if not services:
+        raise IdlError("{}: no services".format(path))
+    return services
+
+
+def parse_params(text, where):
+    params = []
+    for item in filter(None, (part.strip() for part in text.split(","))):
+        match = PARAM_RE.match(item)
+        if not match or match.group(1) not in TYPES:
+            raise IdlError(where + "bad parameter '{}'".format(item))
+        if match.group(2) in (name for _, name in params):
+            raise IdlError(where + "duplicate parameter '{}'".format(match.group(2)))
+        params.append(match.groups())
+    return params
+
+
+def parse_attributes(text, where):
+    attributes = {}
+    for item in filter(None, (part.strip() for part in (text or "").split(","))):
+        key, _, value = (part.strip() for part in item.partition("="))
+        if key not in ATTRIBUTES or (key == "pure") != (value == ""):
+            raise IdlError(where + "bad attribute '{}'".format(item))
+        if value and not value.isdigit():
+            raise IdlError(where + "attribute '{}' expects milliseconds".format(key))
+        attributes[key] = int(value) if value else None
+    if len(attributes) > 1:
+        raise IdlError(where + "cached, pure and client_cached are mutually exclusive")
+    return attributes
+
+
+def handler_options(method):
+    if "cached" in method.attributes:
+        return "rpc::HandlerOptions::cached(pdMS_TO_TICKS({}))".format(method.attributes["cached"])
+    if "pure" in method.attributes:
+        return "rpc::HandlerOptions::pure()"
+    if "client_cached" in method.attributes:
+        return "rpc::HandlerOptions::client_cached({})".format(method.attributes["client_cached"])
+    return None
+
+
+def describe(method):
+    params = ", ".join("{} {}".format(kind, name) for kind, name in method.params)
+    result = " -> " + method.result if method.result else ""
+    attributes = ", ".join(key + ("=" + str(value) if value is not None else "")
+                           for key, value in method.attributes.items())
+    return "{}: {}({}){}{}".format(method.id, method.name, params, result, " [" + attributes + "]" if attributes else "")
+
+
+def emit_idl(services, source):
+    out = [HEADER.format(source=source)]
+    out.append("#include <cstddef>\n#include <cstdint>\n#include <string>\n#include <string_view>\n")
+    out.append('#include "protocol/packet.hpp"\n#include "rpc/method.hpp"\n#include "rpc/serializer.hpp"\n'
+               '#include "rpc/signature.hpp"\n')
+    for service in services:
+        out.append("\nnamespace {} {{\n".format(service.namespace))
+        for method in service.methods:
+            types = ", ".join(method.arg_types())
+            signature_types = ", ".join(["Result"] + method.arg_types())
+            fields = "".join("        {} {};\n".format(TYPES[kind][0], name) for kind, name in method.params)
+            out.append("\n// {}\n".format(describe(method)))
+            out.append("struct {} {{\n".format(method.struct))
+            out.append('    static constexpr rpc::MethodId id{{{}, "{}"}};\n'.format(method.id, method.name))
+            out.append("    // Аргументы в порядке передачи\n")
+            out.append("    struct Args {{\n{}    }};\n".format(fields) if fields else "    struct Args {};\n")
+            out.append("    using Result = {};\n".format(method.result_type()))
+            out.append("    static constexpr std::uint16_t signature = rpc::signature_of<{}>();\n".format(signature_types))
+            out.append("    // Размеры в Encoding::Fixed: точные, если Fixed, иначе наименьшие (строки)\n")
+            out.append("    static constexpr bool Fixed = rpc::Serializer::is_fixed<{}>();\n".format(types))
+            out.append("    static constexpr std::size_t ArgsSize = rpc::Serializer::min_size<{}>();\n".format(types))
+            out.append("    static constexpr std::size_t RequestSize = 2 + rpc::Target::IdSize + rpc::SignatureSize + ArgsSize;\n")
+            result_size = "rpc::Serializer::min_size<Result>()" if method.result else "0"
+            out.append("    static constexpr std::size_t ResponseSize = 3 + {};\n".format(result_size))
+            out.append("};\n")
+            if method.params:
+                out.append("static_assert(rpc::Serializer::min_size<{0}::Args>() == {0}::ArgsSize, "
+                           '"{1}: Args differs from the wire layout");\n'.format(method.struct, method.name))
+            out.append("static_assert({0}::RequestSize <= protocol::Packet::MaxSize && {0}::ResponseSize <= protocol::Packet::MaxSize,\n"
+                       '              "{1}: message does not fit a frame");\n'.format(method.struct, method.name))
+        out.append("\n}} // namespace {}\n".format(service.namespace))
+    return "".join(out)
+
+
+def emit_proxy(service, class_name, client, wrap):
+    out = ["class {} {{\npublic:\n".format(class_name)]
+    out.append("    explicit {}({}& client) : m_client(client) {{}}\n".format(class_name, client))
+    for method in service.methods:
+        result = wrap(method.result_type())
+        call = "m_client.call<{0}::Result>({0}::id{1})".format(
+            method.struct, "".join(", " + name for _, name in method.params))
+        out.append("\n    // {}\n".format(describe(method)))
+        out.append("    {} {}({}) {{ return {}; }}\n".format(result, method.name, method.param_list(), call))
+        if method.params:
+            args = ", ".join("args." + name for _, name in method.params)
+            out.append("    {} {}(const {}::Args& args) {{ return {}({}); }}\n".format(
+                result, method.name, method.struct, method.name, args))
+    out.append("\nprivate:\n    {}& m_client;\n}};\n".format(client))
+    return "".join(out)
+
+
+def emit_stubs(services, source, idl_header):
+    out = [HEADER.format(source=source)]
+    out.append('#include "{}"\n#include "rpc/client.hpp"\n#include "rpc/service.hpp"\n'.format(idl_header))
+    for service in services:
+        out.append("\nnamespace {} {{\n\n".format(service.namespace))
+        out.append("/**\n * Вызовы функций {} через rpc::Client по идентификатору\n"
+                   " * Ошибка или таймаут - значение результата по умолчанию, как у Client::call\n */\n\n".format(service.name))
+        out.append(emit_proxy(service, "Proxy", "rpc::Client", lambda result: result))
+        out.append("\n/**\n * Регистрация реализации {} в сервисе по имени и идентификатору\n".format(service.name))
+        out.append(" * Impl - класс со статическими функциями:\n")
+        for method in service.methods:
+            out.append(" *     static {} {}({});\n".format(method.result_type(), method.name, method.param_list()))
+        out.append(" * false, если какая-то функция не зарегистрирована\n */\n\n")
+        out.append("template<typename Impl>\nbool bind(rpc::Service& service) {\n    bool bound = true;\n")
+        for method in service.methods:
+            thunk = "+[]({}) -> {}::Result {{ return Impl::{}({}); }}".format(
+                method.param_list(), method.struct, method.name, method.arg_names())
+            options = handler_options(method)
+            out.append("    bound = service.register_handler({}::id, {}{}) && bound;\n".format(
+                method.struct, thunk, ", " + options if options else ""))
+        out.append("    return bound;\n}\n")
+        out.append("\n}} // namespace {}\n".format(service.namespace))
+    return "".join(out)
+
+
+def emit_host(services, source, idl_header):
+    out = [HEADER.format(source=source)]
+    out.append('#include "{}"\n#include "host/client.hpp"\n#include "host/task.hpp"\n'.format(idl_header))
+    for service in services:
+        out.append("\nnamespace {} {{\n\n".format(service.namespace))
+        out.append("// Вызовы функций {} через host::Client по идентификатору\n".format(service.name))
+        out.append(emit_proxy(service, "HostProxy", "host::Client",
+                              lambda result: "host::Task<host::Reply<{}>>".format(result)))
+        out.append("\n}} // namespace {}\n".format(service.namespace))
+    return "".join(out)
+
+
+def write_if_changed(path, text):
+    # Неизмененный заголовок не перезаписывается - не пересобираются зависимые файлы
+    if os.path.exists(path):
+        with open(path, encoding="utf-8") as existing:
+            if existing.read() == text:
+                return
+    with open(path, "w", encoding="utf-8") as output:
+        output.write(text)
+
+
+def generate(source, output_dir, display=None):
+    if display is None:                 # idl/<name>.rpc - без путей каталога сборки
+        display = "/".join([os.path.basename(os.path.dirname(os.path.abspath(source))), os.path.basename(source)])
+    with open(source, encoding="utf-8") as idl:
+        services = parse(idl.read(), display)
+    stem = os.path.splitext(os.path.basename(source))[0]
+    idl_header = stem + "_idl.hpp"
+    os.makedirs(output_dir, exist_ok=True)
+    write_if_changed(os.path.join(output_dir, idl_header), emit_idl(services, display))
+    write_if_changed(os.path.join(output_dir, stem + "_stubs.hpp"), emit_stubs(services, display, idl_header))
+    write_if_changed(os.path.join(output_dir, stem + "_host.hpp"), emit_host(services, display, idl_header))
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description="Generate RPC stubs from an IDL file")
+    parser.add_argument("sources", nargs="+", help="IDL files (*.rpc)")
+    parser.add_argument("-o", "--output", required=True, help="output directory")
+    options = parser.parse_args(argv)
+    try:
+        for source in options.sources:
+            generate(source, options.output)
+    except (IdlError, OSError) as error:
+        print("rpc_idl: {}".format(error), file=sys.stderr)
+        return 1
+    return 0
+
+
+def pio_generate(env):
+    project_dir = env.subst("$PROJECT_DIR")
+    idl_dir = os.path.join(project_dir, "idl")
+    output_dir = os.path.join(env.subst("$BUILD_DIR"), "idl")
+    sources = sorted(name for name in os.listdir(idl_dir) if name.endswith(".rpc")) if os.path.isdir(idl_dir) else []
+    try:
+        for name in sources:
+            generate(os.path.join(idl_dir, name), output_dir, display="idl/" + name)
+    except IdlError as error:
+        sys.stderr.write("rpc_idl: {}\n".format(error))
+        env.Exit(1)
+    env.Append(CPPPATH=[output_dir])
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
+else:
+    Import("env")   # noqa: F821 - PlatformIO (SCons) extra_scripts
+    pio_generate(env)   # noqa: F821
@@ -7,26 +7,39 @@ namespace drivers {
 Uart* Uart::global_uart_instance = nullptr; // Инициализация статического указателя на глобальный экземпляр UART
 
 // Конструктор UART драйвера
-Uart::Uart(UART_HandleTypeDef* huart) : m_huart(huart), m_rx_queue(nullptr), m_rx_callback(nullptr), m_rx_user_data(nullptr), m_rx_byte(0) {}
+Uart::Uart(UART_HandleTypeDef* huart) : m_huart(huart), m_rx_queue(nullptr), m_tx_mutex(xSemaphoreCreateMutex()), m_rx_callback(nullptr), m_rx_user_data(nullptr), m_rx_byte(0) {}
 
-void Uart::start() {                                                                                    // Запуск UART драйвера
+void Uart::start(std::uint16_t stack_depth) {                                                                                    // Запуск UART драйвера
+    global_uart_instance = this;                                                                        // Экземпляр для HAL_UART_RxCpltCallback
     m_rx_queue = xQueueCreate(64, sizeof(std::uint8_t));                                                // Создание очереди для передачи данных из прерывания в задачу
     HAL_UART_Receive_IT(m_huart, &m_rx_byte, 1);                                                        // Запуск приема данных в прерывании (один байт)
-    xTaskCreate(rx_task, "UartRx", configMINIMAL_STACK_SIZE, this, tskIDLE_PRIORITY + 1, nullptr);      // Создание задачи для обработки принятых данных
+    xTaskCreate(rx_task, "UartRx", stack_depth, this, tskIDLE_PRIORITY + 1, nullptr);                   // Создание задачи для обработки принятых данных
 }
 
 // Установка callback функции для обработки принятых данных
-void Uart::set_rx_callback(void (*callback)(std::uint8_t, void*), void* user_data) {
+void Uart::set_rx_callback(RxCallback callback, void* user_data) {
     m_rx_callback = callback;
     m_rx_user_data = user_data;
 }
 
 // Отправка данных через UART
 bool Uart::send(const std::uint8_t* data, std::size_t length, TickType_t timeout) {
-    if (HAL_UART_Transmit(m_huart, const_cast<std::uint8_t*>(data), length, timeout) == HAL_OK) {
-        return true;
+    if (xSemaphoreTake(m_tx_mutex, timeout) != pdPASS) {                                               // Ожидание окончания передачи другой задачи
+        return false;
     }
-    return false;
+    bool sent = HAL_UART_Transmit(m_huart, const_cast<std::uint8_t*>(data), length, timeout) == HAL_OK;
+    xSemaphoreGive(m_tx_mutex);
+    return sent;
+}
+
+// Передача начинается, только если канал свободен; короткий служебный кадр передается за единицы миллисекунд
+bool Uart::try_write(const std::uint8_t* data, std::size_t length) {
+    if (xSemaphoreTake(m_tx_mutex, 0) != pdPASS) {                                                     // Канал занят другой задачей - без ожидания
+        return false;
+    }
+    bool sent = HAL_UART_Transmit(m_huart, const_cast<std::uint8_t*>(data), length, WriteTimeout) == HAL_OK;
+    xSemaphoreGive(m_tx_mutex);
+    return sent;
 }
 
 // Задача FreeRTOS для обработки принятых данных
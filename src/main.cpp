@@ -1,30 +1,30 @@
 #include "main.h"
-#include "rpc/client.hpp"
-#include "rpc/service.hpp"
+#include "rpc/endpoint.hpp"
+#include "device_stubs.hpp"     // Генерируется из idl/device.rpc (scripts/rpc_idl.py)
 #include "drivers/uart.hpp"
-#include "protocol/parser.hpp"
-#include "protocol/sender.hpp"
 #include <string>
 
 // Глобальный обработчик UART (инициализируется CubeMX)
 UART_HandleTypeDef huart2;
 
+// Стек задач, отправляющих кадры (Sender::send сжимает кадр на стеке), в словах
+constexpr uint16_t sending_stack(uint16_t words) {
+    return static_cast<uint16_t>(words + protocol::Sender::SendStackBytes / sizeof(StackType_t));
+}
+
 // Прототипы функций инициализации (генерируются CubeMX)
 void SystemClock_Config(void);
 void MX_GPIO_Init(void);
 void MX_USART2_UART_Init(void);
 
-int32_t add(int32_t a, int32_t b) { return a + b; }     // RPC функция сложения двух чисел
-float get_temperature() { return 25.5f; }               // RPC функция получения температуры (заглушка)
-void set_led(bool state) {                              // RPC функция управления светодиодом (true - вкл, false - выкл)
-    HAL_GPIO_WritePin(GPIOA, GPIO_PIN_5, state ? GPIO_PIN_SET : GPIO_PIN_RESET); 
-}
-
-// Обработчик входящих пакетов для парсера
-void packet_handler(const protocol::Packet& packet, void* user_data) {
-    auto* service = static_cast<rpc::Service*>(user_data);
-    service->handle_packet(packet);
-}
+// Реализация функций из idl/device.rpc
+struct Device {
+    static int32_t add(int32_t a, int32_t b) { return a + b; }     // RPC функция сложения двух чисел
+    static float get_temperature() { return 25.5f; }               // RPC функция получения температуры (заглушка)
+    static void set_led(bool state) {                              // RPC функция управления светодиодом (true - вкл, false - выкл)
+        HAL_GPIO_WritePin(GPIOA, GPIO_PIN_5, state ? GPIO_PIN_SET : GPIO_PIN_RESET);
+    }
+};
 
 /**
  * Основная функция приложения
@@ -45,25 +45,29 @@ extern "C" int main(void) {
     MX_GPIO_Init();             // Настройка GPIO (светодиоды, кнопки)
     MX_USART2_UART_Init();      // Настройка UART2 для коммуникации
 
-    // 4. Создание объектов системы
-    drivers::Uart uart(&huart2);                            // Драйвер UART
-    protocol::Parser parser(uart, packet_handler, nullptr); // Парсер протокола. Передаём UART, handler и user_data
-    rpc::Client client(uart, parser);                       // RPC клиент (для отправки запросов)
-    rpc::Service service(parser);                           // RPC сервис (для обработки запросов)
+    // 4. Создание объектов системы (static - стек main переиспользуется прерываниями после запуска планировщика)
+    static drivers::Uart uart(&huart2);                     // Драйвер UART
+    static rpc::Endpoint endpoint(uart);                    // Парсер, RPC сервис и клиент на одном канале
+    rpc::Service& service = endpoint.service();
 
     // 5. Регистрация RPC обработчиков функций
-    service.register_handler("add", &add);                          // Функция сложения
-    service.register_handler("get_temperature", &get_temperature);  // Получение температуры
-    service.register_handler("set_led", &set_led);                  // Управление светодиодом
+    // add, get_temperature (меняется медленно - кэш на 500ms), set_led - по имени и идентификатору из IDL
+    device::bind<Device>(service);
 
     // 6. Создание задачи для обработки RPC сервиса
     xTaskCreate([](void* param) {
         auto* s = static_cast<rpc::Service*>(param);
         while (true) {
-            s->process();   // Обработка фоновых задач сервиса
-            vTaskDelay(1);  // Задержка 10ms
+            s->process();   // Блокируется до прихода запроса, затем обрабатывает все накопившиеся
         }
-    }, "Service", 256, &service, 1, nullptr);
+    }, "Service", sending_stack(256), &service, 1, nullptr);       // Запас стека на сжатие ответов (Sender::send)
+    xTaskCreate([](void* param) {
+        auto* c = static_cast<rpc::Client*>(param);
+        while (true) {
+            c->process_resends();   // Повторы запросов клиента по таймауту (таймер только ставит их в очередь)
+        }
+    }, "RpcResend", sending_stack(configMINIMAL_STACK_SIZE), &endpoint.client(), 1, nullptr);
+    uart.start();               // Прием байтов в задаче UartRx → Endpoint → Service/Client (кадры не отправляет, кроме коротких Nack и Hello)
 
     // 7. Запуск планировщика FreeRTOS (не возвращает управление)
     vTaskStartScheduler();
@@ -166,6 +170,20 @@ void Error_Handler(void) {
     while (1) {}
 }
 
+#if configCHECK_FOR_STACK_OVERFLOW
+/**
+ * Переполнение стека задачи (отладочная сборка, configCHECK_FOR_STACK_OVERFLOW)
+ * Останавливает систему: имя задачи видно в отладчике
+ */
+
+extern "C" void vApplicationStackOverflowHook(TaskHandle_t task, char* task_name) {
+    (void)task;
+    (void)task_name;
+    taskDISABLE_INTERRUPTS();
+    while (1) {}
+}
+#endif
+
 /**
  * Callback системного таймера (SysTick)
  * 
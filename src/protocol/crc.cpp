@@ -18,18 +18,20 @@ namespace protocol {
  */
 
 bool Crc::validate(const Packet& packet) {
-    std::uint8_t header[4] = {0xFA,                                                             // Стартовый байт
-        static_cast<std::uint8_t>(packet.length & 0xFF),                                        // Младший байт длины
-        static_cast<std::uint8_t>(packet.length >> 8),                                          // Старший байт длины
-        0xFB};                                                                                  // Фиктивный байт
-    std::uint8_t header_crc = calculate(header, 3);                                             // Расчет CRC заголовка (только первые 3 байта)
-    if (header_crc != packet.header_crc) {                                                      // Проверка CRC заголовка
+    if (!validate_header(packet)) {                                                             // Проверка CRC заголовка
         return false;                                                                           // Ошибка CRC заголовка
     }
     std::uint8_t calculated_crc = calculate(packet.data, packet.data_length);                   // Расчет CRC полезных данных
     return calculated_crc == packet.crc;                                                        // Проверка CRC данных
 }
 
+bool Crc::validate_header(const Packet& packet) {
+    std::uint8_t header[3] = {0xFA,                                                             // Стартовый байт
+        static_cast<std::uint8_t>(packet.length & 0xFF),                                        // Младший байт длины
+        static_cast<std::uint8_t>(packet.length >> 8)};                                         // Старший байт длины
+    return calculate(header, 3) == packet.header_crc;                                           // Расчет CRC заголовка
+}
+
 std::uint8_t Crc::calculate(const std::uint8_t* data, std::size_t length, std::uint8_t crc) {   // Вычисление CRC-8 для данных
     constexpr std::uint8_t poly = 0x07;                                                         // CRC-8-CCITT polynomial: x^8 + x^2 + x^1 + 1
     for (std::size_t i = 0; i < length; ++i) {
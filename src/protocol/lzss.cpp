@@ -0,0 +1,182 @@
+#include "../../include/protocol/lzss.hpp"
+#include "../../include/protocol/packet.hpp"
+
+namespace protocol {
+
+static_assert(Packet::MaxSize < Lzss::Window, "LZSS offset does not cover a frame");
+
+namespace {
+
+constexpr unsigned MaxChain = 16;                                       // Кандидатов повтора на позицию, не больше
+
+// Хэш двух байт: начало цепочки позиций с тем же началом
+inline std::uint8_t hash(const std::uint8_t* data) {
+    return static_cast<std::uint8_t>((data[0] << 3) ^ (data[0] >> 5) ^ data[1]);
+}
+
+// Запись потока бит (старшие первыми) в буфер ограниченной емкости
+class BitSink {
+public:
+    BitSink(std::uint8_t* out, std::size_t capacity) : m_out(out), m_capacity(capacity) {}
+
+    // Запись count младших бит value; false если буфер заполнен
+    bool put(std::uint32_t value, unsigned count) {
+        m_bits = (m_bits << count) | value;
+        m_count += count;
+        while (m_count >= 8) {
+            if (m_length == m_capacity) {
+                return false;
+            }
+            m_count -= 8;
+            m_out[m_length++] = static_cast<std::uint8_t>(m_bits >> m_count);
+        }
+        m_bits &= (1u << m_count) - 1;
+        return true;
+    }
+
+    // Дописывание неполного байта нулями; длина данных или 0 при переполнении
+    std::size_t finish() {
+        if (m_count > 0) {
+            if (m_length == m_capacity) {
+                return 0;
+            }
+            m_out[m_length++] = static_cast<std::uint8_t>(m_bits << (8 - m_count));
+            m_count = 0;
+        }
+        return m_length;
+    }
+
+private:
+    std::uint8_t* m_out;                // Выходной буфер
+    std::size_t m_capacity;             // Емкость буфера
+    std::size_t m_length{0};            // Записано полных байт
+    std::uint32_t m_bits{0};            // Биты неполного байта (младшие m_count)
+    unsigned m_count{0};                // Число бит неполного байта
+};
+
+} // namespace
+
+/**
+ * Сжатие кадра
+ * in, length Полезные данные кадра (length <= Packet::MaxSize)
+ * out, capacity Буфер сжатых данных
+ * Длина сжатых данных или 0, если они не помещаются в capacity
+ *
+ * Жадный разбор: на каждой позиции - самый длинный повтор среди последних
+ *       MaxChain позиций с тем же хэшем двух байт (цепочки храним как
+ *       позиция + 1, 0 - конец цепочки); без повтора - литерал
+ * Время - O(length * MaxChain), без выделения памяти
+ */
+
+std::size_t Lzss::compress(const std::uint8_t* in, std::size_t length, std::uint8_t* out, std::size_t capacity) {
+    if (length > Packet::MaxSize) {
+        return 0;
+    }
+    std::uint8_t head[HashSize] = {};                                   // Последняя позиция + 1 для каждого хэша
+    std::uint8_t chain[Packet::MaxSize];                                // Предыдущая позиция + 1 с тем же хэшем
+    BitSink sink(out, capacity);
+
+    auto insert = [&](std::size_t position) {
+        if (position + MinMatch <= length) {
+            std::uint8_t key = hash(in + position);
+            chain[position] = head[key];
+            head[key] = static_cast<std::uint8_t>(position + 1);
+        }
+    };
+
+    std::size_t position = 0;
+    while (position < length) {
+        std::size_t best_length = 0;
+        std::size_t best_offset = 0;
+        if (position + MinMatch <= length) {
+            std::size_t limit = length - position < MaxMatch ? length - position : MaxMatch;
+            unsigned depth = 0;
+            for (std::size_t candidate = head[hash(in + position)]; candidate != 0 && depth < MaxChain;
+                 candidate = chain[candidate - 1], ++depth) {
+                const std::uint8_t* match = in + candidate - 1;
+                std::size_t matched = 0;
+                while (matched < limit && match[matched] == in[position + matched]) {  // Повтор может перекрывать текущую позицию
+                    ++matched;
+                }
+                if (matched > best_length) {
+                    best_length = matched;
+                    best_offset = in + position - match;
+                    if (matched == limit) {
+                        break;
+                    }
+                }
+            }
+        }
+        bool written;
+        if (best_length >= MinMatch) {
+            written = sink.put(static_cast<std::uint32_t>(best_offset - 1), 1 + OffsetBits)
+                      && sink.put(static_cast<std::uint32_t>(best_length - MinMatch), LengthBits);
+        } else {
+            written = sink.put(0x100u | in[position], 9);                          // Флаг литерала и байт
+            best_length = 1;
+        }
+        if (!written) {
+            return 0;                                                           // Сжатие не выгодно
+        }
+        for (std::size_t i = 0; i < best_length; ++i) {
+            insert(position + i);
+        }
+        position += best_length;
+    }
+    return sink.finish();
+}
+
+void LzssDecoder::reset(std::uint8_t* out, std::size_t capacity) {
+    m_out = out;
+    m_capacity = capacity;
+    m_length = 0;
+    m_bits = 0;
+    m_count = 0;
+    m_failed = false;
+}
+
+/**
+ * Распаковка очередного байта
+ * Разбирает все лексемы, которые завершил этот байт; литерал - 9 бит,
+ *       повтор - 13 бит, поэтому накоплено не больше 20 бит
+ * Повтор копируется побайтно: при смещении меньше длины он перекрывает
+ *       сам себя (серии одинаковых байт)
+ */
+
+bool LzssDecoder::feed(std::uint8_t byte) {
+    if (m_failed) {
+        return false;
+    }
+    m_bits = (m_bits << 8) | byte;
+    m_count += 8;
+    while (m_count > 0) {
+        bool literal = ((m_bits >> (m_count - 1)) & 1) != 0;
+        unsigned size = literal ? 9 : 1 + Lzss::OffsetBits + Lzss::LengthBits;
+        if (m_count < size) {
+            break;                                                              // Лексема продолжится в следующем байте
+        }
+        m_count -= size;
+        std::uint32_t token = (m_bits >> m_count) & ((1u << (size - 1)) - 1);
+        if (literal) {
+            if (m_length == m_capacity) {
+                m_failed = true;
+                return false;
+            }
+            m_out[m_length++] = static_cast<std::uint8_t>(token);
+        } else {
+            std::size_t offset = (token >> Lzss::LengthBits) + 1;
+            std::size_t count = (token & ((1u << Lzss::LengthBits) - 1)) + Lzss::MinMatch;
+            if (offset > m_length || count > m_capacity - m_length) {
+                m_failed = true;                                                // Повтор до начала данных или за буфер
+                return false;
+            }
+            for (std::size_t i = 0; i < count; ++i, ++m_length) {
+                m_out[m_length] = m_out[m_length - offset];
+            }
+        }
+    }
+    m_bits &= (1u << m_count) - 1;
+    return true;
+}
+
+} // namespace protocol
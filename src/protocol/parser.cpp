@@ -1,11 +1,12 @@
 #include "../../include/protocol/parser.hpp"
 #include "../../include/protocol/crc.hpp"
+#include "../../include/protocol/sender.hpp"
 
 namespace protocol {
 
 /**
  * Конструктор парсера протокола
- * uart Ссылка на UART драйвер для приема данных
+ * uart Канал (UART, последовательный порт хоста, loopback) для приема данных
  * handler Функция-обработчик собранных пакетов
  * user_data Пользовательские данные для callback
  * 
@@ -13,7 +14,7 @@ namespace protocol {
  * UART должен быть инициализирован до создания парсера
  */
 
-Parser::Parser(drivers::Uart& uart, PacketHandler handler, void* user_data)
+Parser::Parser(drivers::Serial& uart, PacketHandler handler, void* user_data)
     : m_uart(uart), m_handler(handler), m_user_data(user_data) {
     m_uart.set_rx_callback([](std::uint8_t byte, void* arg) {
         static_cast<Parser*>(arg)->process_byte(byte);
@@ -27,8 +28,12 @@ Parser::Parser(drivers::Uart& uart, PacketHandler handler, void* user_data)
  * Реализует конечный автомат для разбора пакетов протокола
  * Вызывается из контекста прерывания/задачи UART - должен быть быстрым
  * 
- * Формат пакета:
- * [0xFA][length_low][length_high][header_crc][seq][data...][data_crc][0xFB]
+ * Формат пакета (совпадает с формируемым в Sender):
+ * [0xFA][length_low][length_high][header_crc][0xFB][data...][data_crc][0xFE]
+ * Пакеты длиннее Packet::MaxSize и пакеты без маркеров отбрасываются
+ * Данные сжатого кадра распаковываются по мере приема: CRC данных
+ *       проверяется по распакованным
+ * На кадр с верной CRC заголовка, но поврежденными данными отправляется Nack
  */
 
 void Parser::process_byte(std::uint8_t byte) {
@@ -45,28 +50,39 @@ void Parser::process_byte(std::uint8_t byte) {
             m_state = State::GetLengthHigh;
             break;
 
-        case State::GetLengthHigh:                  // Получение старшего байта длины данных
+        case State::GetLengthHigh:                  // Получение старшего байта длины данных и флага сжатия
             m_packet.length |= (byte << 8);
-            m_state = State::GetHeaderCrc;
+            m_compressed = (m_packet.length & Packet::CompressedFlag) != 0;
+            m_length = m_packet.length & static_cast<std::uint16_t>(~Packet::CompressedFlag);
+            m_state = m_length <= Packet::MaxSize && (!m_compressed || Lzss::Enabled) ? State::GetHeaderCrc : State::GetHeader;
             break;
 
         case State::GetHeaderCrc:                   // Получение CRC заголовка (0xFA + length_low + length_high)
             m_packet.header_crc = byte;
             m_index = 0;
+            m_received = 0;
+            if (m_compressed) {
+                m_decoder.reset(m_packet.data, Packet::MaxSize);
+            }
             m_state = State::GetDataStart;
             break;
 
-        case State::GetDataStart:                   // Получение порядкового номера пакета (первый байт данных)
-            m_packet.seq = byte;
-            m_packet.data[m_index++] = byte;
-            m_state = State::GetData;
+        case State::GetDataStart:                   // Маркер начала полезных данных
+            if (byte != 0xFB) {
+                m_state = State::GetHeader;
+            } else {
+                m_state = m_length > 0 ? State::GetData : State::GetFooterCrc;
+            }
             break;
 
         case State::GetData:                        // Накопление полезных данных пакета
-            if (m_index < m_packet.length) {
+            if (m_compressed) {
+                m_decoder.feed(byte);               // Распаковка на лету, ошибка проверяется в конце кадра
+                m_index = m_decoder.length();
+            } else {
                 m_packet.data[m_index++] = byte;
             }
-            if (m_index >= m_packet.length) {       // Проверка завершения приема данных
+            if (++m_received >= m_length) {         // Проверка завершения приема данных
                 m_state = State::GetFooterCrc;
             }
             break;
@@ -77,16 +93,96 @@ void Parser::process_byte(std::uint8_t byte) {
             break;
 
         case State::GetStopByte:                    // Ожидание стопового байта пакета
-            if (byte == 0xFB) {
-                m_packet.valid = Crc::validate(m_packet);
+            if (byte == 0xFE) {
                 m_packet.data_length = m_index;
-                if (m_packet.valid && m_handler) {
+                m_packet.valid = !(m_compressed && m_decoder.failed()) && Crc::validate(m_packet);
+                if (m_packet.valid && m_packet.data_length >= 2) {      // Заголовок сообщения: type | seq
+                    bool compact = (m_packet.data[0] & rpc::CompactFlag) != 0;
+                    m_packet.encoding = compact ? rpc::Encoding::Compact : rpc::Encoding::Fixed;
+                    m_packet.data[0] &= static_cast<std::uint8_t>(~rpc::CompactFlag);    // Получатели сравнивают data[0] с MessageType
+                    m_packet.type = static_cast<rpc::MessageType>(m_packet.data[0]);
+                    m_packet.seq = m_packet.data[1];
+                }
+                if (m_packet.valid && m_packet.data_length >= 2 && m_packet.type == rpc::MessageType::Hello) {
+                    handle_hello();                                     // Сообщение канала - получателям не передается
+                } else if (m_packet.valid && m_handler) {
                     m_handler(m_packet, m_user_data);
                 }
             }
+            if (NackEnabled && !m_packet.valid && Crc::validate_header(m_packet)) {   // Длина верна - кадр принят целиком, но поврежден
+                m_packet.data_length = m_index;
+                send_nack();
+            }
             m_state = State::GetHeader;
             break;
     }
 }
 
+/**
+ * Отправка Nack | seq | type поврежденного кадра
+ *
+ * seq и type берутся из самого поврежденного кадра и сами могут быть
+ *       искажены: другая сторона повторяет только кадры, которые еще ждут
+ *       ответа, поэтому ошибка в них стоит лишь обычного таймаута
+ * На поврежденный Nack ответ не отправляется - иначе стороны обменивались
+ *       бы Nack'ами на зашумленной линии
+ * Прием не ждет канала: если он занят передачей другой задачи, Nack
+ *       пропускается, и кадр повторяется по обычному таймауту
+ */
+
+void Parser::send_nack() {
+    if (m_packet.data_length < 2 || (m_packet.data[0] & ~rpc::CompactFlag) == static_cast<std::uint8_t>(rpc::MessageType::Nack)) {
+        return;
+    }
+    std::uint8_t type = m_packet.data[0] & static_cast<std::uint8_t>(~rpc::CompactFlag);
+    std::uint8_t nack[3] = {static_cast<std::uint8_t>(rpc::MessageType::Nack), m_packet.data[1], type};
+    Sender sender(m_uart);
+    if (sender.send_control(nack, sizeof(nack))) {
+        ++m_nacks_sent;
+    }
+}
+
+/**
+ * Начало согласования возможностей канала
+ * Вызывается приложением при установке связи (после открытия порта или
+ *       запуска планировщика); до ответа другой стороны кадры не сжимаются
+ * Сторона, которая не знает Hello (старая прошивка), его игнорирует -
+ *       канал остается без сжатия
+ */
+
+bool Parser::negotiate() {
+    return send_hello(false);
+}
+
+/**
+ * Обработка Hello | seq | features | reply
+ *
+ * Сжатие к другой стороне - только если она принимает сжатые кадры, а эта
+ *       сборка их формирует
+ * Ответ уходит из контекста приема без ожидания канала: если канал занят,
+ *       ответ пропускается, и другая сторона до следующего negotiate()
+ *       просто не сжимает кадры к этой - согласование не ломает канал
+ */
+
+void Parser::handle_hello() {
+    if (m_packet.data_length < 4) {
+        return;
+    }
+    m_uart.set_features(m_packet.data[2] & LocalFeatures);
+    if (m_packet.data[3] == 0) {
+        send_hello(true);
+    }
+}
+
+// Начало согласования - из задачи приложения (ожидание канала), ответ - из контекста приема (без ожидания)
+bool Parser::send_hello(bool reply) {
+    std::uint8_t hello[4] = {static_cast<std::uint8_t>(rpc::MessageType::Hello), 0, LocalFeatures, reply ? std::uint8_t{1} : std::uint8_t{0}};
+    static_assert(sizeof(hello) <= Sender::ControlSize, "Hello does not fit a control frame");
+    Sender sender(m_uart);
+    if (reply) {
+        return sender.send_control(hello, sizeof(hello));
+    }
+    return sender.send_transport(hello, sizeof(hello), hello[1], rpc::MessageType::Hello);
+}
+
 } // namespace protocol
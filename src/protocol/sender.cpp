@@ -1,34 +1,121 @@
 #include "../../include/protocol/sender.hpp"
 #include "../../include/protocol/crc.hpp"
-#include "../../include/drivers/uart.hpp"
+#include "../../include/drivers/serial.hpp"
 #include "../../include/rpc/types.hpp"
+#include <cstring>
 
 namespace protocol {
 
 /**
  * Конструктор отправителя протокола
- * uart Ссылка на UART драйвер для отправки данных
+ * uart Канал для отправки данных (UART на МК, порт или loopback на хосте)
  * 
- * Инициализирует ссылку на UART драйвер
- * UART должен быть инициализирован до использования отправителя
+ * Инициализирует ссылку на канал
+ * Канал должен быть инициализирован до использования отправителя
  */
 
-Sender::Sender(drivers::Uart& uart) : m_uart(uart) {}
+Sender::Sender(drivers::Serial& uart) : m_uart(uart) {}
 
-// Буфер для формирования пакета: заголовок(4) + стартер данных(1) + данные + CRC(1) + стоп(1)
-bool Sender::send_transport(const std::uint8_t* data, std::size_t length, std::uint8_t seq, rpc::MessageType type) {
-    std::uint8_t packet[Packet::MaxSize + 7];                           // Максимальный размер пакета
+// seq и type уже входят в полезные данные (type | seq | ...) и в кадр отдельно не пишутся
+bool Sender::send_transport(const std::uint8_t* data, std::size_t length, std::uint8_t, rpc::MessageType) {
+    if (length > Packet::MaxSize) {
+        return false;                                                   // Кадр не будет принят парсером
+    }
+    Frame frame;
+    std::memcpy(frame.payload(), data, length);                         // Копирование полезных данных
+    return seal(frame, length) && send(frame);
+}
+
+/**
+ * Отправка кадра
+ * frame Кадр, оформленный seal
+ *
+ * Кадр сжимается, только если сжатие согласовано с другой стороной, данные
+ *       не короче порога и сжатые данные короче исходных; сжатый кадр
+ *       собирается на стеке, исходный не меняется
+ */
+
+bool Sender::send(const Frame& frame) {
+    if (frame.length == 0) {
+        return false;
+    }
+    std::size_t length = frame.length - Frame::HeaderSize - Frame::TrailerSize;
+    bool negotiated = (m_uart.features() & static_cast<std::uint8_t>(rpc::LinkFeature::Compression)) != 0;
+    if (Lzss::Enabled && negotiated && length >= Lzss::Threshold) {
+        Frame packed;
+        if (compress(frame, packed)) {
+            return m_uart.write(packed.bytes, packed.length);           // Отправка сжатого кадра
+        }
+    }
+    return m_uart.write(frame.bytes, frame.length);                     // Отправка кадра целиком
+}
+
+/**
+ * Отправка служебного кадра
+ * data, length Полезные данные (не длиннее ControlSize)
+ *
+ * Вызывается из контекста приема: кадр собирается в буфере по своему размеру,
+ *       не сжимается и не ждет канала, занятого передачей другой задачи -
+ *       потерянный служебный кадр стоит другой стороне только таймаута
+ */
+
+bool Sender::send_control(const std::uint8_t* data, std::size_t length) {
+    if (length > ControlSize) {
+        return false;
+    }
+    std::uint8_t packet[Frame::HeaderSize + ControlSize + Frame::TrailerSize];
+    std::memcpy(packet + Frame::HeaderSize, data, length);
+    std::size_t total = envelope(packet, length, static_cast<std::uint16_t>(length), Crc::calculate(data, length));
+    return m_uart.try_write(packet, total);
+}
+
+/**
+ * Оформление кадра
+ * frame Кадр с полезными данными в frame.payload()
+ * length Длина полезных данных
+ * false если данные не помещаются в кадр
+ */
+
+bool Sender::seal(Frame& frame, std::size_t length) {
+    if (length > Packet::MaxSize) {
+        frame.length = 0;
+        return false;
+    }
+    frame.length = envelope(frame.bytes, length, static_cast<std::uint16_t>(length), Crc::calculate(frame.payload(), length)); // CRC только полезных данных
+    return true;
+}
+
+/**
+ * Сжатие кадра
+ * frame Оформленный кадр
+ * packed Сжатый кадр: длина сжатых данных с CompressedFlag, CRC данных -
+ *       из исходного кадра (считается по распакованным данным)
+ */
+
+bool Sender::compress(const Frame& frame, Frame& packed) {
+    std::size_t length = frame.length - Frame::HeaderSize - Frame::TrailerSize;
+    std::size_t packed_length = Lzss::compress(frame.payload(), length, packed.payload(), length - 1);
+    if (packed_length == 0) {
+        return false;                                                   // Не короче исходного - сжатие не выгодно
+    }
+    packed.length = envelope(packed.bytes, packed_length, static_cast<std::uint16_t>(packed_length | Packet::CompressedFlag), frame.payload()[length]);
+    return true;
+}
+
+/**
+ * Заголовок и хвост кадра
+ * Формат: заголовок(4) + стартер данных(1) + данные + CRC(1) + стоп(1)
+ */
+
+std::size_t Sender::envelope(std::uint8_t* packet, std::size_t length, std::uint16_t length_field, std::uint8_t data_crc) {
     packet[0] = 0xFA;                                                   // Стартовый байт заголовка
-    packet[1] = length & 0xFF;                                          // Младший байт длины данных (LSB)
-    packet[2] = length >> 8;                                            // Старший байт длины данных (MSB)
+    packet[1] = length_field & 0xFF;                                    // Младший байт длины данных (LSB)
+    packet[2] = length_field >> 8;                                      // Старший байт длины данных (MSB) и флаг сжатия
     packet[3] = Crc::calculate(packet, 3);                              // CRC заголовка (байты 0-2: 0xFA + l_l + l_h)
     packet[4] = 0xFB;                                                   // Начало данных / Маркер начала полезных данных
-    for (std::size_t i = 0; i < length; ++i) {                          // Копирование полезных данных
-        packet[5 + i] = data[i];                                        // Полезные данные
-    }
-    packet[5 + length] = Crc::calculate(data, length);                  // CRC только полезных данных
+    packet[5 + length] = data_crc;                                      // CRC полезных данных
     packet[6 + length] = 0xFE;                                          // Стоповый байт
-    return m_uart.send(packet, length + 7, pdMS_TO_TICKS(100));         // Отправка через UART с таймаутом 100ms
+    return length + Frame::HeaderSize + Frame::TrailerSize;
 }
 
 } // namespace protocol
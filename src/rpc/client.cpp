@@ -7,34 +7,643 @@ namespace rpc {
 
 /**
  * Конструктор RPC клиента
- * uart Ссылка на UART драйвер для отправки запросов
+ * uart Канал для отправки запросов (UART или любой drivers::Serial)
  * parser Ссылка на парсер для приема ответов
  * 
- * Создает очередь FreeRTOS для приема ответных пакетов
- * Парсер должен быть настроен для отправки пакетов в эту очередь
+ * Создает счетный семафор свободных слотов таблицы ожидающих вызовов,
+ *       однократный программный таймер таймаутов асинхронных вызовов
+ *       и очередь задачи повторов (на каждый слот)
+ * Ответы должны передаваться клиенту через handle_packet
  */
 
-Client::Client(drivers::Uart& uart, protocol::Parser& parser)
-    : m_uart(uart), m_parser(parser), m_sequence(0), m_response_queue(xQueueCreate(10, sizeof(protocol::Packet))) {}
+Client::Client(drivers::Serial& uart, protocol::Parser& parser)
+    : m_uart(uart), m_parser(parser), m_sequence(0),
+      m_free_slots(xSemaphoreCreateCounting(MaxPendingCalls, MaxPendingCalls)),
+      m_timeout_timer(xTimerCreate("RpcTimeout", 1, pdFALSE, this, timeout_callback)),
+      m_resend_queue(xQueueCreate(MaxPendingCalls, sizeof(std::uint8_t))),
+      m_rtt_mutex(xSemaphoreCreateMutex()) {}
+
+/**
+ * Маршрутизация принятого ответа
+ * packet Принятый пакет (Response, Error или BatchResponse)
+ * true если ответ передан ожидающей задаче, false если его никто не ждет
+ *
+ * Вызывается из контекста приема: копирует ответ в слот по seq и будит
+ *       ожидающую задачу уведомлением; ответы на просроченные запросы отбрасываются
+ */
+
+bool Client::handle_packet(const protocol::Packet& packet) {
+    if (!packet.valid || packet.data_length > protocol::Packet::MaxSize) {
+        return false;
+    }
+    PendingCall& call = m_pending[packet.seq & (MaxPendingCalls - 1)];
+    bool delivered = false;
+    TaskHandle_t waiter = nullptr;
+    Completion complete = nullptr;
+    void (*callback)() = nullptr;
+    taskENTER_CRITICAL();
+    if (call.active && call.status == CallStatus::Pending && call.seq == packet.seq) {
+        std::memcpy(call.data, packet.data, packet.data_length);
+        call.length = packet.data_length;
+        call.encoding = packet.encoding;
+        bool ok = packet.data_length > 0 && call.data[0] != static_cast<std::uint8_t>(MessageType::Error);
+        call.status = ok ? CallStatus::Ok : CallStatus::Error;
+        if (call.attempt == 0 && call.nacks == 0) {                                 // Алгоритм Карна: ответ на повтор не измеряется
+            TickType_t rtt = xTaskGetTickCount() - call.sent;
+            m_link_rtt.sample(rtt);
+            if (call.estimator != nullptr) {
+                call.estimator->sample(rtt);
+            }
+        }
+        waiter = call.waiter;
+        complete = call.complete;
+        callback = call.callback;
+        delivered = true;
+    }
+    taskEXIT_CRITICAL();
+    if (delivered) {
+        wake_followers(call);
+    }
+    if (complete != nullptr) {                                                      // Асинхронный вызов с callback'ом - вызов прямо из контекста приема
+        std::size_t length = 0;
+        const std::uint8_t* result = result_of(call.data, call.length, length);
+        complete(callback, call.status, result, length, call.encoding);
+        release(packet.seq);
+    } else if (waiter != nullptr) {
+        xTaskNotifyGive(waiter);
+    }
+    return delivered;
+}
+
+/**
+ * Быстрый повтор запроса по Nack
+ * seq Порядковый номер из Nack (номер поврежденного запроса)
+ * true если запрос еще ждет ответа и отправлен повторно
+ *
+ * Сервер получил запрос с поврежденными данными: кадр из слота повторяется
+ *       сразу, через один RTT, а не после таймаута; отправляет его задача
+ *       повторов, контекст приема только ставит слот в очередь; таймаут
+ *       вызова не сдвигается и остается защитой от потери самого Nack
+ * Повторов по Nack не больше MaxRetries на вызов, ответ на такой вызов
+ *       не измеряется (алгоритм Карна)
+ */
+
+bool Client::handle_nack(std::uint8_t seq) {
+    PendingCall& call = m_pending[seq & (MaxPendingCalls - 1)];
+    taskENTER_CRITICAL();
+    bool repeat = call.active && call.status == CallStatus::Pending && call.seq == seq
+                  && call.request.length > 0 && call.nacks < MaxRetries;
+    if (repeat) {
+        ++call.nacks;
+    }
+    taskEXIT_CRITICAL();
+    if (repeat) {
+        schedule_resend(seq);
+    }
+    return repeat;
+}
+
+/**
+ * Резервирование слота для нового запроса
+ * seq Выходной параметр - порядковый номер запроса
+ * timeout Время ожидания свободного слота
+ * estimator Оценка времени ответа вызываемой функции (nullptr - только канала)
+ * true если слот занят вызывающей задачей
+ *
+ * Порядковый номер выбирается так, чтобы его слот (seq & (MaxPendingCalls - 1))
+ *       был свободен; семафор гарантирует наличие хотя бы одного такого слота
+ */
+
+bool Client::acquire(std::uint8_t& seq, TickType_t timeout, RttEstimator* estimator) {
+    if (xSemaphoreTake(m_free_slots, timeout) != pdPASS) {
+        return false;                                                               // Окно конвейера заполнено
+    }
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    taskENTER_CRITICAL();
+    for (std::size_t i = 0; i < MaxPendingCalls; ++i) {
+        seq = m_sequence++;
+        PendingCall& call = m_pending[seq & (MaxPendingCalls - 1)];
+        if (!call.active) {
+            call.active = true;
+            call.async = false;
+            call.status = CallStatus::Pending;
+            call.seq = seq;
+            call.waiter = self;
+            call.complete = nullptr;
+            call.callback = nullptr;
+            call.attempt = 0;
+            call.nacks = 0;
+            call.resend = false;
+            call.estimator = estimator;
+            call.shared = false;
+            call.users = 1;
+            call.follower_count = 0;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL();
+    xTaskNotifyStateClear(self);                                                    // Сброс уведомления от ответа на прошлый просроченный запрос
+    return true;
+}
+
+// Освобождение слота запроса последней использующей его задачей - поздний ответ будет отброшен
+void Client::release(std::uint8_t seq) {
+    PendingCall& call = m_pending[seq & (MaxPendingCalls - 1)];
+    taskENTER_CRITICAL();
+    bool owned = call.active && call.seq == seq && --call.users == 0;
+    if (owned) {
+        call.active = false;
+        call.shared = false;
+        call.follower_count = 0;
+        call.async = false;
+        call.waiter = nullptr;
+    }
+    taskEXIT_CRITICAL();
+    if (owned) {
+        xSemaphoreGive(m_free_slots);
+    }
+}
 
 /**
  * Ожидание ответа по порядковому номеру (сырой пакет)
  * response Ссылка для сохранения полученного пакета
- * seq Ожидаемый порядковый номер ответа
+ * seq Порядковый номер запроса, полученный при резервировании слота
  * timeout Таймаут ожидания в тиках FreeRTOS
- * true если ответ получен и номер совпадает, false при таймауте или несовпадении
+ * true если ответ получен, false при таймауте или если слот не занят
  * 
- * Блокирует вызывающую задачу до получения ответа
- * Не проверяет валидность пакета - только порядковый номер
+ * Блокирует вызывающую задачу до уведомления из handle_packet
+ * Слот освобождается в любом случае
  */
 
 bool Client::wait_response(protocol::Packet& response, std::uint8_t seq, TickType_t timeout) {
-    protocol::Packet packet;
-    if (xQueueReceive(m_response_queue, &packet, timeout) == pdPASS && packet.seq == seq) {
-        response = packet;
-        return true;
+    PendingCall& call = m_pending[seq & (MaxPendingCalls - 1)];
+    if (!call.active || call.seq != seq) {
+        return false;
     }
-    return false;
+    bool completed = wait_for(seq, timeout) != CallStatus::Pending;
+    if (completed) {
+        response.valid = true;
+        response.seq = seq;
+        response.type = static_cast<MessageType>(call.data[0]);
+        std::memcpy(response.data, call.data, call.length);
+        response.data_length = call.length;
+        const char* name = reinterpret_cast<const char*>(call.data + 2);
+        bool named = call.length > 2 && std::memchr(name, '\0', call.length - 2) != nullptr;
+        response.func_name = named ? name : "";
+    }
+    release(seq);
+    return completed;
+}
+
+/**
+ * Резервирование слота под асинхронный вызов
+ * seq Выходной параметр - порядковый номер запроса
+ * complete, callback Трамплин и callback пользователя (nullptr - результат забирает handle)
+ * estimator Оценка времени ответа функции; срок первой попытки отсчитывается
+ *       программным таймером
+ * true если слот занят; не блокирует - при заполненном окне возвращает false
+ */
+
+bool Client::acquire_async(std::uint8_t& seq, Completion complete, void (*callback)(), RttEstimator* estimator) {
+    if (!acquire(seq, 0, estimator)) {
+        return false;
+    }
+    PendingCall& call = m_pending[seq & (MaxPendingCalls - 1)];
+    TickType_t timeout = timeout_for(estimator, 0);
+    taskENTER_CRITICAL();
+    call.async = true;
+    call.waiter = nullptr;                                                          // Задача-ожидатель назначается в wait()
+    call.deadline = xTaskGetTickCount() + timeout;
+    call.complete = complete;
+    call.callback = callback;
+    taskEXIT_CRITICAL();
+    arm_timer();
+    return true;
+}
+
+// Состояние вызова по порядковому номеру
+CallStatus Client::status_of(std::uint8_t seq) {
+    PendingCall& call = m_pending[seq & (MaxPendingCalls - 1)];
+    taskENTER_CRITICAL();
+    CallStatus status = call.active && call.seq == seq ? call.status : CallStatus::Error;
+    taskEXIT_CRITICAL();
+    return status;
+}
+
+/**
+ * Ожидание завершения вызова
+ * seq Порядковый номер вызова
+ * timeout Максимальное время ожидания
+ * Состояние вызова (Pending, если время ожидания истекло раньше ответа)
+ *
+ * Вызывающая задача становится получателем уведомления из handle_packet
+ *       или таймера; уведомление может быть устаревшим, поэтому состояние
+ *       проверяется заново после каждого пробуждения
+ */
+
+CallStatus Client::wait_for(std::uint8_t seq, TickType_t timeout) {
+    PendingCall& call = m_pending[seq & (MaxPendingCalls - 1)];
+    TickType_t start = xTaskGetTickCount();
+    taskENTER_CRITICAL();
+    if (call.active && call.seq == seq) {
+        call.waiter = xTaskGetCurrentTaskHandle();
+    }
+    taskEXIT_CRITICAL();
+    while (true) {
+        CallStatus status = status_of(seq);
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (status != CallStatus::Pending || elapsed >= timeout) {
+            return status;
+        }
+        ulTaskNotifyTake(pdTRUE, timeout - elapsed);
+    }
+}
+
+/**
+ * Ожидание ответа синхронного вызова с повторами
+ * seq Порядковый номер уже отправленного запроса
+ * Состояние вызова: Ok, Error или Timeout после MaxRetries повторов
+ *
+ * Каждая попытка ждет таймаут из оценки времени ответа, удвоенный номером
+ *       попытки; повтор отправляется с тем же seq, поэтому сервис вернет
+ *       сохраненный ответ, если потерян был ответ, а не запрос
+ */
+
+CallStatus Client::transact(std::uint8_t seq) {
+    PendingCall& call = m_pending[seq & (MaxPendingCalls - 1)];
+    for (std::uint8_t attempt = 0;; ++attempt) {
+        CallStatus status = wait_for(seq, timeout_for(call.estimator, attempt));
+        if (status != CallStatus::Pending) {
+            return status;
+        }
+        taskENTER_CRITICAL();
+        bool retry = attempt < MaxRetries;
+        if (retry) {
+            call.attempt = attempt + 1;
+            m_link_rtt.retry();
+        } else {
+            call.status = CallStatus::Timeout;                                      // Итог виден и присоединившимся задачам
+            m_link_rtt.expire();
+        }
+        if (call.estimator != nullptr) {
+            retry ? call.estimator->retry() : call.estimator->expire();
+        }
+        taskEXIT_CRITICAL();
+        if (!retry) {
+            wake_followers(call);
+            return CallStatus::Timeout;
+        }
+        if (!retransmit(seq)) {
+            return fail(seq);
+        }
+    }
+}
+
+/**
+ * Присоединение к уже отправленному запросу
+ * frame Запрос вызывающей задачи (seq = 0)
+ * seq Выходной параметр - порядковый номер найденного запроса
+ * true если задача присоединилась и должна ждать ответа в wait_joined
+ *
+ * Подходит ожидающий ответа синхронный запрос с разрешенным объединением,
+ *       совпадающий по типу, имени и аргументам; слот не освобождается,
+ *       пока его не отпустят все присоединившиеся задачи
+ */
+
+bool Client::join(const protocol::Frame& frame, std::uint8_t& seq) {
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    std::size_t length = frame.length - protocol::Frame::HeaderSize - protocol::Frame::TrailerSize;
+    bool joined = false;
+    xTaskNotifyStateClear(self);
+    taskENTER_CRITICAL();
+    for (PendingCall& call : m_pending) {
+        if (call.active && call.shared && call.status == CallStatus::Pending
+            && call.follower_count < MaxCoalescedCalls && call.request.length == frame.length
+            && call.request.payload()[0] == frame.payload()[0]
+            && std::memcmp(call.request.payload() + 2, frame.payload() + 2, length - 2) == 0) {     // name\0 | args без seq
+            call.followers[call.follower_count++] = self;
+            ++call.users;
+            seq = call.seq;
+            joined = true;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL();
+    return joined;
+}
+
+// Ожидание итога чужого запроса: ведущая задача всегда завершает его с Ok, Error или Timeout
+CallStatus Client::wait_joined(std::uint8_t seq) {
+    while (true) {
+        CallStatus status = status_of(seq);
+        if (status != CallStatus::Pending) {
+            return status;
+        }
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+}
+
+// Отправка запроса из готового кадра (с seq = 0) с разрешением присоединения
+bool Client::lead(std::uint8_t seq, const protocol::Frame& frame) {
+    PendingCall& call = m_pending[seq & (MaxPendingCalls - 1)];
+    std::size_t length = frame.length - protocol::Frame::HeaderSize - protocol::Frame::TrailerSize;
+    std::memcpy(call.request.payload(), frame.payload(), length);
+    call.request.payload()[1] = seq;
+    if (!protocol::Sender::seal(call.request, length)) {                            // CRC пересчитывается с настоящим seq
+        return false;
+    }
+    taskENTER_CRITICAL();
+    call.shared = true;
+    taskEXIT_CRITICAL();
+    return retransmit(seq);
+}
+
+// Запрос не отправлен: итог Error виден присоединившимся задачам
+CallStatus Client::fail(std::uint8_t seq) {
+    PendingCall& call = m_pending[seq & (MaxPendingCalls - 1)];
+    taskENTER_CRITICAL();
+    call.status = CallStatus::Error;
+    taskEXIT_CRITICAL();
+    wake_followers(call);
+    return CallStatus::Error;
+}
+
+void Client::wake_followers(PendingCall& call) {
+    TaskHandle_t followers[MaxCoalescedCalls];
+    std::size_t count = 0;
+    taskENTER_CRITICAL();
+    if (call.shared) {
+        call.shared = false;                                                        // Итог известен - новые задачи не присоединяются
+        count = call.follower_count;
+        for (std::size_t i = 0; i < count; ++i) {
+            followers[i] = call.followers[i];
+        }
+    }
+    taskEXIT_CRITICAL();
+    for (std::size_t i = 0; i < count; ++i) {
+        xTaskNotifyGive(followers[i]);
+    }
+}
+
+// Разрешение объединять одновременные вызовы функции с одинаковыми аргументами
+bool Client::coalesce(const std::string& name) {
+    Method* method = method_for(name.c_str());
+    if (method == nullptr) {
+        return false;                                                               // Таблица функций заполнена
+    }
+    xSemaphoreTake(m_rtt_mutex, portMAX_DELAY);
+    method->coalesce = true;
+    xSemaphoreGive(m_rtt_mutex);
+    return true;
+}
+
+// Кодирование аргументов и результатов всех функций без собственного кодирования
+bool Client::set_encoding(Encoding encoding) {
+    if (encoding == Encoding::Compact && !CompactEnabled) {
+        return false;
+    }
+    m_encoding = encoding;
+    return true;
+}
+
+// Кодирование аргументов и результатов одной функции
+bool Client::set_encoding(const std::string& name, Encoding encoding) {
+    Method* method = encoding == Encoding::Compact && !CompactEnabled ? nullptr : method_for(name.c_str());
+    if (method == nullptr) {
+        return false;                                                               // Compact отключен или таблица функций заполнена
+    }
+    xSemaphoreTake(m_rtt_mutex, portMAX_DELAY);
+    method->encoding = encoding;
+    xSemaphoreGive(m_rtt_mutex);
+    return true;
+}
+
+/**
+ * Состояние функции
+ * function_name Имя функции
+ * Запись из таблицы (создается при первом вызове функции) или nullptr,
+ *       если таблица заполнена - тогда используется только оценка канала
+ */
+
+Client::Method* Client::method_for(const char* function_name) {
+    Method* found = nullptr;
+    xSemaphoreTake(m_rtt_mutex, portMAX_DELAY);
+    for (Method& method : m_methods) {
+        if (method.name == function_name) {
+            found = &method;
+            break;
+        }
+        if (method.name.empty()) {                                                  // Записи заполняются подряд - функции в таблице нет
+            method.name = function_name;
+            found = &method;
+            break;
+        }
+    }
+    xSemaphoreGive(m_rtt_mutex);
+    return found;
+}
+
+// Таймаут попытки: функция с измерениями использует свою оценку, новая - оценку канала
+TickType_t Client::timeout_for(RttEstimator* estimator, std::uint8_t attempt) {
+    taskENTER_CRITICAL();
+    const RttEstimator& source = estimator != nullptr && estimator->calibrated() ? *estimator : m_link_rtt;
+    TickType_t timeout = source.timeout(attempt);
+    taskEXIT_CRITICAL();
+    return timeout;
+}
+
+RttStats Client::rtt_stats() const {
+    taskENTER_CRITICAL();
+    RttStats stats = m_link_rtt.stats();
+    taskEXIT_CRITICAL();
+    return stats;
+}
+
+// Оценка времени ответа одной функции
+bool Client::rtt_stats(const std::string& name, RttStats& stats) const {
+    bool found = false;
+    xSemaphoreTake(m_rtt_mutex, portMAX_DELAY);
+    for (const Method& method : m_methods) {
+        if (!method.name.empty() && method.name == name) {
+            taskENTER_CRITICAL();
+            stats = method.rtt.stats();
+            taskEXIT_CRITICAL();
+            found = true;
+            break;
+        }
+    }
+    xSemaphoreGive(m_rtt_mutex);
+    return found;
+}
+
+// Поиск результата в ответе type | seq | name\0 | result... / nullptr если ответ без результата
+// Срок кэширования в CachedResponse пропускается - этот клиент ответы не кэширует
+const std::uint8_t* Client::result_of(const std::uint8_t* data, std::size_t length, std::size_t& result_length) {
+    result_length = 0;
+    if (length <= 2) {
+        return nullptr;
+    }
+    const void* terminator = std::memchr(data + 2, '\0', length - 2);
+    if (terminator == nullptr) {
+        return nullptr;
+    }
+    const std::uint8_t* result = static_cast<const std::uint8_t*>(terminator) + 1;
+    if (data[0] == static_cast<std::uint8_t>(MessageType::CachedResponse)) {
+        result += sizeof(std::uint16_t);
+        if (result > data + length) {
+            return nullptr;
+        }
+    }
+    result_length = length - static_cast<std::size_t>(result - data);
+    return result;
+}
+
+/**
+ * Завершение просроченных асинхронных вызовов
+ *
+ * Выполняется в задаче таймеров FreeRTOS: вызов с истекшим сроком получает
+ *       удвоенный таймаут и ставится в очередь задачи повторов (кадр с тем же
+ *       seq отправляет она), после MaxRetries повторов получает Timeout;
+ *       callback'и вызываются вне критической секции, затем таймер
+ *       перевзводится на ближайший из оставшихся сроков
+ */
+
+void Client::expire_calls() {
+    TickType_t now = xTaskGetTickCount();
+    for (PendingCall& call : m_pending) {
+        TaskHandle_t waiter = nullptr;
+        Completion complete = nullptr;
+        void (*callback)() = nullptr;
+        bool expired = false;
+        bool retry = false;
+        taskENTER_CRITICAL();
+        if (call.active && call.async && call.status == CallStatus::Pending
+            && static_cast<std::int32_t>(now - call.deadline) >= 0) {
+            RttEstimator* estimator = call.estimator != nullptr && call.estimator->calibrated() ? call.estimator : &m_link_rtt;
+            retry = call.attempt < MaxRetries;
+            if (retry) {                                                            // Повтор с откатом таймаута
+                ++call.attempt;
+                call.deadline = now + estimator->timeout(call.attempt);
+                m_link_rtt.retry();
+            } else {
+                call.status = CallStatus::Timeout;
+                waiter = call.waiter;
+                complete = call.complete;
+                callback = call.callback;
+                expired = true;
+                m_link_rtt.expire();
+            }
+            if (call.estimator != nullptr) {
+                retry ? call.estimator->retry() : call.estimator->expire();
+            }
+        }
+        taskEXIT_CRITICAL();
+        if (retry) {
+            schedule_resend(call.seq);
+        } else if (complete != nullptr) {
+            complete(callback, CallStatus::Timeout, nullptr, 0, Encoding::Fixed);
+            release(call.seq);
+        } else if (expired && waiter != nullptr) {
+            xTaskNotifyGive(waiter);
+        }
+    }
+    arm_timer();
+}
+
+// Взвод однократного таймера на ближайший срок среди ожидающих асинхронных вызовов
+void Client::arm_timer() {
+    TickType_t now = xTaskGetTickCount();
+    bool armed = false;
+    TickType_t nearest = 0;
+    taskENTER_CRITICAL();
+    for (const PendingCall& call : m_pending) {
+        if (call.active && call.async && call.status == CallStatus::Pending) {
+            std::int32_t remaining = static_cast<std::int32_t>(call.deadline - now);
+            TickType_t delay = remaining > 0 ? static_cast<TickType_t>(remaining) : 1;
+            if (!armed || delay < nearest) {
+                nearest = delay;
+                armed = true;
+            }
+        }
+    }
+    taskEXIT_CRITICAL();
+    if (armed) {
+        xTimerChangePeriod(m_timeout_timer, nearest, 0);                            // Также запускает остановленный таймер
+    } else {
+        xTimerStop(m_timeout_timer, 0);
+    }
+}
+
+// Callback программного таймера - контекст задачи таймеров FreeRTOS
+void Client::timeout_callback(TimerHandle_t timer) {
+    static_cast<Client*>(pvTimerGetTimerID(timer))->expire_calls();
+}
+
+/**
+ * Отправка запросов, помеченных для повтора
+ * timeout Время ожидания первого запроса в очереди
+ *
+ * Цикл задачи повторов: блокируется до первого запроса, затем отправляет
+ *       все накопившиеся; на время отправки задача числится пользователем
+ *       слота, поэтому слот завершенного тем временем вызова не займет
+ *       новый запрос до конца передачи
+ * Запрос, получивший ответ или итог раньше отправки, пропускается
+ */
+
+void Client::process_resends(TickType_t timeout) {
+    std::uint8_t seq;
+    while (xQueueReceive(m_resend_queue, &seq, timeout) == pdPASS) {
+        PendingCall& call = m_pending[seq & (MaxPendingCalls - 1)];
+        taskENTER_CRITICAL();
+        bool marked = call.active && call.seq == seq && call.resend;
+        bool pending = marked && call.status == CallStatus::Pending;
+        if (marked) {
+            call.resend = false;
+        }
+        if (pending) {
+            ++call.users;
+        }
+        taskEXIT_CRITICAL();
+        if (pending) {
+            retransmit(seq);
+            release(seq);
+        }
+        timeout = 0;                                                                // Остаток очереди без ожидания
+    }
+}
+
+// Слот помечается один раз: повторная пометка до отправки не добавляет запрос в очередь
+void Client::schedule_resend(std::uint8_t seq) {
+    PendingCall& call = m_pending[seq & (MaxPendingCalls - 1)];
+    taskENTER_CRITICAL();
+    bool queued = call.active && call.seq == seq && !call.resend;
+    if (queued) {
+        call.resend = true;
+    }
+    taskEXIT_CRITICAL();
+    if (queued) {
+        xQueueSend(m_resend_queue, &seq, 0);                                        // Места хватает: не больше одного seq на слот
+    }
+}
+
+// Отправка готового кадра (type | seq | ...) с сохранением в слоте для повторов
+bool Client::send_frame(std::uint8_t seq, const std::uint8_t* data, std::size_t length) {
+    if (length > protocol::Packet::MaxSize) {
+        return false;
+    }
+    PendingCall& call = m_pending[seq & (MaxPendingCalls - 1)];
+    std::memcpy(call.request.payload(), data, length);
+    return protocol::Sender::seal(call.request, length) && retransmit(seq);
+}
+
+// Отправка сохраненного в слоте запроса; время отправки - начало измерения времени ответа
+bool Client::retransmit(std::uint8_t seq) {
+    PendingCall& call = m_pending[seq & (MaxPendingCalls - 1)];
+    taskENTER_CRITICAL();
+    call.sent = xTaskGetTickCount();
+    taskEXIT_CRITICAL();
+    protocol::Sender sender(m_uart);
+    return sender.send(call.request);                                               // Кадр уже оформлен - повтор без кодирования
 }
 
 /**
@@ -53,93 +662,65 @@ bool Client::wait_response(Message& response, std::uint8_t seq, TickType_t timeo
         response.type = packet.type;
         response.sequence_number = packet.seq;
         response.function_name = packet.func_name;
-        response.arguments = packet.data + packet.func_name.size() + 2; // Skip type and name
-        response.arguments_length = packet.data_length - (packet.func_name.size() + 2);
+        response.arguments = packet.data + packet.func_name.size() + 3; // Skip type, seq and name
+        response.arguments_length = packet.data_length - (packet.func_name.size() + 3);
         return true;
     }
     return false;
 }
 
 /**
- * Синхронный вызов RPC функции с ожиданием результата
- * Result Тип возвращаемого значения (может быть void)
- * Args Типы аргументов функции
- * function_name Имя вызываемой RPC функции
- * args Аргументы функции
- * Результат выполнения функции или значение по умолчанию при ошибке
- * 
- * Блокирует задачу на время выполнения RPC вызова
- * Для void функций возвращает void, для остальных - значение по умолчанию при ошибке
+ * Отправка пакета вызовов и ожидание сводного ответа
+ * timeout Таймаут ожидания ответа в тиках FreeRTOS
+ * true если сводный ответ получен и разобран, false при переполнении, таймауте или ошибке
+ *
+ * Статус и результат каждого вызова доступны через ok() и result()
  */
 
-template<typename Result, typename... Args>
-Result Client::call(const std::string& function_name, Args... args) {
-    protocol::Packet packet;
-    packet.valid = true;
-    packet.seq = m_sequence++;
-    packet.func_name = function_name;
-    packet.type = MessageType::Request;
-
-    std::uint8_t buffer[protocol::Packet::MaxSize];                                 // Формирование бинарного буфера сообщения
-    buffer[0] = static_cast<std::uint8_t>(packet.type);                             // Тип сообщения
-    buffer[1] = packet.seq;                                                         // Порядковый номер
-    std::memcpy(buffer + 2, function_name.c_str(), function_name.size() + 1);       // Копирование имени функции с null terminator
-    std::size_t offset = function_name.size() + 2;
-
-    std::tuple<Args...> args_tuple{args...};                                        // Сериализация аргументов функции
-    Serializer::serialize_tuple(args_tuple, buffer + offset);
-    packet.data_length = offset + Serializer::tuple_size<Args...>();
-    std::memcpy(packet.data, buffer, packet.data_length);
-
-    if (send_message(packet)) {                                                     // Отправка запроса и ожидание ответа
-        protocol::Packet response;
-        if (wait_response(response, packet.seq, pdMS_TO_TICKS(1000))) {             // Ожидание ответа с таймаутом 1 секунда
-            if (response.type == MessageType::Response) {
-                if constexpr (!std::is_void_v<Result>) {                            // Успешный ответ - десериализация результата
-                    return Serializer::deserialize<Result>(response.data + response.func_name.size() + 2);
-                }
-            } else if (response.type == MessageType::Error) {
-                if constexpr (!std::is_void_v<Result>) {                            // Ошибка выполнения - возврат значения по умолчанию
-                    return Result{};
-                }
-            }
-        }
-    }
-    if constexpr (!std::is_void_v<Result>) {                                        // Таймаут или ошибка отправки - возврат значения по умолчанию
-        return Result{};
+bool Batch::send(TickType_t timeout) {
+    m_results = 0;
+    if (m_overflow || m_count == 0) {
+        return false;
     }
-}
-
-/**
- * Асинхронный вызов RPC функции без ожидания результата
- * Args Типы аргументов функции
- * function_name Имя вызываемой RPC функции
- * args Аргументы функции
- * 
- * Отправляет запрос и немедленно возвращает управление
- * Не возвращает результат и не обрабатывает ошибки
- */
 
-template<typename... Args>
-void Client::stream_call(const std::string& function_name, Args... args) {
-    protocol::Packet packet;
-    packet.valid = true;
-    packet.seq = m_sequence++;                                                      // Автоинкремент порядкового номера
-    packet.func_name = function_name;
-    packet.type = MessageType::Stream;                                              // Stream сообщение
-
-    std::uint8_t buffer[protocol::Packet::MaxSize];                                 // Формирование бинарного буфера сообщения
-    buffer[0] = static_cast<std::uint8_t>(packet.type);
-    buffer[1] = packet.seq;
-    std::memcpy(buffer + 2, function_name.c_str(), function_name.size() + 1);       // Включение null terminator
-    std::size_t offset = function_name.size() + 2;
-
-    std::tuple<Args...> args_tuple{args...};                                        // Сериализация аргументов функции
-    Serializer::serialize_tuple(args_tuple, buffer + offset);
-    packet.data_length = offset + Serializer::tuple_size<Args...>();
-    std::memcpy(packet.data, buffer, packet.data_length);
+    std::uint8_t seq = 0;
+    if (!m_client.acquire(seq, timeout)) {
+        return false;
+    }
+    m_request[0] = static_cast<std::uint8_t>(MessageType::BatchRequest);             // Заголовок пакета
+    if (m_encoding == Encoding::Compact) {
+        m_request[0] |= CompactFlag;
+    }
+    m_request[1] = seq;
+    m_request[2] = static_cast<std::uint8_t>(m_count);
+    if (!m_client.send_frame(seq, m_request, m_length)) {
+        m_client.release(seq);
+        return false;
+    }
+    const Client::PendingCall& call = m_client.m_pending[seq & (Client::MaxPendingCalls - 1)];
+    if (m_client.wait_for(seq, timeout) != CallStatus::Ok || call.length < 3
+        || call.data[0] != static_cast<std::uint8_t>(MessageType::BatchResponse)) {
+        m_client.release(seq);
+        return false;
+    }
+    std::size_t length = call.length;
+    m_response_encoding = call.encoding;
+    std::memcpy(m_response, call.data, length);                                     // Ответ читается прямо из слота
+    m_client.release(seq);
 
-    send_message(packet);                                                           // Отправка без ожидания ответа
+    std::size_t offset = 3;                                                         // Разбор результатов: status | result_length | result...
+    std::size_t count = m_response[2] < MaxCalls ? m_response[2] : MaxCalls;
+    for (std::size_t i = 0; i < count && offset + 2 <= length; ++i) {
+        m_ok[i] = m_response[offset] == static_cast<std::uint8_t>(MessageType::Response);
+        m_result_length[i] = m_response[offset + 1];
+        m_result_offset[i] = offset + 2;
+        offset += 2 + m_result_length[i];
+        if (offset > length) {
+            break;                                                                  // Результат обрезан - не учитывается
+        }
+        m_results = i + 1;
+    }
+    return m_results == m_count;
 }
 
 // Отправка сообщения через транспортный протокол / true если отправка успешна, false при ошибке
@@ -149,9 +730,3 @@ bool Client::send_message(const protocol::Packet& msg) {
 }
 
 } // namespace rpc
-
-// Явное инстанцирование шаблонов
-template int32_t rpc::Client::call<int32_t, int32_t, int32_t>(const std::string&, int32_t, int32_t);
-template float rpc::Client::call<float>(const std::string&);
-template void rpc::Client::call<void, bool>(const std::string&, bool);
-template void rpc::Client::stream_call<bool>(const std::string&, bool);
@@ -0,0 +1,109 @@
+#include "../../include/rpc/endpoint.hpp"
+#include <cstring>
+
+namespace rpc {
+
+/**
+ * Конструктор точки RPC
+ * uart Канал (UART или любой drivers::Serial)
+ *
+ * Service при создании назначает себя обработчиком парсера - после создания
+ *       Service и Client обработчиком становится маршрутизатор точки
+ */
+
+Endpoint::Endpoint(drivers::Serial& uart)
+    : m_parser(uart, route, this), m_service(m_parser), m_client(uart, m_parser) {
+    m_parser.set_handler(route, this);
+}
+
+bool Endpoint::subscribe(const std::string& name, StreamHandler handler, void* user_data) {
+    for (Subscriber& subscriber : m_subscribers) {
+        if (subscriber.name.empty() || subscriber.name == name) {
+            subscriber.name = name;
+            subscriber.handler = handler;
+            subscriber.user_data = user_data;
+            return true;
+        }
+    }
+    return false;                                               // Таблица подписчиков заполнена
+}
+
+/**
+ * Маршрутизация принятого пакета
+ * packet Пакет из парсера (тип и seq уже заполнены)
+ *
+ * Выполняется в контексте приема: Service и Client только копируют пакет
+ *       в свои слоты, подписчики Stream вызываются прямо отсюда
+ * Nack передается стороне, отправившей поврежденный кадр (route_nack)
+ */
+
+void Endpoint::route(const protocol::Packet& packet, void* user_data) {
+    auto* endpoint = static_cast<Endpoint*>(user_data);
+    if (!packet.valid || packet.data_length < 2) {
+        return;
+    }
+    switch (packet.type) {
+        case MessageType::Request:
+        case MessageType::BatchRequest:
+            endpoint->m_service.handle_packet(packet);
+            break;
+        case MessageType::Response:
+        case MessageType::CachedResponse:
+        case MessageType::Error:
+        case MessageType::BatchResponse:
+            endpoint->m_client.handle_packet(packet);
+            break;
+        case MessageType::Stream:
+            if (!endpoint->publish(packet)) {
+                endpoint->m_service.handle_packet(packet);     // Нет подписчика - односторонний вызов handler'а
+            }
+            break;
+        case MessageType::Nack:
+            endpoint->route_nack(packet);
+            break;
+        default:
+            break;                                              // Invalidate (клиент устройства не кэширует) и неизвестные типы
+    }
+}
+
+// Nack | seq | type: поврежден наш запрос - повторяет Client, поврежден ответ - Service из окна ответов
+void Endpoint::route_nack(const protocol::Packet& packet) {
+    if (packet.data_length < 3) {
+        return;
+    }
+    switch (static_cast<MessageType>(packet.data[2])) {
+        case MessageType::Request:
+        case MessageType::BatchRequest:
+            m_client.handle_nack(packet.seq);                   // Повтор выполняет задача повторов клиента
+            break;
+        case MessageType::Response:
+        case MessageType::CachedResponse:
+        case MessageType::BatchResponse:
+            m_service.handle_packet(packet);                    // Повтор выполняет задача сервиса, не контекст приема
+            break;
+        default:
+            break;                                              // Stream, Error и Invalidate не хранятся - не повторяются
+    }
+}
+
+// Доставка Stream-сообщения type | seq | name\0 | signature | args... подписчику с таким именем
+bool Endpoint::publish(const protocol::Packet& packet) {
+    const char* name = reinterpret_cast<const char*>(packet.data + 2);
+    const void* terminator = std::memchr(name, '\0', packet.data_length - 2);
+    if (terminator == nullptr) {
+        return false;
+    }
+    std::size_t header_length = static_cast<const std::uint8_t*>(terminator) - packet.data + 1 + SignatureSize;
+    if (header_length > packet.data_length) {
+        return false;
+    }
+    for (const Subscriber& subscriber : m_subscribers) {
+        if (!subscriber.name.empty() && subscriber.name == name) {
+            subscriber.handler(packet.data + header_length, packet.data_length - header_length, subscriber.user_data);
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace rpc
@@ -0,0 +1,47 @@
+#include "../../include/rpc/rtt.hpp"
+
+namespace rpc {
+
+/**
+ * Учет измеренного времени ответа
+ * rtt Время от отправки запроса до получения ответа в тиках
+ *
+ * Первое измерение задает srtt = rtt и rttvar = rtt / 2 (RFC 6298)
+ */
+
+void RttEstimator::sample(std::uint32_t rtt) {
+    if (m_stats.samples == 0) {
+        m_srtt8 = rtt << 3;
+        m_rttvar4 = rtt << 1;
+    } else {
+        std::int32_t delta = static_cast<std::int32_t>(rtt) - static_cast<std::int32_t>(m_srtt8 >> 3);
+        m_srtt8 = static_cast<std::uint32_t>(static_cast<std::int32_t>(m_srtt8) + delta);             // srtt += delta / 8
+        std::int32_t deviation = delta < 0 ? -delta : delta;
+        m_rttvar4 = static_cast<std::uint32_t>(static_cast<std::int32_t>(m_rttvar4) + deviation
+                                               - static_cast<std::int32_t>(m_rttvar4 >> 2));          // rttvar += (|delta| - rttvar) / 4
+    }
+    ++m_stats.samples;
+}
+
+// Таймаут попытки: srtt + 4 * rttvar (не меньше тика сверх srtt), удвоенный attempt раз
+std::uint32_t RttEstimator::timeout(std::uint8_t attempt) const {
+    std::uint32_t base = m_initial;
+    if (m_stats.samples > 0) {
+        base = (m_srtt8 >> 3) + (m_rttvar4 > 1 ? m_rttvar4 : 1);
+    }
+    base = base < m_min ? m_min : base;
+    for (std::uint8_t i = 0; i < attempt && base < m_max; ++i) {
+        base <<= 1;
+    }
+    return base < m_max ? base : m_max;
+}
+
+RttStats RttEstimator::stats() const {
+    RttStats stats = m_stats;
+    stats.srtt = m_srtt8 >> 3;
+    stats.rttvar = m_rttvar4 >> 2;
+    stats.timeout = timeout(0);
+    return stats;
+}
+
+} // namespace rpc
@@ -0,0 +1,32 @@
+#include "../../include/rpc/sample_stream.hpp"
+#include <utility>
+
+namespace rpc {
+
+/**
+ * Конструктор потока выборок
+ * client Клиент, через который отправляются блоки
+ * name Имя Stream-сообщения (емкость блока - кадр без имени)
+ */
+
+SampleStream::SampleStream(Client& client, std::string name)
+    : m_client(client), m_name(std::move(name)), m_encoder(TimeSeriesEncoder::capacity_for(m_name.size())) {}
+
+void SampleStream::push(std::uint32_t timestamp, float value) {
+    if (m_encoder.append(timestamp, value)) {
+        return;
+    }
+    flush();                                                    // Блок заполнен - выборка начинает новый
+    m_encoder.append(timestamp, value);
+}
+
+void SampleStream::flush() {
+    if (m_encoder.empty()) {
+        return;
+    }
+    m_client.stream_call(m_name, m_encoder.block());
+    m_encoder.reset();
+    ++m_blocks;
+}
+
+} // namespace rpc
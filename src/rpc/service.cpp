@@ -3,9 +3,13 @@
 #include <cstring>
 #include "FreeRTOS.h"
 #include "queue.h"
+#include "task.h"
 
 namespace rpc {
 
+// Имя в ответе на вызов по идентификатору (функции из IDL)
+static const std::string NoName;
+
 /**
  * Обработчик входящих пакетов для сервиса
  * packet Принятый пакет для обработки
@@ -24,84 +28,590 @@ void service_packet_handler(const protocol::Packet& packet, void* service_ptr) {
  * Конструктор RPC сервиса
  * parser Ссылка на парсер протокола для приема пакетов
  * 
- * Регистрирует обработчик пакетов в парсере
+ * Регистрирует обработчик пакетов в парсере, создает входящую очередь запросов
+ *       и мьютекс отправки (ответы на отложенные вызовы приходят из других задач)
  * Парсер должен быть инициализирован до создания сервиса
  */
 
-Service::Service(protocol::Parser& parser) : m_parser(parser) {
+Service::Service(protocol::Parser& parser)
+    : m_parser(parser),
+      m_request_queue(xQueueCreate(RequestQueueLength, sizeof(std::uint8_t))),
+      m_tx_mutex(xSemaphoreCreateMutex()) {
     m_parser.set_handler([](const protocol::Packet& packet, void* arg) { service_packet_handler(packet, arg); }, this);
 }
 
 /**
- * Обработка входящего RPC пакета
+ * Прием входящего RPC пакета
  * packet Принятый пакет для обработки
+ * true если запрос поставлен в очередь, false если пакет невалиден или очередь переполнена
  * 
- * Выполняет следующие действия:
- * 1. Проверяет валидность пакета и наличие имени функции
- * 2. Ищет зарегистрированный обработчик по имени функции
- * 3. Если обработчик не найден - отправляет ошибку
- * 4. Если найден - выполняет его и отправляет результат
+ * Вызывается из контекста парсера - копирует полезные данные в свободный слот
+ *       пула (единственная копия) и передает задаче сервиса только его индекс;
+ *       не ждет освобождения слота, чтобы не задерживать прием байтов
+ * Выполнение handler'а и отправка ответа происходят в process()
+ */
+
+bool Service::handle_packet(const protocol::Packet& packet) {
+    if (!packet.valid || packet.data_length > protocol::Packet::MaxSize) {     // Игнорирование невалидных пакетов
+        return false;
+    }
+    std::uint8_t index = m_requests.acquire();
+    if (index == m_requests.None) {
+        return false;                                                           // Все слоты заняты - запрос отбрасывается
+    }
+    Request& request = m_requests[index];
+    request.kind = RequestKind::Call;
+    request.seq = packet.seq;
+    request.crc = packet.crc;
+    request.encoding = packet.encoding;
+    request.length = packet.data_length;
+    std::memcpy(request.data, packet.data, packet.data_length);
+    xQueueSend(m_request_queue, &index, 0);                                     // Место в очереди есть всегда - слотов столько же
+    return true;
+}
+
+/**
+ * Ожидание и обработка входящих запросов
+ * timeout Максимальное время ожидания первого запроса в тиках FreeRTOS
+ * 
+ * Блокирует задачу сервиса на очереди до прихода запроса, затем выполняет
+ *       все накопившиеся запросы без повторной блокировки
+ * Задержка обработки не зависит от configTICK_RATE_HZ - задача просыпается
+ *       сразу по приходу запроса, а не по таймеру
+ */
+
+void Service::process(TickType_t timeout) {
+    std::uint8_t index = 0;
+    if (xQueueReceive(m_request_queue, &index, timeout) != pdPASS) {
+        return;                                                 // Таймаут - запросов нет
+    }
+    do {
+        const Request& request = m_requests[index];             // Запрос обрабатывается на месте, без копирования
+        if (request.kind == RequestKind::Completion) {
+            complete_deferred(request.slot, request.generation, request.data, request.length);
+        } else {
+            dispatch(request);
+        }
+        m_requests.release(index);
+    } while (xQueueReceive(m_request_queue, &index, 0) == pdPASS);
+}
+
+/**
+ * Выполнение RPC запроса
+ * request Запрос из входящей очереди
  * 
- * Вызывается из контекста парсера - должен быть быстрым
+ * Выполняет следующие действия:
+ * 1. Извлекает адресата из полезных данных (type | seq | name\0 | signature | args...
+ *    или type | seq | \0 | id | signature | args... для функций из IDL)
+ * 2. Ищет зарегистрированный обработчик по имени функции или идентификатору
+ * 3. Если обработчик не найден или отпечаток сигнатуры не совпадает - отправляет ошибку
+ * 4. Иначе выполняет его и отправляет результат
+ * Пакетные запросы (MessageType::BatchRequest) передаются в dispatch_batch
+ * Nack на поврежденный ответ повторяет его из окна ответов (resend)
+ * Stream-сообщения односторонние: handler выполняется, ответ и ошибка не отправляются
+ * Ответ кодируется так же, как запрос; Compact-запрос при RPC_ENABLE_COMPACT=0
+ *       получает ErrorCode::BadArguments без вызова handler'а
  */
 
-void Service::handle_packet(const protocol::Packet& packet) {
-    if (!packet.valid || packet.func_name.empty()) {            // Проверка валидности пакета и наличия имени функции
-        return;                                                 // Игнорирование невалидных пакетов
+void Service::dispatch(const Request& request) {
+    if (request.length > 0 && request.data[0] == static_cast<std::uint8_t>(MessageType::Nack)) {
+        resend(request.seq);
+        return;
+    }
+    if (!CompactEnabled && request.encoding == Encoding::Compact) {
+        if (request.data[0] != static_cast<std::uint8_t>(MessageType::Stream)) {
+            xSemaphoreTake(m_tx_mutex, portMAX_DELAY);          // Аргументы в этой сборке не разобрать
+            send_error(request.seq, ErrorCode::BadArguments);
+            xSemaphoreGive(m_tx_mutex);
+        }
+        return;
+    }
+    if (request.length > 0 && request.data[0] == static_cast<std::uint8_t>(MessageType::BatchRequest)) {
+        dispatch_batch(request);
+        return;
+    }
+    std::size_t target_length = 0;
+    auto it = find_handler(request.data + 2, request.length > 2 ? request.length - 2 : 0, target_length);
+    if (target_length == 0) {                                   // Нет имени функции или нет null terminator
+        return;
+    }
+    std::size_t signature_offset = target_length + 2;           // type + seq + name\0 или \0 | id
+    std::size_t header_length = signature_offset + SignatureSize;
+    if (request.length < header_length) {                       // Нет отпечатка сигнатуры
+        return;
+    }
+    bool one_way = request.data[0] == static_cast<std::uint8_t>(MessageType::Stream);
+
+    if (replay(request.seq, request.crc)) {                     // Повтор уже выполненного или выполняющегося запроса
+        return;
     }
 
-    auto it = m_handlers.find(packet.func_name);                // Поиск зарегистрированного обработчика по имени функции
     if (it == m_handlers.end()) {
-        protocol::Packet error_packet;                          // Обработчик не найден - отправка сообщения об ошибке
-        error_packet.valid = true;
-        error_packet.seq = packet.seq;                          // Сохранение порядкового номера запроса
-        error_packet.type = MessageType::Error;
-        error_packet.func_name = packet.func_name;
-        error_packet.data[0] = static_cast<std::uint8_t>(MessageType::Error);
-        error_packet.data_length = 1;
-
-        protocol::Sender sender(m_parser.get_uart());           // Отправка ошибки через транспортный протокол
-        sender.send_transport(error_packet.data, error_packet.data_length, error_packet.seq, error_packet.type);
+        if (one_way) {
+            return;
+        }
+        xSemaphoreTake(m_tx_mutex, portMAX_DELAY);              // Обработчик не найден - отправка сообщения об ошибке
+        send_error(request.seq, ErrorCode::UnknownFunction);
+        xSemaphoreGive(m_tx_mutex);
+        return;
+    }
+    if (!signature_matches(request.data + signature_offset, it->second.signature)) {
+        if (one_way) {
+            return;
+        }
+        xSemaphoreTake(m_tx_mutex, portMAX_DELAY);              // Клиент собран с другими типами функции
+        send_error(request.seq, ErrorCode::SignatureMismatch);
+        xSemaphoreGive(m_tx_mutex);
         return;
     }
 
     // Обработчик найден - выполнение RPC функции
+    const std::string& reply_name = request.data[2] == '\0' ? NoName : it->first;     // Ответ на вызов по идентификатору - без имени
     std::uint8_t response[protocol::Packet::MaxSize];           // Буфер для результата
     std::size_t response_length = 0;
-    // Вызов зарегистрированного обработчика
-    // Аргументы начинаются после имени функции + 2 байта (тип и seq)
-    it->second(packet.data + packet.func_name.size() + 2, packet.data_length - (packet.func_name.size() + 2), response, &response_length);
-
-    protocol::Packet response_packet;                           // Формирование пакета ответа
-    response_packet.valid = true;
-    response_packet.seq = packet.seq;                           // Тот же порядковый номер, что в запросе
-    response_packet.type = MessageType::Response;
-    response_packet.func_name = packet.func_name;
-    response_packet.data_length = response_length + packet.func_name.size() + 2;
-
-    // Заполнение данных ответа
-    response_packet.data[0] = static_cast<std::uint8_t>(MessageType::Response);                     // Тип ответа
-    response_packet.data[1] = packet.seq;                                                           // Порядковый номер
-    std::memcpy(response_packet.data + 2, packet.func_name.c_str(), packet.func_name.size() + 1);   // Имя функции с null terminator
-    std::memcpy(response_packet.data + packet.func_name.size() + 2, response, response_length);     // Результат выполнения
-
-    // Отправка ответа через транспортный протокол
+    m_current_seq = request.seq;                                // Контекст для отложенных handlers
+    m_current_crc = request.crc;
+    m_current_name = &reply_name;
+    m_current_encoding = request.encoding;
+    HandlerStatus status = execute(it->second, request.data + header_length, request.length - header_length,
+                                   request.encoding, response, &response_length);
+    if (status == HandlerStatus::Deferred || one_way) {
+        return;                                                 // Ответ будет отправлен по токену Deferred или не нужен
+    }
+
+    xSemaphoreTake(m_tx_mutex, portMAX_DELAY);
+    if (status == HandlerStatus::Done) {
+        send_response(request.seq, request.crc, reply_name, response, response_length, it->second.max_age_ms,
+                      request.encoding);
+    } else {
+        send_error(request.seq, reason_of(status));
+    }
+    xSemaphoreGive(m_tx_mutex);
+}
+
+/**
+ * Выполнение пакетного запроса
+ * request Запрос из входящей очереди
+ *
+ * Формат запроса:  BatchRequest | seq | count | (name\0 | signature | args_length | args...) x count
+ *       (функция из IDL - \0 | id вместо name\0)
+ * Формат ответа:   BatchResponse | seq | count | (status | result_length | result...) x count
+ * status - MessageType::Response при успехе или MessageType::Error
+ *
+ * Вызовы выполняются по порядку, результаты собираются в один ответный пакет
+ * Отложенные handlers в пакете не поддерживаются и возвращают ошибку
+ * Результат ошибочного вызова - один байт причины (ErrorCode)
+ * Все вызовы пакета кодируются так же, как пакетный запрос (флаг CompactFlag)
+ */
+
+void Service::dispatch_batch(const Request& request) {
+    if (request.length < 3 || request.data[2] > MaxBatchCalls) {
+        return;                                                 // Поврежденный заголовок пакетного запроса
+    }
+    if (replay(request.seq, request.crc)) {                     // Повтор уже выполненного пакета
+        return;
+    }
+
+    std::uint8_t response[protocol::Packet::MaxSize];
+    std::size_t response_length = 3;
+    std::uint8_t count = request.data[2];
+    response[0] = static_cast<std::uint8_t>(MessageType::BatchResponse);
+    if (request.encoding == Encoding::Compact) {
+        response[0] |= CompactFlag;
+    }
+    response[1] = request.seq;
+    response[2] = count;
+
+    std::size_t offset = 3;
+    for (std::uint8_t i = 0; i < count; ++i) {
+        std::size_t target_length = 0;
+        auto it = find_handler(request.data + offset, offset < request.length ? request.length - offset : 0, target_length);
+        if (target_length == 0) {
+            return;                                             // Поврежденный пакет - клиент получит таймаут
+        }
+        offset += target_length;
+        const std::uint8_t* signature = request.data + offset;
+        offset += SignatureSize;
+        if (offset >= request.length || offset + 1 + request.data[offset] > request.length) {
+            return;
+        }
+        std::size_t args_length = request.data[offset];
+        const std::uint8_t* args = request.data + offset + 1;
+        offset += 1 + args_length;
+
+        if (response_length + 3 > protocol::Packet::MaxSize) {   // Не помещается даже ошибка: status | 1 | reason
+            response[2] = i;                                    // Остальные результаты не помещаются в ответный пакет
+            break;
+        }
+        std::uint8_t result[protocol::Packet::MaxSize];
+        std::size_t result_length = 0;
+        HandlerStatus status = HandlerStatus::Rejected;     // Отложенные handlers в пакете не поддерживаются
+        ErrorCode reason = ErrorCode::UnknownFunction;
+        bool matches = it != m_handlers.end() && signature_matches(signature, it->second.signature);
+        if (matches && !it->second.deferred) {
+            m_current_seq = request.seq;
+            m_current_crc = request.crc;
+            m_current_name = &it->first;
+            m_current_encoding = request.encoding;
+            status = execute(it->second, args, args_length, request.encoding, result, &result_length);
+        }
+        if (it != m_handlers.end()) {
+            reason = matches ? reason_of(status) : ErrorCode::SignatureMismatch;
+        }
+        if (status == HandlerStatus::Done && response_length + 2 + result_length > protocol::Packet::MaxSize) {
+            status = HandlerStatus::ResultTooLarge;
+            reason = ErrorCode::ResultTooLarge;
+        }
+        bool ok = it != m_handlers.end() && status == HandlerStatus::Done;
+        if (!ok) {
+            result[0] = static_cast<std::uint8_t>(reason);      // Результат ошибки - один байт причины
+            result_length = 1;
+        }
+        response[response_length++] = static_cast<std::uint8_t>(ok ? MessageType::Response : MessageType::Error);
+        response[response_length++] = static_cast<std::uint8_t>(result_length);
+        std::memcpy(response + response_length, result, result_length);
+        response_length += result_length;
+    }
+
+    xSemaphoreTake(m_tx_mutex, portMAX_DELAY);
+    send_reply(request.seq, request.crc, MessageType::BatchResponse, response, response_length);
+    xSemaphoreGive(m_tx_mutex);
+}
+
+// Привязка идентификатора функции из IDL к handler'у, только что зарегистрированному по имени
+bool Service::register_id(const MethodId& method) {
+    auto it = m_handlers.find(method.name);
+    if (it == m_handlers.end()) {
+        return false;
+    }
+    m_ids[method.id] = it;                                      // Итераторы std::map не меняются при добавлении handlers
+    return true;
+}
+
+/**
+ * Поиск handler'а по полю адресата запроса
+ * field, available Поле адресата и число байт до конца запроса
+ * field_length Выходной параметр - длина поля (0 - нет null terminator)
+ * Handler или m_handlers.end(), если функция не зарегистрирована
+ *
+ * \0 | id (пустое имя и идентификатор) - вызов функции из IDL: поиск по
+ *       16-битному ключу без построения строки; пустое имя без идентификатора
+ *       (короткий запрос) ищется как обычное имя и не находится
+ */
+
+Service::HandlerMap::iterator Service::find_handler(const std::uint8_t* field, std::size_t available, std::size_t& field_length) {
+    field_length = 0;
+    if (available >= Target::IdSize && field[0] == '\0') {
+        std::uint16_t id;
+        load_le(field + 1, id);
+        field_length = Target::IdSize;
+        auto found = m_ids.find(id);
+        return found != m_ids.end() ? found->second : m_handlers.end();
+    }
+    const void* terminator = available > 0 ? std::memchr(field, '\0', available) : nullptr;
+    if (terminator == nullptr) {
+        return m_handlers.end();
+    }
+    field_length = static_cast<std::size_t>(static_cast<const std::uint8_t*>(terminator) - field) + 1;
+    return m_handlers.find(std::string(reinterpret_cast<const char*>(field), field_length - 1));
+}
+
+/**
+ * Выполнение handler'а с учетом кэша результатов
+ * handler Зарегистрированный handler
+ * args, args_length Сериализованные аргументы
+ * encoding Кодирование аргументов и результата
+ * res, res_length Буфер и длина сериализованного результата
+ *
+ * Повтор вызова с теми же аргументами в пределах ttl получает сохраненный
+ *       результат без вызова handler'а (только в том же кодировании)
+ */
+
+Service::HandlerStatus Service::execute(Handler& handler, const std::uint8_t* args, std::size_t args_length,
+                                        Encoding encoding, std::uint8_t* res, std::size_t* res_length) {
+    CachedResult* cache = handler.cache.get();
+    TickType_t now = xTaskGetTickCount();
+    if (cache != nullptr && cache->valid && cache->encoding == encoding && cache->args_length == args_length
+        && (handler.ttl == portMAX_DELAY || now - cache->timestamp < handler.ttl)
+        && std::memcmp(cache->args, args, args_length) == 0) {
+        ++cache->stats.hits;                                    // Попадание в кэш - ответ без вызова handler'а
+        std::memcpy(res, cache->result, cache->result_length);
+        *res_length = cache->result_length;
+        return HandlerStatus::Done;
+    }
+
+    HandlerStatus status = handler.invoke(args, args_length, encoding, res, res_length);
+    if (cache != nullptr && status == HandlerStatus::Done) {
+        ++cache->stats.misses;                                  // Промах - сохранение результата для следующих вызовов
+        cache->valid = true;
+        cache->timestamp = now;
+        cache->encoding = encoding;
+        cache->args_length = args_length;
+        cache->result_length = *res_length;
+        std::memcpy(cache->args, args, args_length);
+        std::memcpy(cache->result, res, *res_length);
+    }
+    return status;
+}
+
+// Суммарная статистика кэша результатов по всем кэшируемым функциям
+CacheStats Service::cache_stats() const {
+    CacheStats total;
+    for (const auto& entry : m_handlers) {
+        if (entry.second.cache) {
+            total.hits += entry.second.cache->stats.hits;
+            total.misses += entry.second.cache->stats.misses;
+        }
+    }
+    return total;
+}
+
+// Статистика кэша результатов одной функции
+bool Service::cache_stats(const std::string& name, CacheStats& stats) const {
+    auto it = m_handlers.find(name);
+    if (it == m_handlers.end() || !it->second.cache) {
+        return false;
+    }
+    stats = it->second.cache->stats;
+    return true;
+}
+
+/**
+ * Сообщение об изменении значения функции
+ * name Имя функции, результат которой изменился
+ * false если функция не зарегистрирована или сообщение не отправлено
+ *
+ * Отправляет Invalidate | 0 | name\0: клиенты удаляют из кэша все результаты
+ *       этой функции и следующий вызов идет на устройство; сохраненный
+ *       результат в кэше сервиса тоже сбрасывается
+ * Вызывается из задачи, в которой изменилось значение (не из прерывания)
+ */
+
+bool Service::invalidate(const std::string& name) {
+    auto it = m_handlers.find(name);
+    if (it == m_handlers.end() || name.size() + 3 > protocol::Packet::MaxSize) {
+        return false;
+    }
+    std::uint8_t data[protocol::Packet::MaxSize];
+    data[0] = static_cast<std::uint8_t>(MessageType::Invalidate);
+    data[1] = 0;                                                                // Не ответ на запрос - seq не используется
+    std::memcpy(data + 2, name.c_str(), name.size() + 1);
+    xSemaphoreTake(m_tx_mutex, portMAX_DELAY);
+    if (it->second.cache) {
+        it->second.cache->valid = false;
+    }
     protocol::Sender sender(m_parser.get_uart());
-    sender.send_transport(response_packet.data, response_packet.data_length, response_packet.seq, response_packet.type);
+    bool sent = sender.send_transport(data, name.size() + 3, 0, MessageType::Invalidate);
+    xSemaphoreGive(m_tx_mutex);
+    return sent;
+}
+
+/**
+ * Занятие слота отложенного вызова под текущий запрос
+ * Индекс слота или -1, если достигнут лимит MaxDeferredCalls
+ *
+ * Вызывается из dispatch - использует m_current_seq, m_current_name и m_current_encoding
+ */
+
+int Service::acquire_deferred() {
+    int result = -1;
+    xSemaphoreTake(m_tx_mutex, portMAX_DELAY);
+    for (std::size_t i = 0; i < MaxDeferredCalls; ++i) {
+        DeferredCall& call = m_deferred[i];
+        if (!call.active) {
+            call.active = true;
+            ++call.generation;                                  // Токены прошлых вызовов в этом слоте становятся недействительными
+            call.seq = m_current_seq;
+            call.request_crc = m_current_crc;
+            call.name = m_current_name;
+            call.encoding = m_current_encoding;
+            result = static_cast<int>(i);
+            break;
+        }
+    }
+    xSemaphoreGive(m_tx_mutex);
+    return result;
+}
+
+// Освобождение слота отложенного вызова / true если токен был актуален
+bool Service::release_deferred(std::uint8_t slot, std::uint8_t generation) {
+    xSemaphoreTake(m_tx_mutex, portMAX_DELAY);
+    bool released = slot < MaxDeferredCalls && m_deferred[slot].active && m_deferred[slot].generation == generation;
+    if (released) {
+        m_deferred[slot].active = false;
+    }
+    xSemaphoreGive(m_tx_mutex);
+    return released;
+}
+
+/**
+ * Завершение отложенного вызова
+ * slot, generation Идентификатор вызова из токена Deferred
+ * result, length Сериализованный результат
+ * true если ответ отправлен, false если токен устарел (вызов уже завершен)
+ *
+ * Может вызываться из любой задачи - отправка и освобождение слота под мьютексом
+ */
+
+bool Service::complete_deferred(std::uint8_t slot, std::uint8_t generation, const std::uint8_t* result, std::size_t length) {
+    xSemaphoreTake(m_tx_mutex, portMAX_DELAY);
+    DeferredCall* call = slot < MaxDeferredCalls ? &m_deferred[slot] : nullptr;
+    bool completed = call != nullptr && call->active && call->generation == generation;
+    if (completed) {
+        send_response(call->seq, call->request_crc, *call->name, result, length, 0, call->encoding);
+        call->active = false;
+    }
+    xSemaphoreGive(m_tx_mutex);
+    return completed;
+}
+
+/**
+ * Завершение отложенного вызова из прерывания
+ * 
+ * Мьютекс и UART нельзя использовать в прерывании, поэтому результат
+ *       ставится во входящую очередь, а ответ отправляет задача сервиса
+ */
+
+bool Service::complete_deferred_from_isr(std::uint8_t slot, std::uint8_t generation, const std::uint8_t* result,
+                                         std::size_t length, BaseType_t* higher_priority_task_woken) {
+    if (length > protocol::Packet::MaxSize) {
+        return false;
+    }
+    std::uint8_t index = m_requests.acquire_from_isr(higher_priority_task_woken);
+    if (index == m_requests.None) {
+        return false;
+    }
+    Request& request = m_requests[index];
+    request.kind = RequestKind::Completion;
+    request.seq = 0;
+    request.crc = 0;
+    request.slot = slot;
+    request.generation = generation;
+    request.length = length;
+    std::memcpy(request.data, result, length);
+    return xQueueSendFromISR(m_request_queue, &index, higher_priority_task_woken) == pdPASS;
+}
+
+/**
+ * Ответ на повторный запрос из окна сохраненных ответов
+ * seq Порядковый номер запроса
+ * request_crc CRC данных запроса
+ * true если запрос уже обработан (ответ отправлен повторно) или еще выполняется
+ *
+ * Клиент повторяет запрос с тем же seq, если ответ потерялся; совпадение
+ *       CRC отличает повтор от нового запроса после переполнения seq
+ */
+
+bool Service::replay(std::uint8_t seq, std::uint8_t request_crc) {
+    bool duplicate = false;
+    xSemaphoreTake(m_tx_mutex, portMAX_DELAY);
+    for (const DeferredCall& call : m_deferred) {                               // Отложенный вызов еще выполняется - ответ придет сам
+        if (call.active && call.seq == seq && call.request_crc == request_crc) {
+            duplicate = true;
+        }
+    }
+    for (std::size_t i = 0; i < ReplayWindowSize && !duplicate; ++i) {
+        const ReplayEntry& entry = m_replay[i];
+        if (entry.valid && entry.seq == seq && entry.request_crc == request_crc) {
+            protocol::Sender sender(m_parser.get_uart());                       // Повторная отправка без выполнения handler'а
+            sender.send_transport(entry.data, entry.length, seq, entry.type);
+            duplicate = true;
+        }
+    }
+    xSemaphoreGive(m_tx_mutex);
+    return duplicate;
 }
 
 /**
- * Основной цикл обработки сервиса
- * В текущей реализации не выполняет действий
- * Может быть использован для фоновой обработки или чистки ресурсов
+ * Повторная отправка ответа по Nack
+ * seq Порядковый номер из Nack (номер поврежденного ответа)
+ * true если ответ найден в окне и отправлен повторно
+ *
+ * Окно просматривается от последнего ответа к первому: при переполнении seq
+ *       в окне может остаться и старый ответ с тем же номером
+ * Сообщения об ошибке в окне не хранятся - их потерю клиент покрывает таймаутом
  */
 
-void Service::process() {
-    // Реализация метода process (если требуется)
-    // Может использоваться для:
-    // - Очистки устаревших соединений
-    // - Фоновых задач обслуживания
-    // - Мониторинга состояния сервис
+bool Service::resend(std::uint8_t seq) {
+    bool sent = false;
+    xSemaphoreTake(m_tx_mutex, portMAX_DELAY);
+    for (std::size_t i = 1; i <= ReplayWindowSize; ++i) {
+        const ReplayEntry& entry = m_replay[(m_replay_next + ReplayWindowSize - i) % ReplayWindowSize];
+        if (entry.valid && entry.seq == seq) {
+            protocol::Sender sender(m_parser.get_uart());
+            sent = sender.send_transport(entry.data, entry.length, seq, entry.type);
+            break;
+        }
+    }
+    xSemaphoreGive(m_tx_mutex);
+    return sent;
+}
+
+// Формирование и отправка ответа: type | seq | name\0 | result... (CachedResponse: name\0 | max_age_ms | result...)
+void Service::send_response(std::uint8_t seq, std::uint8_t request_crc, const std::string& name,
+                            const std::uint8_t* result, std::size_t length, std::uint16_t max_age_ms,
+                            Encoding encoding) {
+    std::uint8_t data[protocol::Packet::MaxSize];
+    MessageType type = max_age_ms != 0 ? MessageType::CachedResponse : MessageType::Response;
+    std::size_t header_length = name.size() + 3;                                // type + seq + name + null terminator
+    if (type == MessageType::CachedResponse) {
+        header_length += sizeof(max_age_ms);                                    // Срок кэширования перед результатом
+    }
+    if (header_length + length > protocol::Packet::MaxSize) {                   // Ответ не помещается в пакет
+        send_error(seq, ErrorCode::ResultTooLarge);
+        return;
+    }
+    data[0] = static_cast<std::uint8_t>(type);                                  // Тип ответа
+    if (encoding == Encoding::Compact) {
+        data[0] |= CompactFlag;                                                 // Результат в varint - как аргументы запроса
+    }
+    data[1] = seq;                                                              // Тот же порядковый номер, что в запросе
+    std::memcpy(data + 2, name.c_str(), name.size() + 1);                       // Имя функции с null terminator
+    if (type == MessageType::CachedResponse) {
+        data[name.size() + 3] = max_age_ms & 0xFF;                              // Little-endian, как длина кадра
+        data[name.size() + 4] = max_age_ms >> 8;
+    }
+    std::memcpy(data + header_length, result, length);                          // Результат выполнения
+    send_reply(seq, request_crc, type, data, header_length + length);
+}
+
+// Сохранение ответа в окне повторов и отправка через транспортный протокол
+void Service::send_reply(std::uint8_t seq, std::uint8_t request_crc, MessageType type,
+                         const std::uint8_t* data, std::size_t length) {
+    ReplayEntry& entry = m_replay[m_replay_next];
+    m_replay_next = (m_replay_next + 1) % ReplayWindowSize;
+    entry.valid = true;
+    entry.seq = seq;
+    entry.request_crc = request_crc;
+    entry.type = type;
+    entry.length = length;
+    std::memcpy(entry.data, data, length);
+
+    protocol::Sender sender(m_parser.get_uart());
+    sender.send_transport(entry.data, entry.length, seq, type);
+}
+
+// Отправка сообщения об ошибке выполнения запроса
+void Service::send_error(std::uint8_t seq, ErrorCode reason) {
+    std::uint8_t error[3] = {static_cast<std::uint8_t>(MessageType::Error), seq,     // type | seq - как у любого сообщения
+                             static_cast<std::uint8_t>(reason)};
+    protocol::Sender sender(m_parser.get_uart());
+    sender.send_transport(error, sizeof(error), seq, MessageType::Error);
+}
+
+ErrorCode Service::reason_of(HandlerStatus status) {
+    switch (status) {
+        case HandlerStatus::BadArguments:
+            return ErrorCode::BadArguments;
+        case HandlerStatus::ResultTooLarge:
+            return ErrorCode::ResultTooLarge;
+        case HandlerStatus::Busy:
+            return ErrorCode::Busy;
+        case HandlerStatus::Rejected:
+            return ErrorCode::Rejected;
+        default:
+            return ErrorCode::Unknown;
+    }
 }
 
 } // namespace rpc
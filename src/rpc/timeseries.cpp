@@ -0,0 +1,173 @@
+#include "../../include/rpc/timeseries.hpp"
+
+namespace rpc {
+
+namespace {
+
+// Диапазоны разности разностей: префикс из ones единиц и нуля, затем bits бит
+struct DeltaBucket {
+    unsigned ones;                      // Единиц в префиксе
+    unsigned bits;                      // Бит значения
+};
+constexpr DeltaBucket DeltaBuckets[] = {{1, 7}, {2, 9}, {3, 12}};
+
+} // namespace
+
+/**
+ * Добавление выборки в блок
+ * timestamp Отметка времени, мс (счетчик может переполняться)
+ * value Значение
+ * false если выборка не помещается в блок - состояние кодировщика не меняется
+ *
+ * Выборка пишется целиком или не пишется: при нехватке места поток бит
+ *       и окно XOR возвращаются к состоянию до вызова
+ */
+
+bool TimeSeriesEncoder::append(std::uint32_t timestamp, float value) {
+    if (m_count >= MaxSamples) {
+        return false;
+    }
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    std::size_t position = m_writer.bits();
+    std::int32_t delta = m_delta;
+    unsigned leading = m_leading;
+    unsigned trailing = m_trailing;
+    bool written = m_count == 0 ? m_writer.write(timestamp, 32) && m_writer.write(bits, 32)
+                                : write_timestamp(timestamp) && write_value(bits);
+    if (!written) {
+        m_writer.rewind(position);                              // Выборка не поместилась целиком
+        m_delta = delta;
+        m_leading = leading;
+        m_trailing = trailing;
+        return false;
+    }
+    m_timestamp = timestamp;
+    m_value = bits;
+    ++m_count;
+    return true;
+}
+
+void TimeSeriesEncoder::reset() {
+    m_writer.rewind(0);
+    m_count = 0;
+    m_delta = 0;
+    m_leading = 32;
+    m_trailing = 0;
+}
+
+// Разность разностей в наименьшем подходящем диапазоне; вне диапазонов - сама разность
+bool TimeSeriesEncoder::write_timestamp(std::uint32_t timestamp) {
+    auto delta = static_cast<std::int32_t>(timestamp - m_timestamp);   // Переполнение счетчика мс допустимо
+    std::int64_t dod = static_cast<std::int64_t>(delta) - m_delta;
+    m_delta = delta;
+    if (dod == 0) {
+        return m_writer.write(0, 1);
+    }
+    for (const DeltaBucket& bucket : DeltaBuckets) {
+        std::int64_t limit = std::int64_t{1} << (bucket.bits - 1);
+        if (dod >= -limit && dod < limit) {
+            std::uint32_t prefix = ((1u << bucket.ones) - 1) << 1;      // ones единиц и ноль
+            return m_writer.write(prefix, bucket.ones + 1)
+                && m_writer.write(static_cast<std::uint32_t>(dod) & ((1u << bucket.bits) - 1), bucket.bits);
+        }
+    }
+    return m_writer.write(0xF, 4) && m_writer.write(static_cast<std::uint32_t>(delta), 32);
+}
+
+// XOR с предыдущим значением: повтор, биты в прежнем окне или новое окно
+bool TimeSeriesEncoder::write_value(std::uint32_t bits) {
+    std::uint32_t x = bits ^ m_value;
+    if (x == 0) {
+        return m_writer.write(0, 1);
+    }
+    auto leading = static_cast<unsigned>(__builtin_clz(x));
+    auto trailing = static_cast<unsigned>(__builtin_ctz(x));
+    if (leading >= m_leading && trailing >= m_trailing) {      // Без окна m_leading = 32 - условие ложно
+        unsigned length = 32 - m_leading - m_trailing;          // Значащие биты в окне предыдущего XOR
+        return m_writer.write(0x2, 2) && m_writer.write(x >> m_trailing, length);
+    }
+    unsigned length = 32 - leading - trailing;
+    m_leading = leading;
+    m_trailing = trailing;
+    return m_writer.write(0x3, 2) && m_writer.write(leading, 5) && m_writer.write(length - 1, 5)
+        && m_writer.write(x >> trailing, length);
+}
+
+/**
+ * Чтение следующей выборки блока
+ * sample Выходной параметр - выборка
+ * false в конце блока или на поврежденном потоке (дальнейшие чтения тоже false)
+ */
+
+bool TimeSeriesDecoder::next(Sample& sample) {
+    if (m_index >= m_count) {
+        return false;
+    }
+    bool ok = m_index == 0 ? m_reader.read(32, m_timestamp) && m_reader.read(32, m_value)
+                           : read_timestamp(m_timestamp) && read_value(m_value);
+    if (!ok) {
+        m_count = m_index;                                      // Поврежденный блок: дальше не читается
+        return false;
+    }
+    sample.timestamp = m_timestamp;
+    std::memcpy(&sample.value, &m_value, sizeof(sample.value));
+    ++m_index;
+    return true;
+}
+
+bool TimeSeriesDecoder::read_timestamp(std::uint32_t& timestamp) {
+    unsigned ones = 0;
+    if (!m_reader.read_prefix(4, ones)) {
+        return false;
+    }
+    std::uint32_t raw = 0;
+    if (ones == 4) {
+        if (!m_reader.read(32, raw)) {
+            return false;
+        }
+        m_delta = static_cast<std::int32_t>(raw);
+    } else if (ones > 0) {
+        const DeltaBucket& bucket = DeltaBuckets[ones - 1];
+        if (!m_reader.read(bucket.bits, raw)) {
+            return false;
+        }
+        std::uint32_t sign = 1u << (bucket.bits - 1);
+        auto dod = static_cast<std::int32_t>((raw ^ sign) - sign);     // Расширение знака
+        m_delta = static_cast<std::int32_t>(static_cast<std::uint32_t>(m_delta) + static_cast<std::uint32_t>(dod));
+    }
+    timestamp += static_cast<std::uint32_t>(m_delta);
+    return true;
+}
+
+bool TimeSeriesDecoder::read_value(std::uint32_t& bits) {
+    std::uint32_t control = 0;
+    if (!m_reader.read(1, control)) {
+        return false;
+    }
+    if (control == 0) {
+        return true;                                            // Повтор значения
+    }
+    if (!m_reader.read(1, control)) {
+        return false;
+    }
+    if (control == 1) {
+        std::uint32_t leading = 0;
+        std::uint32_t length = 0;
+        if (!m_reader.read(5, leading) || !m_reader.read(5, length) || leading + length + 1 > 32) {
+            return false;
+        }
+        m_leading = leading;
+        m_trailing = 32 - leading - (length + 1);
+    } else if (m_leading + m_trailing >= 32) {
+        return false;                                           // Окна предыдущего XOR нет
+    }
+    std::uint32_t x = 0;
+    if (!m_reader.read(32 - m_leading - m_trailing, x)) {
+        return false;
+    }
+    bits ^= x << m_trailing;
+    return true;
+}
+
+} // namespace rpc